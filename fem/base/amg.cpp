@@ -0,0 +1,355 @@
+#include "amg.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /** @brief remove explicit zeros, e.g. the eliminated entries of constrained rows */
+    inline void DropZeros(SparseMatrix &A)
+    {
+        A.prune([](const Eigen::Index &, const Eigen::Index &, const double &v) { return v != 0.0; });
+    }
+}
+
+void AMG::Update(const SparseMatrix &A)
+{
+    if (levels.empty() || A.nonZeros() != pattern_nnz || A.rows() != levels[0].A.rows())
+    {
+        pattern_nnz = static_cast<int>(A.nonZeros());
+        setup_values = A.coeffs();
+        levels.assign(1, Level());
+        levels[0].A = A;
+        DropZeros(levels[0].A);
+        // the next level is aggregated from the galerkin operator of the current one
+        while (Aggregate(NumLevels() - 1)) { Galerkin(NumLevels() - 2); }
+        FactorizeCoarse();
+        DEBUG("amg hierarchy of %d levels, coarsest %d rows, operator complexity %.2f",
+              NumLevels(), static_cast<int>(levels.back().A.rows()), OperatorComplexity());
+        return;
+    }
+
+    const double change = (A.coeffs().matrix() - setup_values).norm() / setup_values.norm();
+    if (change <= rebuild_tol) { return; }
+    setup_values = A.coeffs();
+    levels[0].A = A;
+    DropZeros(levels[0].A);
+    Numeric();
+}
+
+void AMG::Apply(const Eigen::VectorXd &r, Eigen::VectorXd &z) const
+{
+    levels[0].work.b = r;
+    VCycle<double>(0);
+    z = levels[0].work.x;
+}
+
+void AMG::Apply(const Eigen::VectorXf &r, Eigen::VectorXf &z) const
+{
+    Assert(single, "single precision v-cycle without the single precision hierarchy");
+    levels[0].work_single.b = r;
+    VCycle<float>(0);
+    z = levels[0].work_single.x;
+}
+
+void AMG::SetSinglePrecision(const bool &single)
+{
+    if (single == this->single) { return; }
+    this->single = single;
+    // the next update recomputes the hierarchy with or without the copies
+    pattern_nnz = -1;
+}
+
+double AMG::OperatorComplexity() const
+{
+    double nnz = 0.0;
+    for (const Level &level : levels) { nnz += level.A.nonZeros(); }
+    return nnz / levels[0].A.nonZeros();
+}
+
+void AMG::Clear()
+{
+    levels.clear();
+    levels.shrink_to_fit();
+    setup_values.resize(0);
+    pattern_nnz = -1;
+}
+
+std::size_t AMG::MemoryBytes() const
+{
+    std::size_t bytes = Bytes(setup_values) + FactorBytes(coarse);
+    for (const Level &level : levels)
+    {
+        bytes += Bytes(level.A) + level.A_sell.MemoryBytes() + Bytes(level.aggregate) + level.P.MemoryBytes() + level.R.MemoryBytes();
+        bytes += Bytes(level.work.inv_diag) + Bytes(level.work.x) + Bytes(level.work.b) + Bytes(level.work.r);
+        bytes += Bytes(level.work_single.inv_diag) + Bytes(level.work_single.x) + Bytes(level.work_single.b) + Bytes(level.work_single.r);
+    }
+    return bytes;
+}
+
+bool AMG::Aggregate(const int &l)
+{
+    const SparseMatrix &A = levels[l].A;
+    const int n = static_cast<int>(A.rows());
+    if (n <= max_coarse || NumLevels() >= max_levels) { return false; }
+
+    // strong connections.  A is symmetric, so column i holds the connections of row i
+    const Eigen::VectorXd diag = A.diagonal();
+    std::vector<int> strong_ptr(n + 1, 0);
+    auto strong = [&](const int &i, const int &j, const double &a)
+    {
+        return i != j && std::abs(a) > strength_threshold*std::sqrt(std::abs(diag(i)*diag(j)));
+    };
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        for (SparseMatrix::InnerIterator it(A, i); it; ++it) { strong_ptr[i + 1] += strong(i, it.row(), it.value()); }
+    }
+    for (int i = 0; i < n; i++) { strong_ptr[i + 1] += strong_ptr[i]; }
+    std::vector<int> strong_idx(strong_ptr[n]);
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        int k = strong_ptr[i];
+        for (SparseMatrix::InnerIterator it(A, i); it; ++it)
+        {
+            if (strong(i, it.row(), it.value())) { strong_idx[k++] = it.row(); }
+        }
+    }
+
+    // greedy aggregation.  rows without strong connections are left out of the coarse levels and only smoothed
+    constexpr int free = -2;
+    std::vector<int> agg(n, free);
+    for (int i = 0; i < n; i++)
+    {
+        if (strong_ptr[i] == strong_ptr[i + 1]) { agg[i] = -1; }
+    }
+    int n_agg = 0;
+    // 1. a free row whose strong neighbours are all free starts an aggregate with them
+    for (int i = 0; i < n; i++)
+    {
+        if (agg[i] != free) { continue; }
+        bool all_free = true;
+        for (int k = strong_ptr[i]; k < strong_ptr[i + 1] && all_free; k++) { all_free = agg[strong_idx[k]] == free; }
+        if (!all_free) { continue; }
+        agg[i] = n_agg;
+        for (int k = strong_ptr[i]; k < strong_ptr[i + 1]; k++) { agg[strong_idx[k]] = n_agg; }
+        n_agg++;
+    }
+    // 2. the remaining rows join an aggregate of the first pass they are strongly connected to
+    const std::vector<int> first_pass = agg;
+    for (int i = 0; i < n; i++)
+    {
+        if (agg[i] != free) { continue; }
+        for (int k = strong_ptr[i]; k < strong_ptr[i + 1]; k++)
+        {
+            if (first_pass[strong_idx[k]] >= 0)
+            {
+                agg[i] = first_pass[strong_idx[k]];
+                break;
+            }
+        }
+    }
+    // 3. whatever is left forms aggregates with its free neighbours
+    for (int i = 0; i < n; i++)
+    {
+        if (agg[i] != free) { continue; }
+        agg[i] = n_agg;
+        for (int k = strong_ptr[i]; k < strong_ptr[i + 1]; k++)
+        {
+            if (agg[strong_idx[k]] == free) { agg[strong_idx[k]] = n_agg; }
+        }
+        n_agg++;
+    }
+
+    if (n_agg == 0 || n_agg > 0.9*n) { return false; }
+    levels[l].aggregate = std::move(agg);
+    levels[l].n_aggregates = n_agg;
+    levels.emplace_back();
+    return true;
+}
+
+void AMG::Numeric()
+{
+    for (int l = 0; l < NumLevels() - 1; l++) { Galerkin(l); }
+    FactorizeCoarse();
+}
+
+void AMG::Galerkin(const int &l)
+{
+    Level &level = levels[l];
+    const int n = static_cast<int>(level.A.rows());
+    level.work.Resize(n);
+    level.work.inv_diag = level.A.diagonal().cwiseInverse();
+    level.A_sell.Assign(level.A);
+    level.omega = 4.0 / (3.0*SpectralRadius(level));
+
+    // tentative prolongation, constant over each aggregate and scaled to unit columns
+    const int n_agg = level.n_aggregates;
+    std::vector<int> size(n_agg, 0);
+    for (int i = 0; i < n; i++)
+    {
+        if (level.aggregate[i] >= 0) { size[level.aggregate[i]]++; }
+    }
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        const int a = level.aggregate[i];
+        if (a >= 0) { triplets.emplace_back(i, a, 1.0 / std::sqrt(size[a])); }
+    }
+    SparseMatrix P0(n, n_agg);
+    P0.setFromTriplets(triplets.begin(), triplets.end());
+
+    // smoothed prolongation P = (I - omega D^{-1} A) P0.  the pattern of A P0 contains the one of P0
+    SparseMatrix P = Multiply(level.A, P0);
+    #pragma omp parallel for
+    for (int j = 0; j < n_agg; j++)
+    {
+        const double p0 = 1.0 / std::sqrt(size[j]);
+        for (SparseMatrix::InnerIterator it(P, j); it; ++it)
+        {
+            const int i = static_cast<int>(it.row());
+            it.valueRef() = ((level.aggregate[i] == j) ? p0 : 0.0) - level.omega*level.work.inv_diag(i)*it.value();
+        }
+    }
+    DropZeros(P);
+    const SparseMatrix R = P.transpose();
+    levels[l + 1].A = Multiply(R, Multiply(level.A, P));
+    DropZeros(levels[l + 1].A);
+    level.P.Assign(P);
+    level.R.Assign(R);
+    if (single)
+    {
+        level.A_sell.EnableSingle();
+        level.P.EnableSingle();
+        level.R.EnableSingle();
+        level.work_single.Resize(n);
+        level.work_single.inv_diag = level.work.inv_diag.cast<float>();
+    }
+}
+
+void AMG::FactorizeCoarse()
+{
+    Level &level = levels.back();
+    const int n = static_cast<int>(level.A.rows());
+    level.work.Resize(n);
+    if (single) { level.work_single.Resize(n); }
+    coarse.compute(level.A);
+    Assert(coarse.info() == Eigen::Success, "amg coarse level factorization failed");
+}
+
+double AMG::SpectralRadius(const Level &level)
+{
+    const int n = static_cast<int>(level.A.rows());
+    Eigen::VectorXd v(n), w(n);
+    for (int i = 0; i < n; i++) { v(i) = 1.0 + 0.1*(i % 7); }
+    v.normalize();
+    double rho = 1.0;
+    for (int it = 0; it < 15; it++)
+    {
+        level.A_sell.Multiply(v.data(), w.data());
+        w = w.cwiseProduct(level.work.inv_diag);
+        rho = w.norm();
+        v = w / rho;
+    }
+    return rho;
+}
+
+SparseMatrix AMG::Multiply(const SparseMatrix &A, const SparseMatrix &B)
+{
+    const int m = static_cast<int>(A.rows());
+    const int n = static_cast<int>(B.cols());
+
+    // symbolic pass, the nonzeros of every column of the product
+    std::vector<int> outer(n + 1, 0);
+    #pragma omp parallel
+    {
+        std::vector<int> marker(m, -1);
+        #pragma omp for schedule(dynamic, 64)
+        for (int j = 0; j < n; j++)
+        {
+            int count = 0;
+            for (SparseMatrix::InnerIterator itb(B, j); itb; ++itb)
+            {
+                for (SparseMatrix::InnerIterator ita(A, itb.row()); ita; ++ita)
+                {
+                    if (marker[ita.row()] != j)
+                    {
+                        marker[ita.row()] = j;
+                        count++;
+                    }
+                }
+            }
+            outer[j + 1] = count;
+        }
+    }
+    for (int j = 0; j < n; j++) { outer[j + 1] += outer[j]; }
+
+    // numeric pass, each column accumulated densely and stored with sorted rows
+    std::vector<int> inner(outer[n]);
+    std::vector<double> val(outer[n]);
+    #pragma omp parallel
+    {
+        std::vector<int> marker(m, -1);
+        std::vector<double> acc(m, 0.0);
+        #pragma omp for schedule(dynamic, 64)
+        for (int j = 0; j < n; j++)
+        {
+            int k = outer[j];
+            for (SparseMatrix::InnerIterator itb(B, j); itb; ++itb)
+            {
+                for (SparseMatrix::InnerIterator ita(A, itb.row()); ita; ++ita)
+                {
+                    const int i = static_cast<int>(ita.row());
+                    if (marker[i] != j)
+                    {
+                        marker[i] = j;
+                        acc[i] = 0.0;
+                        inner[k++] = i;
+                    }
+                    acc[i] += ita.value()*itb.value();
+                }
+            }
+            std::sort(inner.begin() + outer[j], inner.begin() + outer[j + 1]);
+            for (k = outer[j]; k < outer[j + 1]; k++) { val[k] = acc[inner[k]]; }
+        }
+    }
+    return Eigen::Map<const SparseMatrix>(m, n, outer[n], outer.data(), inner.data(), val.data());
+}
+
+template<typename Scalar>
+void AMG::VCycle(const int &l) const
+{
+    const Level &level = levels[l];
+    const Work<Scalar> &w = level.template GetWork<Scalar>();
+    if (l == NumLevels() - 1)
+    {
+        w.x = coarse.solve(w.b.template cast<double>()).template cast<Scalar>();
+        return;
+    }
+
+    // pre-smoothing from a zero guess
+    w.x = static_cast<Scalar>(level.omega)*w.inv_diag.cwiseProduct(w.b);
+    for (int k = 1; k < smoothing_steps; k++) { Smooth<Scalar>(level); }
+
+    // coarse correction
+    const Work<Scalar> &next = levels[l + 1].template GetWork<Scalar>();
+    level.A_sell.Multiply(w.x.data(), w.r.data());
+    w.r = w.b - w.r;
+    level.R.Multiply(w.r.data(), next.b.data());
+    VCycle<Scalar>(l + 1);
+    level.P.Multiply(next.x.data(), w.r.data());
+    w.x += w.r;
+
+    for (int k = 0; k < smoothing_steps; k++) { Smooth<Scalar>(level); }
+}
+
+template<typename Scalar>
+void AMG::Smooth(const Level &level) const
+{
+    const Work<Scalar> &w = level.template GetWork<Scalar>();
+    level.A_sell.Multiply(w.x.data(), w.r.data());
+    w.x += static_cast<Scalar>(level.omega)*w.inv_diag.cwiseProduct(w.b - w.r);
+}
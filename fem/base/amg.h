@@ -0,0 +1,138 @@
+#ifndef AMG_INCL
+#define AMG_INCL
+
+#include "sparse.h"
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Sparse>
+#include <eigen/Eigen/OrderingMethods>
+#include <eigen/Eigen/SparseCholesky>
+
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief smoothed aggregation algebraic multigrid for symmetric positive definite matrices, applied as a
+ * v-cycle preconditioner for cg.  each level groups strongly connected rows into aggregates, the
+ * piecewise constant prolongation over the aggregates is smoothed with one damped jacobi step and the
+ * coarse operator is the galerkin product P^T A P, down to a level small enough for a direct solve.  the
+ * products, smoothers and spectral estimates run in parallel, the aggregation is a greedy serial pass.
+ * the v-cycle uses damped jacobi smoothing on SellMatrix copies of the operators, so it is symmetric.
+ * in single precision mode the level operators and transfers also keep float values and the v-cycle can
+ * run in float, the coarse solve staying in double.
+ */
+class AMG
+{
+    public:
+        AMG() = default;
+
+        /**
+         * @brief build the hierarchy for A, or keep the one built for a previous matrix.  with the same
+         * pattern and a relative change of the values below the rebuild tolerance the hierarchy is reused
+         * as is.  a larger change keeps the aggregates and recomputes the prolongations and coarse
+         * operators.  a new pattern redoes the aggregation.
+         * @param A symmetric positive definite matrix
+         */
+        void Update(const SparseMatrix &A);
+
+        /**
+         * @brief apply one v-cycle, z ~ A^{-1} r with A the matrix of the hierarchy.  uses work vectors of
+         * the hierarchy, so it is not reentrant
+         * @param r residual
+         * @param z preconditioned residual
+         */
+        void Apply(const Eigen::VectorXd &r, Eigen::VectorXd &z) const;
+
+        /** @brief apply one v-cycle in single precision, needs the single precision mode */
+        void Apply(const Eigen::VectorXf &r, Eigen::VectorXf &z) const;
+
+        /** @brief keep single precision copies of the hierarchy, from the next Update that computes it */
+        void SetSinglePrecision(const bool &single);
+
+        inline int NumLevels() const { return static_cast<int>(levels.size()); }
+
+        /** @brief sum of the nonzeros of all level operators over the nonzeros of the finest */
+        double OperatorComplexity() const;
+
+        /** @brief drop the hierarchy, the next update builds it again */
+        void Clear();
+
+        /** @brief bytes held by the hierarchy: operators, their copies, transfers, v-cycle vectors and the coarse factorization */
+        std::size_t MemoryBytes() const;
+
+    private:
+        /** @brief smoother diagonal and v-cycle vectors of a level in one precision */
+        template<typename Scalar>
+        struct Work
+        {
+            typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 1> Vector;
+            Vector inv_diag;                /** @brief inverse diagonal of A */
+            mutable Vector x;               /** @brief v-cycle correction */
+            mutable Vector b;               /** @brief v-cycle right hand side */
+            mutable Vector r;               /** @brief v-cycle residual */
+
+            /** @brief size the vectors */
+            inline void Resize(const int &n) { x.resize(n); b.resize(n); r.resize(n); }
+        };
+
+        /** @brief one level of the hierarchy.  the prolongation maps from the next coarser level */
+        struct Level
+        {
+            SparseMatrix A;                 /** @brief level operator, without explicit zeros */
+            SellMatrix A_sell;              /** @brief copy of A for the smoother and residual products */
+            double omega = 1.0;             /** @brief jacobi damping, 4 / (3 rho(D^{-1} A)) */
+            std::vector<int> aggregate;     /** @brief aggregate of each row, -1 for rows without strong connections */
+            int n_aggregates = 0;           /** @brief number of aggregates, the size of the next level */
+            SellMatrix P;                   /** @brief smoothed prolongation */
+            SellMatrix R;                   /** @brief restriction, the transpose of P */
+            Work<double> work;              /** @brief double precision v-cycle */
+            Work<float> work_single;        /** @brief single precision v-cycle, empty unless enabled */
+
+            /** @brief the v-cycle vectors of a precision */
+            template<typename Scalar>
+            inline const Work<Scalar>& GetWork() const
+            {
+                if constexpr (std::is_same<Scalar, float>::value) { return work_single; } else { return work; }
+            }
+        };
+
+        /** @brief aggregate the rows of level l and add the next level, return false if it does not coarsen */
+        bool Aggregate(const int &l);
+
+        /** @brief smoothers, prolongations and galerkin operators of all levels from the finest operator */
+        void Numeric();
+
+        /** @brief smoother and prolongation of level l and the operator of level l + 1, for the aggregates of level l */
+        void Galerkin(const int &l);
+
+        /** @brief factorize the operator of the coarsest level */
+        void FactorizeCoarse();
+
+        /** @brief estimate of the spectral radius of D^{-1} A by power iterations */
+        static double SpectralRadius(const Level &level);
+
+        /** @brief sparse product A B, columns of the product in parallel */
+        static SparseMatrix Multiply(const SparseMatrix &A, const SparseMatrix &B);
+
+        /** @brief v-cycle from level l with the right hand side in the work b of the level and the result in its x */
+        template<typename Scalar>
+        void VCycle(const int &l) const;
+
+        /** @brief one damped jacobi sweep on a level */
+        template<typename Scalar>
+        void Smooth(const Level &level) const;
+
+    private:
+        double strength_threshold = 0.08;   /** @brief a_ij is strong if |a_ij| > threshold sqrt(a_ii a_jj) */
+        double rebuild_tol = 0.5;           /** @brief relative change of the values that recomputes the hierarchy */
+        int max_coarse = 500;               /** @brief rows of the coarsest level, solved directly */
+        int max_levels = 12;                /** @brief maximum number of levels */
+        int smoothing_steps = 2;            /** @brief jacobi sweeps before and after the coarse correction */
+        int pattern_nnz = -1;               /** @brief nonzeros of the matrix the hierarchy was built for */
+        bool single = false;                /** @brief keep single precision copies of the hierarchy */
+        Eigen::VectorXd setup_values;       /** @brief values of the matrix the hierarchy was last computed for */
+        std::vector<Level> levels;          /** @brief hierarchy, finest first */
+        Eigen::SimplicialLDLT<SparseMatrix> coarse; /** @brief direct solver of the coarsest level */
+};
+
+#endif // AMG_INCL
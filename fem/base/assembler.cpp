@@ -0,0 +1,230 @@
+#include "assembler.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+void Assembler::Init(Mesh &mesh)
+{
+    n_dims = mesh.Dim();
+
+    // the columns are the node neighbours.  boundary elements are facets of domain elements, so the
+    // domain couplings cover them
+    const Adjacency &adj = mesh.NodeNeighbours();
+    const int n_nodes = mesh.NumNodes();
+    std::vector<int> outer(n_nodes + 1, 0);
+    for (int col = 0; col < n_nodes; col++) { outer[col + 1] = outer[col] + ColumnSize(adj, col); }
+    std::vector<int> inner(outer[n_nodes]);
+    #pragma omp parallel for
+    for (int col = 0; col < n_nodes; col++)
+    {
+        std::copy(adj.Begin(col), adj.Begin(col) + ColumnSize(adj, col), inner.begin() + outer[col]);
+    }
+    std::vector<double> values(inner.size(), 0.0);
+    pattern = Eigen::Map<const SparseMatrix>(n_nodes, n_nodes, static_cast<int>(inner.size()), outer.data(), inner.data(), values.data());
+
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() != n_dims && block.Dim() != n_dims - 1) { return; }
+        BuildScatter(block);
+    });
+}
+
+void Assembler::Assemble(Mesh &mesh, SparseMatrix &K, SparseMatrix &M, SparseMatrix &Mb)
+{
+    ZeroMatrix(K);
+    ZeroMatrix(M);
+    ZeroMatrix(Mb);
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() == n_dims)
+        {
+            AssembleDomain(block, K.valuePtr(), M.valuePtr());
+        }
+        else if (block.Dim() == n_dims - 1)
+        {
+            AssembleBoundary(block, Mb.valuePtr());
+        }
+    });
+}
+
+void Assembler::Update(Mesh &mesh, const MeshChange &change)
+{
+    const int n_nodes = mesh.NumNodes();
+    const int n_old = static_cast<int>(change.node_map.size());
+    Assert(static_cast<int>(change.affected.size()) == n_nodes, "change covers %d of %d nodes",
+           static_cast<int>(change.affected.size()), n_nodes);
+
+    // rows of the affected columns are the neighbours of their nodes.  nodes that were not affected
+    // kept their index and their neighbours, so their columns are the same as before
+    const Adjacency &adj = mesh.NodeNeighbours();
+
+    const int *old_outer = pattern.outerIndexPtr();
+    const int *old_inner = pattern.innerIndexPtr();
+    std::vector<int> outer(n_nodes + 1, 0);
+    for (int col = 0; col < n_nodes; col++)
+    {
+        if (change.affected[col])
+        {
+            outer[col + 1] = outer[col] + ColumnSize(adj, col);
+        }
+        else
+        {
+            Assert(col < n_old && change.node_map[col] == col, "node %d moved but is not marked as affected", col);
+            outer[col + 1] = outer[col] + old_outer[col + 1] - old_outer[col];
+        }
+    }
+    std::vector<int> inner(outer[n_nodes]);
+    #pragma omp parallel for
+    for (int col = 0; col < n_nodes; col++)
+    {
+        if (change.affected[col])
+        {
+            std::copy(adj.Begin(col), adj.Begin(col) + ColumnSize(adj, col), inner.begin() + outer[col]);
+        }
+        else
+        {
+            std::copy(old_inner + old_outer[col], old_inner + old_outer[col + 1], inner.begin() + outer[col]);
+        }
+    }
+
+    // entries of elements on affected nodes are looked up again, the others move with their column
+    std::vector<int> shift(n_nodes, 0);
+    for (int col = 0; col < n_nodes; col++)
+    {
+        if (!change.affected[col]) { shift[col] = outer[col] - old_outer[col]; }
+    }
+    std::vector<double> values(inner.size(), 0.0);
+    pattern = Eigen::Map<const SparseMatrix>(n_nodes, n_nodes, static_cast<int>(inner.size()), outer.data(), inner.data(), values.data());
+
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() != n_dims && block.Dim() != n_dims - 1) { return; }
+        constexpr int npe = std::decay_t<decltype(block)>::NPE();
+        #pragma omp parallel for
+        for (int e = 0; e < block.Size(); e++)
+        {
+            auto &elem = block.elems[e];
+            bool affected = false;
+            for (int i = 0; i < npe; i++) { affected = affected || change.affected[elem.Nodes(i).node_id]; }
+            if (affected)
+            {
+                ScatterElement(block, e);
+                continue;
+            }
+            int *pos = &block.scatter[e*npe*npe];
+            for (int i = 0; i < npe; i++)
+            {
+                for (int j = 0; j < npe; j++)
+                {
+                    if (pos[i*npe + j] >= 0) { pos[i*npe + j] += shift[elem.Nodes(j).node_id]; }
+                }
+            }
+        }
+    });
+    INFO("pattern updated, %d columns rebuilt, %d nonzeros",
+         static_cast<int>(std::count(change.affected.begin(), change.affected.end(), 1)), static_cast<int>(pattern.nonZeros()));
+}
+
+template<typename T>
+void Assembler::BuildScatter(ElementBlock<T> &block)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    block.scatter.resize(block.Size()*npe*npe);
+    #pragma omp parallel for
+    for (int e = 0; e < block.Size(); e++)
+    {
+        ScatterElement(block, e);
+    }
+}
+
+template<typename T>
+void Assembler::ScatterElement(ElementBlock<T> &block, const int &e)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    const int *outer = pattern.outerIndexPtr();
+    const int *inner = pattern.innerIndexPtr();
+    T &elem = block.elems[e];
+    for (int i = 0; i < npe; i++)
+    {
+        const int row = elem.Nodes(i).node_id;
+        for (int j = 0; j < npe; j++)
+        {
+            // column major, so entry (row, col) is in the inner indices of column col
+            const int col = elem.Nodes(j).node_id;
+            if (symmetric && row > col)
+            {
+                block.scatter[(e*npe + i)*npe + j] = -1;
+                continue;
+            }
+            const int *pos = std::lower_bound(inner + outer[col], inner + outer[col + 1], row);
+            Assert(pos != inner + outer[col + 1] && *pos == row, "entry (%d, %d) is not in the pattern", row, col);
+            block.scatter[(e*npe + i)*npe + j] = static_cast<int>(pos - inner);
+        }
+    }
+}
+
+template<typename T>
+void Assembler::AssembleDomain(ElementBlock<T> &block, double *k_val, double *m_val)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    #pragma omp parallel for
+    for (int e = 0; e < block.Size(); e++)
+    {
+        T &elem = block.elems[e];
+        if (!block.cached[e])
+        {
+            elem.BuildElemK();
+            elem.BuildElemM();
+            block.cached[e] = 1;
+        }
+        const int *pos = &block.scatter[e*npe*npe];
+        for (int i = 0; i < npe; i++)
+        {
+            for (int j = 0; j < npe; j++)
+            {
+                if (pos[i*npe + j] < 0) { continue; }
+                #pragma omp atomic
+                k_val[pos[i*npe + j]] += elem.k(i,j);
+                #pragma omp atomic
+                m_val[pos[i*npe + j]] += elem.m(i,j);
+            }
+        }
+    }
+}
+
+template<typename T>
+void Assembler::AssembleBoundary(ElementBlock<T> &block, double *mb_val)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    #pragma omp parallel for
+    for (int e = 0; e < block.Size(); e++)
+    {
+        T &elem = block.elems[e];
+        if (!block.cached[e])
+        {
+            elem.BuildElemM();
+            block.cached[e] = 1;
+        }
+        const int *pos = &block.scatter[e*npe*npe];
+        for (int i = 0; i < npe; i++)
+        {
+            for (int j = 0; j < npe; j++)
+            {
+                if (pos[i*npe + j] < 0) { continue; }
+                #pragma omp atomic
+                mb_val[pos[i*npe + j]] += elem.m(i,j);
+            }
+        }
+    }
+}
+
+void Assembler::ZeroMatrix(SparseMatrix &A)
+{
+    if (A.nonZeros() != pattern.nonZeros() || A.rows() != pattern.rows())
+    {
+        A = pattern;
+    }
+    A.coeffs().setZero();
+}
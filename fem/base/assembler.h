@@ -0,0 +1,170 @@
+#ifndef ASSEMBLER_INCL
+#define ASSEMBLER_INCL
+
+#include "mesh.h"
+#include "refiner.h"
+#include "solver.h"
+
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief assembles the global matrices by looping over the element blocks of the mesh. the sparsity
+ * pattern and the scatter map of every block (the position of each local entry in the global value
+ * array) are built once, so assembly is the element kernels plus indexed adds into the value arrays.
+ * domain blocks are assembled into K and M and boundary blocks (one dimension lower) into the boundary
+ * mass matrix Mb in the same pass.  all matrices share the same pattern.  element matrices are cached
+ * on the elements and only rebuilt for elements whose geometry changed, e.g. by refinement.  in symmetric
+ * mode the pattern only holds the upper triangle, the scatter position of a local entry below the diagonal
+ * is -1 and the kernels skip it.
+ */
+class Assembler
+{
+    public:
+        Assembler() = default;
+
+        /** @brief assemble only the upper triangle of the symmetric matrices, set before Init */
+        inline void SetSymmetric(const bool &symmetric) { this->symmetric = symmetric; }
+
+        /** @brief true if the assembled matrices hold the upper triangle only */
+        inline bool Symmetric() const { return symmetric; }
+
+        /**
+         * @brief build the global sparsity pattern and the scatter map of every element block
+         * @param mesh mesh with its element blocks read in
+         */
+        void Init(Mesh &mesh);
+
+        /**
+         * @brief update the sparsity pattern and the scatter maps after the mesh was refined or coarsened.
+         * only the columns of the nodes in change.affected are rebuilt from their elements, the others
+         * are copied from the previous pattern and the scatter entries into them shifted.
+         * @param mesh mesh passed to Init, after the change
+         * @param change nodes added, removed and affected by the change
+         */
+        void Update(Mesh &mesh, const MeshChange &change);
+
+        /**
+         * @brief assemble the global stiffness, mass and boundary mass matrices
+         * @param mesh mesh passed to Init
+         * @param K global stiffness matrix
+         * @param M global mass matrix
+         * @param Mb global boundary mass matrix
+         */
+        void Assemble(Mesh &mesh, SparseMatrix &K, SparseMatrix &M, SparseMatrix &Mb);
+
+        /**
+         * @brief incrementally re-assemble a stiffness matrix weighted per element, Ks = sum_e c_e K_e with
+         * c_e = D(u_e) and u_e the mean of u over the element nodes.  an element is dirty when its
+         * coefficient moved by more than tol relative to the one last assembled; only dirty elements
+         * touch Ks, by subtracting the old and adding the new contribution, (c_new - c_old) K_e, through
+         * the scatter map.  the unit element matrices cached by the last Assemble are reused.
+         * @param mesh mesh passed to Init and Assemble
+         * @param D coefficient as a function of the element mean of u
+         * @param u nodal values the coefficient depends on
+         * @param Ks weighted stiffness matrix.  built from scratch when coef is empty
+         * @param coef coefficient last assembled for each domain element, in block order
+         * @param tol relative change of the coefficient that marks an element dirty
+         * @return number of dirty elements
+         */
+        template<typename Coefficient>
+        int Reassemble(Mesh &mesh, const Coefficient &D, const Eigen::Ref<const Eigen::VectorXd> &u,
+                       SparseMatrix &Ks, std::vector<double> &coef, const double &tol);
+
+        /** @brief the sparsity pattern shared by all assembled matrices */
+        inline const SparseMatrix& Pattern() const { return pattern; }
+
+        /** @brief bytes held by the sparsity pattern */
+        inline std::size_t MemoryBytes() const { return Bytes(pattern); }
+
+    private:
+        /** @brief stored rows of column col, the leading ones up to the diagonal in symmetric mode */
+        inline int ColumnSize(const Adjacency &adj, const int &col) const
+        {
+            return symmetric ? static_cast<int>(std::upper_bound(adj.Begin(col), adj.End(col), col) - adj.Begin(col)) : adj.Degree(col);
+        }
+
+        /** @brief locate each local entry of the block's elements in the global value array */
+        template<typename T>
+        void BuildScatter(ElementBlock<T> &block);
+
+        /** @brief locate each local entry of element e in the global value array, -1 for the ones not stored */
+        template<typename T>
+        void ScatterElement(ElementBlock<T> &block, const int &e);
+
+        /** @brief kernel loop adding element stiffness and mass matrices of a domain block */
+        template<typename T>
+        void AssembleDomain(ElementBlock<T> &block, double *k_val, double *m_val);
+
+        /** @brief kernel loop adding element mass matrices of a boundary block */
+        template<typename T>
+        void AssembleBoundary(ElementBlock<T> &block, double *mb_val);
+
+        /** @brief kernel loop adding the coefficient change of the dirty elements of a domain block */
+        template<typename T, typename Coefficient>
+        int ReassembleBlock(ElementBlock<T> &block, const Coefficient &D, const Eigen::Ref<const Eigen::VectorXd> &u,
+                            double *ks_val, double *coef, const double &tol);
+
+        /** @brief reset a matrix to the global pattern with zero values */
+        void ZeroMatrix(SparseMatrix &A);
+
+    private:
+        int n_dims;             /** @brief spatial dimension of the mesh domain */
+        SparseMatrix pattern;   /** @brief global sparsity pattern */
+        bool symmetric = false; /** @brief pattern of the upper triangle only */
+};
+
+template<typename Coefficient>
+int Assembler::Reassemble(Mesh &mesh, const Coefficient &D, const Eigen::Ref<const Eigen::VectorXd> &u,
+                          SparseMatrix &Ks, std::vector<double> &coef, const double &tol)
+{
+    // an empty coefficient list means nothing has been assembled yet, so every element is dirty
+    if (coef.empty())
+    {
+        ZeroMatrix(Ks);
+        coef.assign(mesh.NumElems(), 0.0);
+    }
+    int n_dirty = 0;
+    int offset = 0;
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() != n_dims) { return; }
+        n_dirty += ReassembleBlock(block, D, u, Ks.valuePtr(), &coef[offset], tol);
+        offset += block.Size();
+    });
+    return n_dirty;
+}
+
+template<typename T, typename Coefficient>
+int Assembler::ReassembleBlock(ElementBlock<T> &block, const Coefficient &D, const Eigen::Ref<const Eigen::VectorXd> &u,
+                               double *ks_val, double *coef, const double &tol)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    int n_dirty = 0;
+    #pragma omp parallel for reduction(+:n_dirty)
+    for (int e = 0; e < block.Size(); e++)
+    {
+        T &elem = block.elems[e];
+        double u_e = 0.0;
+        for (int i = 0; i < npe; i++) { u_e += u(elem.Nodes(i).node_id); }
+        const double c = D(u_e / npe);
+        const double dc = c - coef[e];
+        if (std::abs(dc) <= tol*std::abs(coef[e])) { continue; }
+
+        const int *pos = &block.scatter[e*npe*npe];
+        for (int i = 0; i < npe; i++)
+        {
+            for (int j = 0; j < npe; j++)
+            {
+                if (pos[i*npe + j] < 0) { continue; }
+                #pragma omp atomic
+                ks_val[pos[i*npe + j]] += dc*elem.k(i,j);
+            }
+        }
+        coef[e] = c;
+        n_dirty++;
+    }
+    return n_dirty;
+}
+
+#endif // ASSEMBLER_INCL
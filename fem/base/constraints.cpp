@@ -0,0 +1,132 @@
+#include "constraints.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+
+void Constraints::AddCondition(const int &geom_idx, const double &value)
+{
+    conditions[geom_idx] = value;
+}
+
+void Constraints::Init(Mesh &mesh, const SparseMatrix &pattern)
+{
+    // collect the nodes of every boundary element on a constrained entity.  a node shared by two
+    // constrained entities takes the value of the one with the larger index, whatever the element order
+    std::map<int, std::pair<int, double>> node_values; // node -> entity index, value
+    auto constrain = [&](const int &node, const int &geom_idx, const double &value)
+    {
+        auto [it, added] = node_values.try_emplace(node, geom_idx, value);
+        if (!added && geom_idx > it->second.first) { it->second = {geom_idx, value}; }
+    };
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() != mesh.Dim() - 1) { return; }
+        for (int e = 0; e < block.Size(); e++)
+        {
+            auto it = conditions.find(block.geom_idx[e]);
+            if (it == conditions.end()) { continue; }
+            for (int i = 0; i < block.NPE(); i++) { constrain(block.elems[e].Nodes(i).node_id, it->first, it->second); }
+        }
+    });
+    // in 1D the boundary entities are the geometric vertices
+    if (mesh.Dim() == 1)
+    {
+        for (std::size_t v = 0; v < mesh.Vertices().size(); v++)
+        {
+            auto it = conditions.find(mesh.VertexGeomIdx()[v]);
+            if (it != conditions.end()) { constrain(mesh.Vertices()[v], it->first, it->second); }
+        }
+    }
+
+    dofs.clear();
+    dofs.reserve(node_values.size());
+    g.resize(node_values.size());
+    for (const auto &[node, entity] : node_values)
+    {
+        g(dofs.size()) = entity.second;
+        dofs.push_back(node);
+        mesh.Nodes(node).ebc_flag = true;
+    }
+    INFO("%d constrained nodes on %d boundary entities", Size(), static_cast<int>(conditions.size()));
+
+    // dof index of each constrained node, -1 for free nodes
+    std::vector<int> dof_idx(pattern.rows(), -1);
+    for (int c = 0; c < Size(); c++) { dof_idx[dofs[c]] = c; }
+
+    // element node copies carry the flag as well
+    mesh.ForEachBlock([&](auto &block)
+    {
+        for (auto &elem : block.elems)
+        {
+            for (int i = 0; i < block.NPE(); i++) { elem.Nodes(i).ebc_flag = dof_idx[elem.Nodes(i).node_id] >= 0; }
+        }
+    });
+
+    mask.setOnes(pattern.nonZeros());
+    diag_pos.assign(Size(), -1);
+    lift_pos.clear();
+    lift_row.clear();
+    lift_dof.clear();
+    const int *outer = pattern.outerIndexPtr();
+    const int *inner = pattern.innerIndexPtr();
+    // a pattern of the upper triangle of a symmetric matrix stores entry (constrained row, free column) for
+    // its mirror (free row, constrained column) as well, so the lift goes to the row of the column
+    bool upper = true;
+    for (int col = 0; col < pattern.outerSize() && upper; col++)
+    {
+        upper = outer[col + 1] == outer[col] || inner[outer[col + 1] - 1] <= col;
+    }
+    for (int col = 0; col < pattern.outerSize(); col++)
+    {
+        for (int p = outer[col]; p < outer[col + 1]; p++)
+        {
+            const int row = inner[p];
+            if (dof_idx[row] < 0 && dof_idx[col] < 0) { continue; }
+            mask(p) = 0.0;
+            if (row == col)
+            {
+                diag_pos[dof_idx[col]] = p;
+            }
+            else if (dof_idx[col] >= 0 && dof_idx[row] < 0)
+            {
+                lift_pos.push_back(p);
+                lift_row.push_back(row);
+                lift_dof.push_back(dof_idx[col]);
+            }
+            else if (upper && dof_idx[row] >= 0 && dof_idx[col] < 0)
+            {
+                lift_pos.push_back(p);
+                lift_row.push_back(col);
+                lift_dof.push_back(dof_idx[row]);
+            }
+        }
+    }
+    for (int c = 0; c < Size(); c++)
+    {
+        Assert(diag_pos[c] >= 0, "constrained node %d has no diagonal entry in the pattern", dofs[c]);
+    }
+    lift_val.setZero(lift_pos.size());
+}
+
+void Constraints::ApplyMatrix(SparseMatrix &A)
+{
+    Assert(A.nonZeros() == mask.size(), "matrix does not match the constraint pattern");
+    double *val = A.valuePtr();
+    for (std::size_t k = 0; k < lift_pos.size(); k++) { lift_val(k) = val[lift_pos[k]]; }
+    A.coeffs().array() *= mask.array();
+    for (int c = 0; c < Size(); c++) { val[diag_pos[c]] = 1.0; }
+}
+
+void Constraints::SetLift(const SparseMatrix &M, const double &alpha, const SparseMatrix &K, const double &beta)
+{
+    Assert(M.nonZeros() == mask.size() && K.nonZeros() == mask.size(), "matrices do not match the constraint pattern");
+    const double *m = M.valuePtr();
+    const double *k = K.valuePtr();
+    for (std::size_t i = 0; i < lift_pos.size(); i++) { lift_val(i) = alpha*m[lift_pos[i]] + beta*k[lift_pos[i]]; }
+}
+
+void Constraints::ApplyRHS(Eigen::VectorXd &b)
+{
+    for (std::size_t k = 0; k < lift_pos.size(); k++) { b(lift_row[k]) -= lift_val(k)*g(lift_dof[k]); }
+    for (int c = 0; c < Size(); c++) { b(dofs[c]) = g(c); }
+}
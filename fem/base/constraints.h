@@ -0,0 +1,80 @@
+#ifndef CONSTRAINTS_INCL
+#define CONSTRAINTS_INCL
+
+#include "mesh.h"
+#include "solver.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * @brief essential (dirichlet) boundary conditions.  the conditions are given per geometric entity
+ * index of the boundary blocks and are resolved once into a sorted list of constrained nodes and an
+ * elimination map over the global sparsity pattern.  applying them to a system is then a mask over
+ * the matrix values plus a lift of the right hand side, with no change to the matrix structure.
+ * rows and columns are both eliminated, so a symmetric matrix stays symmetric.
+ */
+class Constraints
+{
+    public:
+        Constraints() = default;
+
+        /**
+         * @brief prescribe a value on every node of a boundary entity
+         * @param geom_idx geometric entity index of the boundary, as given in the mesh file
+         * @param value prescribed value
+         */
+        void AddCondition(const int &geom_idx, const double &value);
+
+        /**
+         * @brief resolve the conditions into constrained nodes and build the elimination map. also sets
+         * Node::ebc_flag on the constrained mesh nodes.
+         * @param mesh mesh with its boundary blocks read in
+         * @param pattern global sparsity pattern of the systems the constraints are applied to, full or
+         * the upper triangle of symmetric ones
+         */
+        void Init(Mesh &mesh, const SparseMatrix &pattern);
+
+        /**
+         * @brief eliminate the constrained rows and columns of A.  the values of the eliminated columns
+         * are kept for lifting right hand sides, so call this before ApplyRHS.
+         * @param A system matrix with the pattern passed to Init
+         */
+        void ApplyMatrix(SparseMatrix &A);
+
+        /**
+         * @brief keep the values of the columns ApplyMatrix would eliminate from alpha M + beta K, without
+         * forming the matrix, for systems that are solved matrix-free
+         * @param M matrix with the pattern passed to Init
+         * @param K matrix with the pattern passed to Init
+         */
+        void SetLift(const SparseMatrix &M, const double &alpha, const SparseMatrix &K, const double &beta);
+
+        /**
+         * @brief lift the eliminated columns into b and set the prescribed values in the constrained rows
+         * @param b right hand side
+         */
+        void ApplyRHS(Eigen::VectorXd &b);
+
+        /** @brief number of constrained nodes */
+        inline int Size() const { return static_cast<int>(dofs.size()); }
+
+        /** @brief sorted list of constrained nodes */
+        inline const std::vector<int>& Dofs() const { return dofs; }
+
+        /** @brief prescribed values, matching Dofs */
+        inline const Eigen::VectorXd& Values() const { return g; }
+
+    private:
+        std::map<int, double> conditions;   /** @brief prescribed value per boundary geometric entity */
+        std::vector<int> dofs;              /** @brief sorted constrained nodes */
+        Eigen::VectorXd g;                  /** @brief prescribed value of each constrained node */
+        Eigen::VectorXd mask;               /** @brief 0 for values in a constrained row or column, 1 otherwise */
+        std::vector<int> diag_pos;          /** @brief value position of the diagonal of each constrained row */
+        std::vector<int> lift_pos;          /** @brief value position of each entry (free row, constrained column) */
+        std::vector<int> lift_row;          /** @brief free row of each lift entry */
+        std::vector<int> lift_dof;          /** @brief index into dofs of the column of each lift entry */
+        Eigen::VectorXd lift_val;           /** @brief matrix values of the lift entries saved by ApplyMatrix */
+};
+
+#endif // CONSTRAINTS_INCL
@@ -0,0 +1,342 @@
+#include "history.h"
+#include "logger/logger.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    /** @brief bits of a double */
+    inline std::uint64_t Bits(const double &v)
+    {
+        std::uint64_t b;
+        std::memcpy(&b, &v, sizeof(b));
+        return b;
+    }
+
+    inline double Value(const std::uint64_t &b)
+    {
+        double v;
+        std::memcpy(&v, &b, sizeof(v));
+        return v;
+    }
+
+    /** @brief the lowest n bits set, n up to 64 */
+    inline std::uint64_t Mask(const int &n)
+    {
+        return n >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+    }
+
+    /**
+     * @brief prediction of a value from the same value at the previous steps, a the latest: a itself, its linear
+     * or its quadratic extrapolation.  2 a is exact and the quadratic is an explicit fma, so the result does not
+     * depend on how the compiler contracts the arithmetic and the decoder predicts the same bits
+     */
+    inline std::uint64_t Predict(const int &order, const double &a, const double &b, const double &c)
+    {
+        switch (order)
+        {
+            case 1: return Bits(a);
+            case 2: return Bits(2.0*a - b);
+            default: return Bits(std::fma(3.0, a - b, c));
+        }
+    }
+
+    /** @brief bits between the leading and the trailing zeros of x */
+    inline int Meaningful(const std::uint64_t &x)
+    {
+        return (x == 0) ? 0 : 64 - __builtin_clzll(x) - __builtin_ctzll(x);
+    }
+
+    /** @brief packs bit fields of up to 64 bits, lowest bit first */
+    struct BitWriter
+    {
+        std::vector<std::uint8_t> &bytes;
+        std::uint64_t acc = 0;
+        int fill = 0;
+
+        inline void Put(const std::uint64_t &v, const int &n)
+        {
+            acc |= v << fill;
+            if (fill + n < 64)
+            {
+                fill += n;
+                return;
+            }
+            const std::size_t pos = bytes.size();
+            bytes.resize(pos + 8);
+            std::memcpy(bytes.data() + pos, &acc, 8);
+            acc = (fill == 0) ? 0 : v >> (64 - fill);
+            fill += n - 64;
+        }
+
+        inline void Flush()
+        {
+            for (int b = 0; b < fill; b += 8) { bytes.push_back(static_cast<std::uint8_t>(acc >> b)); }
+            acc = 0;
+            fill = 0;
+        }
+    };
+
+    /** @brief unpacks the fields of a BitWriter */
+    struct BitReader
+    {
+        const std::uint8_t *pos;
+        const std::uint8_t *end;
+        std::uint64_t acc = 0;
+        int avail = 0;
+
+        inline std::uint64_t Next()
+        {
+            std::uint64_t w = 0;
+            const std::size_t n = std::min<std::size_t>(8, end - pos);
+            std::memcpy(&w, pos, n);
+            pos += n;
+            return w;
+        }
+
+        inline std::uint64_t Get(const int &n)
+        {
+            if (n <= avail)
+            {
+                const std::uint64_t v = acc & Mask(n);
+                acc = (n == 64) ? 0 : acc >> n;
+                avail -= n;
+                return v;
+            }
+            const std::uint64_t low = acc;
+            const int need = n - avail;
+            const std::uint64_t w = Next();
+            const std::uint64_t v = low | ((w & Mask(need)) << avail);
+            acc = (need == 64) ? 0 : w >> need;
+            avail = 64 - need;
+            return v;
+        }
+    };
+
+    /**
+     * @brief code x = value XOR prediction: '0' if zero, '10' and the bits inside the window of the
+     * previous nonzero x if they fit, else '11', 6 bits of leading zeros, 6 bits of length - 1 and the bits
+     */
+    inline void PackXor(BitWriter &w, const std::uint64_t &x, int &lead, int &trail)
+    {
+        if (x == 0)
+        {
+            w.Put(0, 1);
+            return;
+        }
+        const int lz = __builtin_clzll(x);
+        const int tz = __builtin_ctzll(x);
+        if (lead >= 0 && lz >= lead && tz >= trail)
+        {
+            w.Put(1, 2);
+            w.Put(x >> trail, 64 - lead - trail);
+            return;
+        }
+        lead = lz;
+        trail = tz;
+        w.Put(3, 2);
+        w.Put(lz, 6);
+        w.Put(63 - lz - tz, 6);
+        w.Put(x >> tz, 64 - lz - tz);
+    }
+
+    inline std::uint64_t UnpackXor(BitReader &r, int &lead, int &trail)
+    {
+        if (r.Get(1) == 0) { return 0; }
+        if (r.Get(1) == 0) { return r.Get(64 - lead - trail) << trail; }
+        lead = static_cast<int>(r.Get(6));
+        const int len = static_cast<int>(r.Get(6)) + 1;
+        trail = 64 - lead - len;
+        return r.Get(len) << trail;
+    }
+}
+
+HistoryWriter::~HistoryWriter()
+{
+    Close();
+}
+
+void HistoryWriter::Open(const std::string &file_name, const int &keyframe_interval)
+{
+    Close();
+    out.open(file_name, std::ios::binary | std::ios::trunc);
+    Assert(out.is_open(), "could not open history file %s", file_name.c_str());
+    this->keyframe_interval = std::max(1, keyframe_interval);
+    since_keyframe = 0;
+    offsets.clear();
+    for (Eigen::VectorXd &p : prev) { p.resize(0); }
+    raw_bytes = 0.0;
+    const std::uint64_t magic = HistoryFooter::magic_number;
+    out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    written_bytes = sizeof(magic);
+}
+
+void HistoryWriter::Close()
+{
+    if (!out.is_open()) { return; }
+    const HistoryFooter footer{written_bytes, offsets.size(), HistoryFooter::magic_number};
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size()*sizeof(std::uint64_t));
+    out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    written_bytes += offsets.size()*sizeof(std::uint64_t) + sizeof(footer);
+    out.close();
+    INFO("history of %d frames, %.2f times smaller than the values", static_cast<int>(offsets.size()), Ratio());
+}
+
+void HistoryWriter::Append(const int &step, const double &time, const Eigen::VectorXd &u, const int &n_nodes, const int &n_species)
+{
+    Assert(IsOpen(), "history file is not open");
+    Assert(u.size() == static_cast<Eigen::Index>(n_nodes)*n_species, "solution of %d values for %d nodes and %d species",
+           static_cast<int>(u.size()), n_nodes, n_species);
+    const Eigen::Index n = u.size();
+    if (prev[0].size() != n || since_keyframe >= keyframe_interval) { since_keyframe = 0; }
+
+    // the order of the prediction leaving the fewest bits on a sample of the values
+    int order = 0;
+    if (since_keyframe > 0)
+    {
+        int best = std::numeric_limits<int>::max();
+        const Eigen::Index stride = std::max<Eigen::Index>(1, n / 1024);
+        for (int o = 1; o <= std::min(since_keyframe, 3); o++)
+        {
+            int bits = 0;
+            for (Eigen::Index i = 0; i < n; i += stride)
+            {
+                bits += Meaningful(Bits(u(i)) ^ Predict(o, prev[0](i), o > 1 ? prev[1](i) : 0.0, o > 2 ? prev[2](i) : 0.0));
+            }
+            if (bits < best)
+            {
+                best = bits;
+                order = o;
+            }
+        }
+    }
+
+    buffer.clear();
+    buffer.reserve(n*sizeof(double) / 2);
+    BitWriter w{buffer};
+    int lead = -1, trail = 0;
+    if (order == 0)
+    {
+        for (Eigen::Index i = 0; i < n; i++) { PackXor(w, Bits(u(i)), lead, trail); }
+    }
+    else
+    {
+        const double *a = prev[0].data();
+        const double *b = order > 1 ? prev[1].data() : a;
+        const double *c = order > 2 ? prev[2].data() : a;
+        for (Eigen::Index i = 0; i < n; i++) { PackXor(w, Bits(u(i)) ^ Predict(order, a[i], b[i], c[i]), lead, trail); }
+    }
+    w.Flush();
+
+    const HistoryFrame frame{step, time, n_nodes, n_species, order, buffer.size()};
+    offsets.push_back(written_bytes);
+    out.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    written_bytes += sizeof(frame) + buffer.size();
+    raw_bytes += n*sizeof(double);
+
+    std::rotate(prev.rbegin(), prev.rbegin() + 1, prev.rend());
+    prev[0] = u;
+    since_keyframe++;
+}
+
+bool HistoryReader::Open(const std::string &file_name)
+{
+    in.close();
+    in.clear();
+    offsets.clear();
+    frames.clear();
+    decoded = -1;
+    in.open(file_name, std::ios::binary);
+    std::uint64_t magic = 0;
+    if (!in.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != HistoryFooter::magic_number) { return false; }
+
+    // the index of a closed file, else the frames one after the other up to the first incomplete one
+    in.seekg(0, std::ios::end);
+    const std::uint64_t size = in.tellg();
+    HistoryFooter footer{0, 0, 0};
+    if (size >= sizeof(magic) + sizeof(footer))
+    {
+        in.seekg(size - sizeof(footer));
+        in.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+    }
+    if (footer.magic == HistoryFooter::magic_number && footer.index_offset + footer.n_frames*sizeof(std::uint64_t) + sizeof(footer) == size)
+    {
+        offsets.resize(footer.n_frames);
+        in.seekg(footer.index_offset);
+        in.read(reinterpret_cast<char*>(offsets.data()), offsets.size()*sizeof(std::uint64_t));
+    }
+    else
+    {
+        WARN("history file %s was not closed, scanning its frames", file_name.c_str());
+        for (std::uint64_t pos = sizeof(magic); pos + sizeof(HistoryFrame) <= size;)
+        {
+            HistoryFrame frame;
+            in.seekg(pos);
+            in.read(reinterpret_cast<char*>(&frame), sizeof(frame));
+            if (pos + sizeof(frame) + frame.n_bytes > size) { break; }
+            offsets.push_back(pos);
+            pos += sizeof(frame) + frame.n_bytes;
+        }
+    }
+    frames.resize(offsets.size());
+    for (std::size_t i = 0; i < offsets.size(); i++)
+    {
+        in.seekg(offsets[i]);
+        in.read(reinterpret_cast<char*>(&frames[i]), sizeof(HistoryFrame));
+    }
+    return static_cast<bool>(in);
+}
+
+int HistoryReader::Find(const int &step) const
+{
+    auto it = std::lower_bound(frames.begin(), frames.end(), step,
+                               [](const HistoryFrame &f, const int &s) { return f.step < s; });
+    return (it != frames.end() && it->step == step) ? static_cast<int>(it - frames.begin()) : -1;
+}
+
+void HistoryReader::Read(const int &i, Eigen::VectorXd &u)
+{
+    Assert(i >= 0 && i < NumFrames(), "frame %d of a history of %d frames", i, NumFrames());
+    if (decoded == i)
+    {
+        u = prev[0];
+        return;
+    }
+    int first = i;
+    while (frames[first].order > 0) { first--; }
+    if (decoded >= first && decoded < i) { first = decoded + 1; }
+    for (int j = first; j <= i; j++)
+    {
+        Decode(j, u);
+        std::rotate(prev.rbegin(), prev.rbegin() + 1, prev.rend());
+        prev[0] = u;
+        decoded = j;
+    }
+}
+
+void HistoryReader::Decode(const int &i, Eigen::VectorXd &u)
+{
+    const HistoryFrame &frame = frames[i];
+    buffer.resize(frame.n_bytes);
+    in.seekg(offsets[i] + sizeof(HistoryFrame));
+    in.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    Assert(static_cast<bool>(in), "could not read frame %d of the history", i);
+
+    const Eigen::Index n = frame.n_nodes*frame.n_species;
+    u.resize(n);
+    BitReader r{buffer.data(), buffer.data() + buffer.size()};
+    int lead = -1, trail = 0;
+    const int order = static_cast<int>(frame.order);
+    if (order == 0)
+    {
+        for (Eigen::Index k = 0; k < n; k++) { u(k) = Value(UnpackXor(r, lead, trail)); }
+        return;
+    }
+    const double *a = prev[0].data();
+    const double *b = order > 1 ? prev[1].data() : a;
+    const double *c = order > 2 ? prev[2].data() : a;
+    for (Eigen::Index k = 0; k < n; k++) { u(k) = Value(UnpackXor(r, lead, trail) ^ Predict(order, a[k], b[k], c[k])); }
+}
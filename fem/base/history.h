@@ -0,0 +1,118 @@
+#ifndef HISTORY_INCL
+#define HISTORY_INCL
+
+#include <eigen/Eigen/Core>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** @brief stored in front of the coded values of every frame of a history file */
+struct HistoryFrame
+{
+    std::int64_t step;          /** @brief time step index */
+    double time;                /** @brief simulated time */
+    std::int64_t n_nodes;       /** @brief number of nodes */
+    std::int64_t n_species;     /** @brief number of species */
+    std::int64_t order;         /** @brief frames the values are predicted from, 0 for a keyframe */
+    std::uint64_t n_bytes;      /** @brief size of the coded values */
+};
+
+/** @brief last bytes of a closed history file, after an index of n_frames offsets of the frames.  the file starts with the magic number too */
+struct HistoryFooter
+{
+    static constexpr std::uint64_t magic_number = 0x5453494854534948; /** @brief "HISTHIST" */
+
+    std::uint64_t index_offset; /** @brief position of the index */
+    std::uint64_t n_frames;     /** @brief number of frames */
+    std::uint64_t magic;        /** @brief magic_number */
+};
+
+/**
+ * @brief appends solutions to a lossless compressed history file.  the file holds one frame per stored step.  every
+ * value of a frame is XORed with a prediction from the previous frames and the XOR is packed by its leading
+ * and trailing zeros, in the style of gorilla and FPC: one bit for an unchanged value, the meaningful bits
+ * alone when they fit the bit window of the previous value, else a new window of 6 + 6 bits before them.
+ * the prediction is the value at the previous step or its linear or quadratic extrapolation from the
+ * previous steps, whichever order leaves the fewest bits on a sample of the frame.  every keyframe_interval
+ * frames, and whenever the mesh changes, a keyframe is coded against zero, so a frame is decoded from the
+ * keyframe before it.  an index of the frames ends the file.
+ */
+class HistoryWriter
+{
+    public:
+        HistoryWriter() = default;
+        ~HistoryWriter();
+
+        /**
+         * @brief create (or truncate) a history file
+         * @param keyframe_interval frames from one keyframe to the next, the most frames decoded for one read
+         */
+        void Open(const std::string &file_name, const int &keyframe_interval = 32);
+
+        /** @brief write the index and close the file.  a file that was not closed is still read, without its index */
+        void Close();
+
+        /** @brief true if the file is open */
+        inline bool IsOpen() const { return out.is_open(); }
+
+        /**
+         * @brief compress a solution and append it as the next frame
+         * @param u solution, n_nodes values per species
+         */
+        void Append(const int &step, const double &time, const Eigen::VectorXd &u, const int &n_nodes, const int &n_species);
+
+        /** @brief bytes the values would take uncompressed over the bytes written so far */
+        inline double Ratio() const { return raw_bytes / std::max(1.0, static_cast<double>(written_bytes)); }
+
+    private:
+        std::ofstream out;                  /** @brief history file */
+        int keyframe_interval = 32;         /** @brief frames between keyframes */
+        int since_keyframe = 0;             /** @brief frames written since the last keyframe, the keyframe included */
+        std::vector<std::uint64_t> offsets; /** @brief position of every frame */
+        std::array<Eigen::VectorXd, 3> prev; /** @brief solutions of the previous frames, the latest first */
+        std::vector<std::uint8_t> buffer;   /** @brief coded values of the frame being written */
+        double raw_bytes = 0.0;             /** @brief size of the values appended */
+        std::uint64_t written_bytes = 0;    /** @brief size of the file */
+};
+
+/** @brief random access to the frames of a history file */
+class HistoryReader
+{
+    public:
+        /** @return false if the file cannot be read */
+        bool Open(const std::string &file_name);
+
+        /** @brief number of frames */
+        inline int NumFrames() const { return static_cast<int>(frames.size()); }
+
+        /** @brief step, time and sizes of frame i */
+        inline const HistoryFrame& Frame(const int &i) const { return frames[i]; }
+
+        /** @brief index of the frame of a time step, -1 if it was not stored */
+        int Find(const int &step) const;
+
+        /**
+         * @brief decode frame i.  frames are decoded from the keyframe before them, or from the frame read
+         * last when it is on the way, so reading the frames in order decodes each of them once
+         * @param u solution of the frame, n_nodes values per species
+         */
+        void Read(const int &i, Eigen::VectorXd &u);
+
+    private:
+        /** @brief decode frame i on top of the frames before it in prev */
+        void Decode(const int &i, Eigen::VectorXd &u);
+
+    private:
+        std::ifstream in;                           /** @brief history file */
+        std::vector<std::uint64_t> offsets;         /** @brief position of every frame */
+        std::vector<HistoryFrame> frames;           /** @brief header of every frame */
+        std::vector<std::uint8_t> buffer;           /** @brief coded values of the frame being read */
+        int decoded = -1;                           /** @brief frame in prev, -1 if none */
+        std::array<Eigen::VectorXd, 3> prev;        /** @brief last frames decoded, the latest first */
+};
+
+#endif // HISTORY_INCL
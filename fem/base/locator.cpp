@@ -0,0 +1,281 @@
+#include "locator.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    /** @brief spread the lower 10 bits of v so there are two zero bits between each of them */
+    inline std::uint32_t SpreadBits(std::uint32_t v)
+    {
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    /** @brief true if the element type has a simplex reference domain, otherwise it is [-1,1]^dim */
+    template<typename T>
+    constexpr bool SimplexReference()
+    {
+        return std::is_same<T, LinTri>::value || std::is_same<T, QuadTri>::value || std::is_same<T, LinTet>::value;
+    }
+}
+
+void Locator::Build(Mesh &mesh)
+{
+    n_dims = mesh.Dim();
+    mesh.DispatchBlock(mesh.ElemType(), [&](auto &block)
+    {
+        const int n_elems = block.Size();
+
+        // element boxes and the box around their centroids
+        boxes.resize(6*n_elems);
+        std::vector<double> centroids(3*n_elems);
+        #pragma omp parallel for
+        for (int e = 0; e < n_elems; e++)
+        {
+            auto &elem = block.elems[e];
+            double *lo = &boxes[6*e];
+            double *hi = lo + 3;
+            for (int d = 0; d < 3; d++)
+            {
+                lo[d] = std::numeric_limits<double>::max();
+                hi[d] = -std::numeric_limits<double>::max();
+            }
+            for (int a = 0; a < block.NPE(); a++)
+            {
+                for (int d = 0; d < 3; d++)
+                {
+                    lo[d] = std::min(lo[d], elem.Nodes(a).coords[d]);
+                    hi[d] = std::max(hi[d], elem.Nodes(a).coords[d]);
+                }
+            }
+            for (int d = 0; d < 3; d++) { centroids[3*e + d] = 0.5*(lo[d] + hi[d]); }
+        }
+        double c_lo[3], c_hi[3], extent = 0.0;
+        for (int d = 0; d < 3; d++)
+        {
+            c_lo[d] = std::numeric_limits<double>::max();
+            c_hi[d] = -std::numeric_limits<double>::max();
+            for (int e = 0; e < n_elems; e++)
+            {
+                c_lo[d] = std::min(c_lo[d], centroids[3*e + d]);
+                c_hi[d] = std::max(c_hi[d], centroids[3*e + d]);
+                extent = std::max(extent, boxes[6*e + 3 + d] - boxes[6*e + d]);
+            }
+        }
+
+        // widen the boxes slightly so points on element faces are not lost to rounding
+        const double pad = 1e-10*std::max(extent, c_hi[0] - c_lo[0] + c_hi[1] - c_lo[1] + c_hi[2] - c_lo[2]);
+        std::vector<std::pair<std::uint32_t, int>> codes(n_elems);
+        #pragma omp parallel for
+        for (int e = 0; e < n_elems; e++)
+        {
+            std::uint32_t code = 0;
+            for (int d = 0; d < 3; d++)
+            {
+                boxes[6*e + d] -= pad;
+                boxes[6*e + 3 + d] += pad;
+                const double range = c_hi[d] - c_lo[d];
+                const double t = (range > 0.0) ? (centroids[3*e + d] - c_lo[d]) / range : 0.0;
+                code |= SpreadBits(static_cast<std::uint32_t>(std::min(t*1024.0, 1023.0))) << d;
+            }
+            codes[e] = std::make_pair(code, e);
+        }
+        std::sort(codes.begin(), codes.end());
+        order.resize(n_elems);
+        for (int e = 0; e < n_elems; e++) { order[e] = codes[e].second; }
+
+        tree.resize(SubtreeSize(n_elems));
+        #pragma omp parallel
+        {
+            #pragma omp single
+            BuildNode(0, 0, n_elems);
+        }
+    });
+    DEBUG("point locator built, %d elements, %d tree nodes", static_cast<int>(order.size()), static_cast<int>(tree.size()));
+}
+
+int Locator::SubtreeSize(const int &count)
+{
+    if (count <= leaf_size) { return 1; }
+    return 1 + SubtreeSize(count / 2) + SubtreeSize(count - count / 2);
+}
+
+void Locator::BuildNode(const int &node, const int &first, const int &count)
+{
+    BVHNode &n = tree[node];
+    if (count <= leaf_size)
+    {
+        n.right = -1;
+        n.first = first;
+        n.count = count;
+        for (int d = 0; d < 3; d++)
+        {
+            n.lo[d] = std::numeric_limits<double>::max();
+            n.hi[d] = -std::numeric_limits<double>::max();
+        }
+        for (int i = first; i < first + count; i++)
+        {
+            const double *box = &boxes[6*order[i]];
+            for (int d = 0; d < 3; d++)
+            {
+                n.lo[d] = std::min(n.lo[d], box[d]);
+                n.hi[d] = std::max(n.hi[d], box[3 + d]);
+            }
+        }
+        return;
+    }
+
+    // the subtrees occupy consecutive ranges of the node array, so they can be built independently
+    const int half = count / 2;
+    const int left = node + 1;
+    const int right = node + 1 + SubtreeSize(half);
+    #pragma omp task if (count > 4096)
+    BuildNode(left, first, half);
+    #pragma omp task if (count > 4096)
+    BuildNode(right, first + half, count - half);
+    #pragma omp taskwait
+
+    n.right = right;
+    n.first = first;
+    n.count = 0;
+    for (int d = 0; d < 3; d++)
+    {
+        n.lo[d] = std::min(tree[left].lo[d], tree[right].lo[d]);
+        n.hi[d] = std::max(tree[left].hi[d], tree[right].hi[d]);
+    }
+}
+
+PointLocation Locator::Locate(Mesh &mesh, const double *x) const
+{
+    PointLocation loc;
+    mesh.DispatchBlock(mesh.ElemType(), [&](auto &block) { loc = Search(block, x); });
+    return loc;
+}
+
+std::vector<PointLocation> Locator::Locate(Mesh &mesh, const Eigen::Ref<const Eigen::MatrixXd> &points) const
+{
+    Assert(points.rows() == n_dims, "points have %d coordinates in a %dD mesh", static_cast<int>(points.rows()), n_dims);
+    std::vector<PointLocation> locs(points.cols());
+    mesh.DispatchBlock(mesh.ElemType(), [&](auto &block)
+    {
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (int p = 0; p < static_cast<int>(points.cols()); p++)
+        {
+            locs[p] = Search(block, points.col(p).data());
+        }
+    });
+    return locs;
+}
+
+InterpolationMatrix Locator::Interpolation(Mesh &mesh, const std::vector<PointLocation> &locations) const
+{
+    InterpolationMatrix P(static_cast<int>(locations.size()), mesh.NumNodes());
+    mesh.DispatchBlock(mesh.ElemType(), [&](auto &block)
+    {
+        typedef typename std::decay_t<decltype(block)>::ElemType T;
+        typedef Shape<T::Basis::type> S;
+        P.reserve(Eigen::VectorXi::Constant(P.rows(), S::n_nodes));
+        for (int p = 0; p < static_cast<int>(locations.size()); p++)
+        {
+            const PointLocation &loc = locations[p];
+            if (loc.elem < 0) { continue; }
+            double xi[S::dim], N[S::n_nodes], dN[S::n_nodes][S::dim];
+            for (int d = 0; d < S::dim; d++) { xi[d] = loc.xi[d]; }
+            S::Eval(xi, N, dN);
+            for (int a = 0; a < S::n_nodes; a++)
+            {
+                P.coeffRef(p, block.elems[loc.elem].Nodes(a).node_id) += N[a];
+            }
+        }
+    });
+    P.makeCompressed();
+    return P;
+}
+
+template<typename T>
+PointLocation Locator::Search(ElementBlock<T> &block, const double *x) const
+{
+    PointLocation loc;
+    if (tree.empty()) { return loc; }
+    double X[3] = {0.0, 0.0, 0.0};
+    for (int d = 0; d < n_dims; d++) { X[d] = x[d]; }
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const BVHNode &n = tree[stack[--top]];
+        bool inside = true;
+        for (int d = 0; d < 3; d++) { inside = inside && X[d] >= n.lo[d] && X[d] <= n.hi[d]; }
+        if (!inside) { continue; }
+        if (n.count == 0)
+        {
+            stack[top++] = n.right;
+            stack[top++] = static_cast<int>(&n - tree.data()) + 1;
+            continue;
+        }
+        for (int i = n.first; i < n.first + n.count; i++)
+        {
+            const int e = order[i];
+            const double *box = &boxes[6*e];
+            bool in_box = true;
+            for (int d = 0; d < 3; d++) { in_box = in_box && X[d] >= box[d] && X[d] <= box[3 + d]; }
+            if (in_box && InverseMap(block.elems[e], X, loc.xi))
+            {
+                loc.elem = e;
+                return loc;
+            }
+        }
+    }
+    loc.xi = {};
+    return loc;
+}
+
+template<typename T>
+bool Locator::InverseMap(T &elem, const double *x, std::array<double, 3> &xi)
+{
+    typedef Shape<T::Basis::type> S;
+    constexpr int dim = S::dim;
+    constexpr bool simplex = SimplexReference<T>();
+    const Eigen::Vector3d X(x[0], x[1], x[2]);
+
+    // newton iterations on x(xi) = sum_a N_a(xi) x_a from the center of the reference element
+    double r[dim];
+    for (int d = 0; d < dim; d++) { r[d] = simplex ? 1.0 / (dim + 1) : 0.0; }
+    for (int it = 0; it < 20; it++)
+    {
+        double N[S::n_nodes], dN[S::n_nodes][dim];
+        S::Eval(r, N, dN);
+        Eigen::Vector3d xr = Eigen::Vector3d::Zero();
+        Eigen::Matrix<double, 3, dim> J = Eigen::Matrix<double, 3, dim>::Zero();
+        for (int a = 0; a < S::n_nodes; a++)
+        {
+            xr += N[a]*elem.Nodes(a).coords;
+            for (int d = 0; d < dim; d++) { J.col(d) += dN[a][d]*elem.Nodes(a).coords; }
+        }
+        const Eigen::Matrix<double, dim, dim> JtJ = J.transpose()*J;
+        const Eigen::Matrix<double, dim, 1> step = JtJ.inverse()*(J.transpose()*(X - xr));
+        for (int d = 0; d < dim; d++) { r[d] += step(d); }
+        if (step.norm() < 1e-12) { break; }
+    }
+
+    constexpr double tol = 1e-10;
+    bool inside = true;
+    double sum = 0.0;
+    for (int d = 0; d < dim; d++)
+    {
+        inside = inside && (simplex ? r[d] >= -tol : std::abs(r[d]) <= 1.0 + tol);
+        sum += r[d];
+    }
+    if (simplex) { inside = inside && sum <= 1.0 + tol; }
+    for (int d = 0; d < 3; d++) { xi[d] = (d < dim) ? r[d] : 0.0; }
+    return inside;
+}
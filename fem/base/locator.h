@@ -0,0 +1,105 @@
+#ifndef LOCATOR_INCL
+#define LOCATOR_INCL
+
+#include "mesh.h"
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Sparse>
+
+#include <array>
+#include <vector>
+
+/** @brief element containing a point and the reference coordinates of the point in it */
+struct PointLocation
+{
+    int elem = -1;                      /** @brief domain element containing the point, -1 if outside the mesh */
+    std::array<double, 3> xi = {};      /** @brief reference coordinates.  for LinTri and LinTet the shape
+                                         * function values (1 - xi_1 - ... - xi_d, xi_1, ..., xi_d) are the
+                                         * barycentric coordinates */
+};
+
+/** @brief maps nodal values to values at a set of points.  one row per point, with the shape function values of its element */
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor> InterpolationMatrix;
+
+/**
+ * @brief bounding volume hierarchy over the domain elements for point location.  like the mesh topology
+ * it covers the block of mesh.ElemType(), and element indices are indices into that block.  elements are
+ * sorted along a morton curve of their centroids and the tree splits the sorted list in halves, so it is
+ * balanced and a query visits O(log n) nodes.  the boxes, codes and subtrees are built in parallel.  a
+ * point is located in an element by inverting the element map with newton iterations on the reference
+ * basis, which is exact after one iteration for linear simplices.
+ */
+class Locator
+{
+    public:
+        Locator() = default;
+
+        /**
+         * @brief build the hierarchy over the domain elements.  rebuild after the mesh changed
+         * @param mesh mesh with its element blocks read in
+         */
+        void Build(Mesh &mesh);
+
+        /**
+         * @brief locate a single point
+         * @param mesh mesh passed to Build
+         * @param x point coordinates, mesh.Dim() values
+         * @return containing element and reference coordinates
+         */
+        PointLocation Locate(Mesh &mesh, const double *x) const;
+
+        /**
+         * @brief locate a batch of points in parallel
+         * @param mesh mesh passed to Build
+         * @param points one column per point, mesh.Dim() rows
+         * @return location of each point
+         */
+        std::vector<PointLocation> Locate(Mesh &mesh, const Eigen::Ref<const Eigen::MatrixXd> &points) const;
+
+        /**
+         * @brief interpolation from the nodes to located points.  values at the points of all species at
+         * once are P*U, with U the nodal values with one column per species.  points outside the mesh get
+         * an empty row, i.e. zero.
+         * @param mesh mesh passed to Build
+         * @param locations located points
+         * @return interpolation matrix P, one row per point
+         */
+        InterpolationMatrix Interpolation(Mesh &mesh, const std::vector<PointLocation> &locations) const;
+
+    private:
+        /** @brief node of the hierarchy.  leaves hold the range [first, first + count) of the sorted elements */
+        struct BVHNode
+        {
+            double lo[3];   /** @brief lower corner of the bounding box */
+            double hi[3];   /** @brief upper corner of the bounding box */
+            int right;      /** @brief right child.  the left child is the next node */
+            int first;      /** @brief first sorted element of a leaf */
+            int count;      /** @brief number of elements of a leaf, 0 for inner nodes */
+        };
+
+        /** @brief number of tree nodes over count elements */
+        static int SubtreeSize(const int &count);
+
+        /** @brief build the subtree at node over the sorted elements [first, first + count) */
+        void BuildNode(const int &node, const int &first, const int &count);
+
+        /** @brief search the hierarchy for the element of a block containing x */
+        template<typename T>
+        PointLocation Search(ElementBlock<T> &block, const double *x) const;
+
+        /**
+         * @brief invert the element map at x
+         * @return true if x is inside the element
+         */
+        template<typename T>
+        static bool InverseMap(T &elem, const double *x, std::array<double, 3> &xi);
+
+    private:
+        static constexpr int leaf_size = 4;     /** @brief maximum number of elements in a leaf */
+        int n_dims = 0;                         /** @brief spatial dimension of the mesh */
+        std::vector<double> boxes;              /** @brief bounding box of each element, lo[3] then hi[3] */
+        std::vector<int> order;                 /** @brief elements sorted along the morton curve */
+        std::vector<BVHNode> tree;              /** @brief hierarchy, root first */
+};
+
+#endif // LOCATOR_INCL
@@ -0,0 +1,74 @@
+#include "memory.h"
+#include "logger/logger.h"
+
+#include <eigen/Eigen/OrderingMethods>
+
+#include <algorithm>
+#include <numeric>
+
+#include <sys/resource.h>
+
+std::size_t CholeskyNonZeros(const Eigen::SparseMatrix<double, Eigen::ColMajor> &A)
+{
+    // the ordering and permuted upper triangle of SimplicialLDLT<SparseMatrix, Eigen::Upper>
+    const int n = static_cast<int>(A.rows());
+    Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> P_inv;
+    Eigen::AMDOrdering<int> ordering;
+    ordering(A.selfadjointView<Eigen::Upper>(), P_inv);
+    const Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> P = P_inv.inverse();
+    Eigen::SparseMatrix<double, Eigen::ColMajor> ap(n, n);
+    ap.selfadjointView<Eigen::Upper>() = A.selfadjointView<Eigen::Upper>().twistedBy(P);
+
+    // row k of L is the part of the elimination tree reached from the nonzeros of column k of ap
+    std::vector<int> parent(n, -1), tag(n), count(n, 0);
+    for (int k = 0; k < n; k++)
+    {
+        tag[k] = k;
+        for (Eigen::SparseMatrix<double, Eigen::ColMajor>::InnerIterator it(ap, k); it; ++it)
+        {
+            for (int i = static_cast<int>(it.index()); i < k && tag[i] != k; i = parent[i])
+            {
+                if (parent[i] == -1) { parent[i] = k; }
+                count[i]++;
+                tag[i] = k;
+            }
+        }
+    }
+    return std::accumulate(count.begin(), count.end(), std::size_t(0));
+}
+
+void MemoryTracker::Set(const MemoryUse &use, const std::size_t &bytes)
+{
+    const int i = static_cast<int>(use);
+    current[i] = bytes;
+    peak[i] = std::max(peak[i], bytes);
+    peak_total = std::max(peak_total, Total());
+}
+
+std::size_t MemoryTracker::Total() const
+{
+    return std::accumulate(current.begin(), current.end(), std::size_t(0));
+}
+
+void MemoryTracker::Report() const
+{
+    static const char* names[n_memory_uses] = {"mesh", "geometry", "matrices", "factorization", "krylov"};
+    constexpr double MB = 1024.0*1024.0;
+    for (int i = 0; i < n_memory_uses; i++)
+    {
+        INFO("memory %-14s %10.2f MB, peak %10.2f MB", names[i], current[i] / MB, peak[i] / MB);
+    }
+    INFO("memory total          %10.2f MB, peak %10.2f MB, resident peak of the process %.2f MB", Total() / MB, peak_total / MB,
+         ResidentPeak() / MB);
+}
+
+std::size_t MemoryTracker::ResidentPeak()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss);       // bytes on macOS
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss)*1024;  // kilobytes on linux
+#endif
+}
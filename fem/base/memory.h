@@ -0,0 +1,91 @@
+#ifndef MEMORY_INCL
+#define MEMORY_INCL
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Sparse>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/** @brief subsystems whose memory is tracked */
+typedef enum class MemoryUse
+{
+    Mesh,           // nodes, connectivity and topology
+    Geometry,       // element objects with their cached element matrices, scatter maps and matrix-free element geometry
+    Matrices,       // assembled matrices, their sparsity pattern and vectorized copies
+    Factorization,  // factors of direct solvers and coarse level factorizations, with their orderings
+    Krylov          // iterative solver work vectors, preconditioner diagonals and recycled solutions
+} MemoryUse;
+
+static constexpr int n_memory_uses = 5;
+
+/** @brief bytes held by a vector */
+template<typename T>
+inline std::size_t Bytes(const std::vector<T> &v) { return v.capacity()*sizeof(T); }
+
+/** @brief bytes held by a dense eigen vector or matrix */
+template<typename Derived>
+inline std::size_t Bytes(const Eigen::PlainObjectBase<Derived> &m) { return m.size()*sizeof(typename Derived::Scalar); }
+
+/** @brief bytes held by a compressed eigen sparse matrix */
+template<typename Scalar>
+inline std::size_t Bytes(const Eigen::SparseMatrix<Scalar, Eigen::ColMajor> &A)
+{
+    return A.nonZeros()*(sizeof(Scalar) + sizeof(int)) + (A.outerSize() + 1)*sizeof(int);
+}
+
+/** @brief bytes held by an eigen simplicial cholesky solver: the factor, its diagonal, the orderings and the elimination tree */
+template<typename Factorization>
+inline std::size_t FactorBytes(const Factorization &f)
+{
+    if (f.rows() == 0) { return 0; }
+    const std::size_t n = f.rows();
+    return Bytes(f.matrixL().nestedExpression()) + n*sizeof(typename Factorization::Scalar) + 4*n*sizeof(int);
+}
+
+/**
+ * @brief nonzeros of the factor L of the LDLT factorization of a symmetric matrix, by the symbolic analysis of
+ * the direct solver: the same approximate minimum degree ordering of the upper triangle, then the column
+ * counts from the elimination tree.  needs O(n) memory besides a reordered copy of A, so the fill is known
+ * before it is allocated.
+ * @param A matrix of which the upper triangle is read, values are ignored
+ */
+std::size_t CholeskyNonZeros(const Eigen::SparseMatrix<double, Eigen::ColMajor> &A);
+
+/**
+ * @brief current and peak bytes of every MemoryUse.  the owners of the memory report what they hold whenever
+ * it may have changed, so the peaks are high-water marks of the memory at the times it was reported.
+ */
+class MemoryTracker
+{
+    public:
+        MemoryTracker() = default;
+
+        /** @brief set the bytes currently held by a subsystem and update its peak and the peak of the total */
+        void Set(const MemoryUse &use, const std::size_t &bytes);
+
+        inline std::size_t Current(const MemoryUse &use) const { return current[static_cast<int>(use)]; }
+
+        /** @brief high-water mark of a subsystem */
+        inline std::size_t Peak(const MemoryUse &use) const { return peak[static_cast<int>(use)]; }
+
+        /** @brief bytes currently held by all subsystems */
+        std::size_t Total() const;
+
+        /** @brief high-water mark of the total, at most the sum of the peaks */
+        inline std::size_t PeakTotal() const { return peak_total; }
+
+        /** @brief log the current and peak bytes of every subsystem and the peak resident size of the process */
+        void Report() const;
+
+        /** @brief peak resident size of the process as seen by the operating system, 0 if unknown */
+        static std::size_t ResidentPeak();
+
+    private:
+        std::array<std::size_t, n_memory_uses> current{};   /** @brief bytes held by each subsystem */
+        std::array<std::size_t, n_memory_uses> peak{};      /** @brief high-water mark of each subsystem */
+        std::size_t peak_total = 0;                         /** @brief high-water mark of the total */
+};
+
+#endif // MEMORY_INCL
@@ -1,22 +1,173 @@
 #include "mesh.h"
-#include "elements/linline.h"
-#include "elements/lintri.h"
-#include "elements/lintet.h"
-#include "elements/nullelem.h"
 #include "logger/logger.h"
 
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <numeric>
 #include <unordered_map>
 #include <tuple>
+#include <type_traits>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /** @brief an element type of gmsh, with the node of the gmsh element at each local node of ours */
+    struct GmshElement
+    {
+        int n_nodes;            /** @brief nodes per element, 0 for unknown types */
+        ElementType type;       /** @brief element type, NoType for points and unsupported types */
+        std::array<int, 9> perm; /** @brief gmsh node of every local node */
+    };
+
+    /** @brief element types by gmsh type number, up to the 5 node pyramid of second order */
+    const GmshElement& GmshType(const int &gmsh_type)
+    {
+        static const GmshElement unknown{0, ElementType::NoType, {}};
+        static const GmshElement types[] = {
+            unknown,
+            {2, ElementType::LinLine, {0, 1}},
+            {3, ElementType::LinTri, {0, 1, 2}},
+            {4, ElementType::LinQuad, {0, 1, 3, 2}},            // counter-clockwise to the comsol ordering
+            {4, ElementType::LinTet, {0, 1, 2, 3}},
+            {8, ElementType::NoType, {}},                       // hexahedron
+            {6, ElementType::NoType, {}},                       // prism
+            {5, ElementType::NoType, {}},                       // pyramid
+            {3, ElementType::QuadLine, {0, 1, 2}},
+            {6, ElementType::QuadTri, {0, 1, 2, 3, 5, 4}},      // edge midpoints 0-1, 1-2, 2-0 to 0-1, 0-2, 1-2
+            {9, ElementType::QuadQuad, {0, 4, 1, 7, 8, 5, 3, 6, 2}}, // corners, edges, center to the lexicographic grid
+            {10, ElementType::NoType, {}},                      // quadratic tetrahedron
+            {27, ElementType::NoType, {}},
+            {18, ElementType::NoType, {}},
+            {14, ElementType::NoType, {}},
+            {1, ElementType::NoType, {0}},                      // point
+            {8, ElementType::NoType, {}},
+            {20, ElementType::NoType, {}},
+            {15, ElementType::NoType, {}},
+            {13, ElementType::NoType, {}}
+        };
+        return (gmsh_type > 0 && gmsh_type < static_cast<int>(std::size(types))) ? types[gmsh_type] : unknown;
+    }
+
+    /**
+     * @brief reads a mapped gmsh file.  text lines are read as they are, binary values in bulk with a memcpy
+     * and a byte swap if the file was written with the other byte order.  size_t values of the writer, 4 or
+     * 8 bytes, are widened to 64 bits
+     */
+    class GmshCursor
+    {
+        public:
+            GmshCursor(const char *begin, const std::size_t &n_bytes, const std::string &file_name)
+            : pos{begin}, end{begin + n_bytes}, file_name{file_name} {}
+
+            inline bool End() const { return pos >= end; }
+
+            /** @brief set the byte order and width of the binary values */
+            inline void SetBinary(const bool &swap, const int &size_bytes) { this->swap = swap; this->size_bytes = size_bytes; }
+
+            /** @brief the next line without its line break */
+            std::string Line()
+            {
+                const char *eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+                if (eol == nullptr) { eol = end; }
+                std::string line(pos, eol - pos);
+                pos = std::min(eol + 1, end);
+                if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+                return line;
+            }
+
+            /** @brief skip the line break after binary data and check the line closing a section */
+            void Expect(const std::string &line)
+            {
+                std::string read;
+                while (!End() && (read = Line()).empty()) {}
+                Assert(read == line, "expected %s in %s, found %s", line.c_str(), file_name.c_str(), read.c_str());
+            }
+
+            /** @brief skip to the line after the end of a section */
+            void Skip(const std::string &line)
+            {
+                while (!End() && Line() != line) {}
+            }
+
+            /** @brief n values of a 4 or 8 byte type */
+            template<typename T>
+            void Read(T *out, const std::size_t &n)
+            {
+                static_assert(sizeof(T) == 4 || sizeof(T) == 8, "binary values of 4 or 8 bytes");
+                Assert(n*sizeof(T) <= static_cast<std::size_t>(end - pos), "%s ends in the middle of a block", file_name.c_str());
+                std::memcpy(out, pos, n*sizeof(T));
+                pos += n*sizeof(T);
+                if (!swap) { return; }
+                typedef std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> Bits;
+                Bits *bits = reinterpret_cast<Bits*>(out);
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    if constexpr (sizeof(T) == 4) { bits[i] = __builtin_bswap32(bits[i]); }
+                    else { bits[i] = __builtin_bswap64(bits[i]); }
+                }
+            }
+
+            template<typename T>
+            inline T Get()
+            {
+                T value;
+                Read(&value, 1);
+                return value;
+            }
+
+            /** @brief n size_t values of the writer */
+            void ReadSizes(std::int64_t *out, const std::size_t &n)
+            {
+                if (size_bytes == 8)
+                {
+                    Read(out, n);
+                    return;
+                }
+                // widened in place from the back, so the 4 byte values are not overwritten before they are read
+                std::int32_t *narrow = reinterpret_cast<std::int32_t*>(out);
+                Read(narrow, n);
+                for (std::size_t i = n; i-- > 0; ) { out[i] = static_cast<std::uint32_t>(narrow[i]); }
+            }
+
+            inline std::int64_t GetSize()
+            {
+                std::int64_t value;
+                ReadSizes(&value, 1);
+                return value;
+            }
+
+        private:
+            const char *pos;            /** @brief next byte to read */
+            const char *end;            /** @brief end of the mapped file */
+            std::string file_name;      /** @brief file name for the error messages */
+            bool swap = false;          /** @brief binary values have the other byte order */
+            int size_bytes = 8;         /** @brief bytes of a size_t of the writer */
+    };
+}
+
 void Mesh::ReadMesh(const std::string &mesh_file)
 {
+    if (mesh_file.size() > 4 && mesh_file.compare(mesh_file.size() - 4, 4, ".msh") == 0)
+    {
+        ReadGmsh(mesh_file);
+        return;
+    }
     std::cout << "reading mesh file" << "\n";
     std::ifstream in_file;
     in_file.open(mesh_file);
 
+    std::string type_name;              // comsol name of the element block being read
+    int block_npe = 0;                  // number of vertices per element of the block being read
+    int block_n_elems = 0;              // number of elements of the block being read
+    std::vector<int> conn;              // connectivity of the block being read
     for (std::string line; std::getline(in_file, line); )
     {
         //std::cout << "line: " << line << "\n";
@@ -31,7 +182,7 @@ void Mesh::ReadMesh(const std::string &mesh_file)
         if (line.find("# number of mesh vertices") != std::string::npos)
         {   
             n_nodes = std::stod(line.substr(0, line.find(" ")));
-            nodes.reserve(sizeof(Node*)*n_nodes);
+            nodes.reserve(n_nodes);
             std::cout << "n_nodes: " << n_nodes << "\n";
         }
 
@@ -57,55 +208,566 @@ void Mesh::ReadMesh(const std::string &mesh_file)
             }
         }
 
-        // get number of elements and element connectivity
-        // NOTE: this is element specific.  the "3" only works for triangles.  need to fix
-        if (line.find("3 # number of vertices per element") != std::string::npos)
+        // start of an element block, e.g. "3 tri # type name"
+        if (line.find("# type name") != std::string::npos)
         {
-            std::cout << line << "\n";
-            std::getline(in_file, line);
-            n_elems = std::stod(line.substr(0, line.find(" ")));
-            AllocateElements();
-            std::cout << "n_elems: " << n_elems << "\n";
+            std::istringstream iss(line);
+            int name_len;
+            iss >> name_len >> type_name;
+        }
+
+        if (line.find("# number of vertices per element") != std::string::npos)
+        {
+            block_npe = std::stoi(line.substr(0, line.find(" ")));
+        }
+
+        // element connectivity of the block
+        if (line.find("# number of elements") != std::string::npos)
+        {
+            block_n_elems = std::stoi(line.substr(0, line.find(" ")));
+            std::cout << type_name << " elements: " << block_n_elems << "\n";
             std::getline(in_file, line); // skip a line because of the way comsol file is formatted
-            for (int e = 0; e < n_elems; e++)
+            conn.resize(block_n_elems*block_npe);
+            for (int e = 0; e < block_n_elems; e++)
             {
-                elems.emplace_back(CreateElement());
-                Assert(elems[e]->type_str != "NullType", "element type is null");
-                elems[e]->elem_id = e;
                 std::getline(in_file, line);
                 std::istringstream iss(line);
-                int i = 0;
-                std::string node_num;
-                while (std::getline(iss, node_num, ' ')) 
-                {   
-                    elems[e]->Nodes(i) = *(nodes.at(std::stoi(node_num)));
-                    //std::cout << elems[e]->Nodes(i).node_id << "\n";
-                    //elems[e]->Nodes(i).NodeType();
-                    for (int j = 0; j < n_dims; j++)
-                    {
-                        //std::cout << nodes[std::stoi(node_num)]->Coords(j) << " ";
-                        elems[e]->Nodes(i).Coords(j) = nodes[std::stoi(node_num)]->Coords(j);
-                        //std::cout << elems[e]->Nodes(i).Coords(j) << " ";
-                    }
-                    //std::cout << "\n";
-                    i++;
-                }
+                for (int i = 0; i < block_npe; i++) { iss >> conn[e*block_npe + i]; }
+            }
+        }
+
+        // geometric entity indices close the block, so store it in the matching element block
+        if (line.find("# number of geometric entity indices") != std::string::npos)
+        {
+            const int n_geom = std::stoi(line.substr(0, line.find(" ")));
+            Assert(n_geom == block_n_elems, "%d geometric entity indices for %d elements", n_geom, block_n_elems);
+            std::getline(in_file, line); // skip a line because of the way comsol file is formatted
+            std::vector<int> geom(n_geom);
+            for (int e = 0; e < n_geom; e++)
+            {
+                std::getline(in_file, line);
+                geom[e] = std::stoi(line);
+            }
+
+            ElementType type = ComsolType(type_name);
+            if (type_name == "vtx")
+            {
+                vtx = conn;
+                vtx_geom_idx = geom;
+            }
+            else if (type == ElementType::NoType)
+            {
+                WARN("skipping unsupported element block %s", type_name.c_str());
+            }
+            else
+            {
+                StoreBlock(type, block_npe, conn, geom);
             }
         }
     } // loop over mesh file lines
     std::cout << "finished mesh loop" << "\n";
     in_file.close();
+
+    n_elems = 0;
+    DispatchBlock(elem_type, [&](auto &block) { n_elems = block.Size(); });
+    Assert(n_elems > 0, "mesh file has no elements of the type given in the condition file");
+    std::cout << "n_elems: " << n_elems << "\n";
+    InvalidateTopology();
+}
+
+void Mesh::ReadGmsh(const std::string &mesh_file)
+{
+    std::cout << "reading gmsh file" << "\n";
+    const int fd = open(mesh_file.c_str(), O_RDONLY);
+    Assert(fd >= 0, "could not open mesh file %s", mesh_file.c_str());
+    struct stat st;
+    Assert(fstat(fd, &st) == 0 && st.st_size > 0, "could not read the size of mesh file %s", mesh_file.c_str());
+    const std::size_t n_bytes = st.st_size;
+    void *addr = mmap(nullptr, n_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    Assert(addr != MAP_FAILED, "could not map mesh file %s", mesh_file.c_str());
+    madvise(addr, n_bytes, MADV_SEQUENTIAL);
+    GmshCursor in(static_cast<const char*>(addr), n_bytes, mesh_file);
+
+    // the nodes of the file are created for the spatial dimension of the domain elements
+    DispatchBlock(elem_type, [&](auto &block) { n_dims = block.Dim(); });
+    std::cout << "n_dims: " << n_dims << "\n";
+
+    std::array<std::unordered_map<int, int>, 4> entity_geom;   // geometric entity index of the entities of each dimension
+    std::int64_t min_tag = 0;                                   // node tag of node_index[0]
+    std::vector<int> node_index;                                // node of every tag from min_tag, -1 for unused tags
+    std::vector<std::vector<int>> conn(static_cast<int>(ElementType::Last)), geom(static_cast<int>(ElementType::Last));
+    std::vector<std::int64_t> tags;
+    std::vector<double> coords;
+    bool format_read = false;
+    while (!in.End())
+    {
+        const std::string section = in.Line();
+        if (section.empty()) { continue; }
+        Assert(section[0] == '$', "expected a section of %s, found %s", mesh_file.c_str(), section.c_str());
+        const std::string end_section = "$End" + section.substr(1);
+
+        if (section == "$MeshFormat")
+        {
+            double version;
+            int file_type, size_bytes;
+            std::istringstream iss(in.Line());
+            iss >> version >> file_type >> size_bytes;
+            Assert(version >= 4.1 && version < 5.0, "%s is a gmsh %g file, the reader needs version 4.1", mesh_file.c_str(), version);
+            Assert(file_type == 1, "%s is an ascii gmsh file, the reader needs a binary one", mesh_file.c_str());
+            Assert(size_bytes == 4 || size_bytes == 8, "%s has a size_t of %d bytes", mesh_file.c_str(), size_bytes);
+            // the writer stores a 1 in its byte order
+            const std::int32_t one = in.Get<std::int32_t>();
+            Assert(one == 1 || __builtin_bswap32(one) == 1, "%s has an unknown byte order", mesh_file.c_str());
+            in.SetBinary(one != 1, size_bytes);
+            format_read = true;
+        }
+        else if (section == "$PhysicalNames")
+        {
+            // dimension, tag and name, in text also in binary files
+            const int n_names = std::stoi(in.Line());
+            for (int k = 0; k < n_names; k++)
+            {
+                std::istringstream iss(in.Line());
+                int dim, tag;
+                std::string name;
+                iss >> dim >> tag;
+                std::getline(iss >> std::ws, name);
+                INFO("physical group %d of dimension %d: %s", tag, dim, name.c_str());
+            }
+        }
+        else if (section == "$Entities")
+        {
+            Assert(format_read, "%s has no mesh format before its entities", mesh_file.c_str());
+            std::int64_t n_entities[4];
+            in.ReadSizes(n_entities, 4);
+            std::vector<std::int32_t> ints;
+            for (int dim = 0; dim < 4; dim++)
+            {
+                for (std::int64_t k = 0; k < n_entities[dim]; k++)
+                {
+                    // tag, the point or the bounding box, the physical groups and for curves and up the bounding entities
+                    const int tag = in.Get<std::int32_t>();
+                    double box[6];
+                    in.Read(box, dim == 0 ? 3 : 6);
+                    ints.resize(in.GetSize());
+                    in.Read(ints.data(), ints.size());
+                    entity_geom[dim][tag] = ints.empty() ? tag : ints[0];
+                    if (dim == 0) { continue; }
+                    ints.resize(in.GetSize());
+                    in.Read(ints.data(), ints.size());
+                }
+            }
+        }
+        else if (section == "$Nodes")
+        {
+            Assert(format_read, "%s has no mesh format before its nodes", mesh_file.c_str());
+            std::int64_t header[4];
+            in.ReadSizes(header, 4);
+            const std::int64_t n_blocks = header[0];
+            n_nodes = static_cast<int>(header[1]);
+            min_tag = header[2];
+            node_index.assign(std::max<std::int64_t>(header[3] - min_tag + 1, 0), -1);
+            coords.resize(3*static_cast<std::size_t>(n_nodes));
+            std::cout << "n_nodes: " << n_nodes << "\n";
+
+            int first = 0;
+            for (std::int64_t b = 0; b < n_blocks; b++)
+            {
+                const int entity_dim = in.Get<std::int32_t>();
+                in.Get<std::int32_t>();
+                const int parametric = in.Get<std::int32_t>();
+                const int n_block = static_cast<int>(in.GetSize());
+                Assert(first + n_block <= n_nodes, "%s has more nodes than its header", mesh_file.c_str());
+                tags.resize(n_block);
+                in.ReadSizes(tags.data(), n_block);
+                for (int k = 0; k < n_block; k++) { node_index.at(tags[k] - min_tag) = first + k; }
+                // x, y, z and the parametric coordinates of the node on its entity
+                if (parametric == 0) { in.Read(coords.data() + 3*first, 3*static_cast<std::size_t>(n_block)); }
+                else
+                {
+                    const int stride = 3 + entity_dim;
+                    std::vector<double> with_parametric(static_cast<std::size_t>(stride)*n_block);
+                    in.Read(with_parametric.data(), with_parametric.size());
+                    for (int k = 0; k < n_block; k++)
+                    {
+                        std::copy_n(with_parametric.begin() + k*stride, 3, coords.begin() + 3*(first + k));
+                    }
+                }
+                first += n_block;
+            }
+            Assert(first == n_nodes, "%s has %d nodes in its blocks and %d in its header", mesh_file.c_str(), first, n_nodes);
+
+            for (Node* n : nodes) { delete n; }
+            nodes.resize(n_nodes);
+            #pragma omp parallel for schedule(static)
+            for (int n = 0; n < n_nodes; n++)
+            {
+                nodes[n] = CreateNode();
+                nodes[n]->node_id = n;
+                for (int j = 0; j < n_dims; j++) { nodes[n]->Coords(j) = coords[3*n + j]; }
+            }
+        }
+        else if (section == "$Elements")
+        {
+            Assert(!node_index.empty(), "%s has no nodes before its elements", mesh_file.c_str());
+            std::int64_t header[4];
+            in.ReadSizes(header, 4);
+            const std::int64_t n_blocks = header[0];
+            for (std::int64_t b = 0; b < n_blocks; b++)
+            {
+                const int entity_dim = in.Get<std::int32_t>();
+                const int entity_tag = in.Get<std::int32_t>();
+                const int gmsh_type = in.Get<std::int32_t>();
+                const int n_block = static_cast<int>(in.GetSize());
+                const GmshElement &elem = GmshType(gmsh_type);
+                Assert(elem.n_nodes > 0, "%s has elements of the unknown gmsh type %d", mesh_file.c_str(), gmsh_type);
+
+                // the tag and the nodes of every element
+                const int stride = 1 + elem.n_nodes;
+                tags.resize(static_cast<std::size_t>(stride)*n_block);
+                in.ReadSizes(tags.data(), tags.size());
+                const bool point = gmsh_type == 15;
+                if (elem.type == ElementType::NoType && !point)
+                {
+                    WARN("skipping %d elements of the unsupported gmsh type %d", n_block, gmsh_type);
+                    continue;
+                }
+                auto it = entity_geom[entity_dim].find(entity_tag);
+                const int geom_idx = (it == entity_geom[entity_dim].end()) ? entity_tag : it->second;
+                std::vector<int> &block_conn = point ? vtx : conn[static_cast<int>(elem.type)];
+                std::vector<int> &block_geom = point ? vtx_geom_idx : geom[static_cast<int>(elem.type)];
+                const std::size_t offset = block_conn.size();
+                block_conn.resize(offset + static_cast<std::size_t>(elem.n_nodes)*n_block);
+                block_geom.resize(block_geom.size() + n_block, geom_idx);
+                const std::int64_t n_tags = static_cast<std::int64_t>(node_index.size());
+                int n_unknown = 0;
+                #pragma omp parallel for schedule(static) reduction(+: n_unknown)
+                for (int e = 0; e < n_block; e++)
+                {
+                    for (int i = 0; i < elem.n_nodes; i++)
+                    {
+                        const std::int64_t k = tags[static_cast<std::size_t>(e)*stride + 1 + elem.perm[i]] - min_tag;
+                        const int n = (k >= 0 && k < n_tags) ? node_index[k] : -1;
+                        block_conn[offset + static_cast<std::size_t>(e)*elem.n_nodes + i] = n;
+                        n_unknown += n < 0;
+                    }
+                }
+                Assert(n_unknown == 0, "%s has %d element nodes that are not in its nodes", mesh_file.c_str(), n_unknown);
+            }
+        }
+        else
+        {
+            in.Skip(end_section);
+            continue;
+        }
+        in.Expect(end_section);
+    }
+    munmap(addr, n_bytes);
+
+    for (int t = 0; t < static_cast<int>(ElementType::Last); t++)
+    {
+        if (geom[t].empty()) { continue; }
+        const ElementType type = static_cast<ElementType>(t);
+        DispatchBlock(type, [&](auto &block)
+        {
+            StoreBlock(type, block.NPE(), conn[t], geom[t]);
+            std::cout << block.elems[0].type_str << " elements: " << block.Size() << "\n";
+        });
+    }
+
+    n_elems = 0;
+    DispatchBlock(elem_type, [&](auto &block) { n_elems = block.Size(); });
+    Assert(n_elems > 0, "mesh file has no elements of the type given in the condition file");
+    std::cout << "n_elems: " << n_elems << "\n";
+    InvalidateTopology();
+}
+
+void Mesh::StoreBlock(const ElementType &type, const int &block_npe, const std::vector<int> &conn, const std::vector<int> &geom)
+{
+    DispatchBlock(type, [&](auto &block)
+    {
+        const int block_n_elems = static_cast<int>(geom.size());
+        Assert(block_npe == block.NPE(), "element block of %d vertices per element for elements of %d", block_npe, block.NPE());
+        block.elems.resize(block_n_elems);
+        block.geom_idx = geom;
+        block.cached.assign(block_n_elems, 0);
+        #pragma omp parallel for schedule(static)
+        for (int e = 0; e < block_n_elems; e++)
+        {
+            auto &elem = block.elems[e];
+            elem.elem_id = e;
+            for (int i = 0; i < block_npe; i++)
+            {
+                const int n = conn[e*block_npe + i];
+                elem.Nodes(i).node_id = n;
+                for (int j = 0; j < n_dims; j++)
+                {
+                    elem.Nodes(i).Coords(j) = nodes.at(n)->Coords(j);
+                }
+            }
+        }
+    });
+}
+
+MeshChange Mesh::RefineUniform()
+{
+    Assert((elem_type == ElementType::LinTri && n_dims == 2) || (elem_type == ElementType::LinTet && n_dims == 3),
+           "uniform refinement needs a LinTri mesh in 2D or a LinTet mesh in 3D");
+    MeshChange change;
+    change.node_map.resize(n_nodes);
+    std::iota(change.node_map.begin(), change.node_map.end(), 0);
+
+    // midpoint of every edge, shared by the blocks so boundary facets split like the domain elements
+    std::unordered_map<std::uint64_t, int> midpoints;
+    auto midpoint = [&](const int &a, const int &b)
+    {
+        const std::uint64_t key = (static_cast<std::uint64_t>(std::min(a, b)) << 32) | static_cast<std::uint64_t>(std::max(a, b));
+        auto it = midpoints.find(key);
+        if (it != midpoints.end()) { return it->second; }
+        Node *node = CreateNode();
+        node->node_id = static_cast<int>(nodes.size());
+        for (int j = 0; j < n_dims; j++) { node->Coords(j) = 0.5*(nodes[a]->Coords(j) + nodes[b]->Coords(j)); }
+        nodes.push_back(node);
+        change.new_nodes.push_back({a, b});
+        midpoints[key] = node->node_id;
+        return node->node_id;
+    };
+
+    // children by local index: 0..3 are the vertices and 4 + k the midpoint of local edge k, with edges
+    // (0,1) (0,2) (0,3) (1,2) (1,3) (2,3).  the tetrahedra cut their inner octahedron on the diagonal between
+    // the midpoints of (0,2) and (1,3), as in bey's scheme, so repeated refinement keeps a few shape classes
+    static const int edges[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+    static const int line_children[2][2] = {{0, 4}, {4, 1}};
+    static const int tri_children[4][3] = {{0, 4, 5}, {4, 1, 7}, {5, 7, 2}, {4, 7, 5}};
+    static const int tet_children[8][4] = {{0, 4, 5, 6}, {4, 1, 7, 8}, {5, 7, 2, 9}, {6, 8, 9, 3},
+                                           {4, 5, 6, 8}, {4, 5, 7, 8}, {5, 6, 8, 9}, {5, 7, 8, 9}};
+    ForEachBlock([&](auto &block)
+    {
+        typedef typename std::decay_t<decltype(block)>::ElemType T;
+        constexpr int npe = std::decay_t<decltype(block)>::NPE();
+        const int *children = nullptr;
+        int n_children = 0;
+        if constexpr (std::is_same<T, LinLine>::value) { children = &line_children[0][0]; n_children = 2; }
+        if constexpr (std::is_same<T, LinTri>::value) { children = &tri_children[0][0]; n_children = 4; }
+        if constexpr (std::is_same<T, LinTet>::value) { children = &tet_children[0][0]; n_children = 8; }
+        Assert(children != nullptr, "uniform refinement of %s blocks is not supported", block.elems[0].type_str.c_str());
+
+        ElementBlock<T> refined;
+        refined.elems.reserve(block.Size()*n_children);
+        for (int e = 0; e < block.Size(); e++)
+        {
+            int local[10];
+            for (int a = 0; a < npe; a++) { local[a] = block.elems[e].Nodes(a).node_id; }
+            for (int k = 0; k < 6; k++)
+            {
+                if (edges[k][1] < npe) { local[4 + k] = midpoint(local[edges[k][0]], local[edges[k][1]]); }
+            }
+            for (int c = 0; c < n_children; c++)
+            {
+                int ids[npe];
+                for (int a = 0; a < npe; a++) { ids[a] = local[children[c*npe + a]]; }
+                T child = block.elems[e];
+                SetElementNodes(child, ids);
+                const int idx = refined.Append(child, block.geom_idx[e]);
+                refined.elems[idx].elem_id = idx;
+            }
+        }
+        block = std::move(refined);
+    });
+
+    n_nodes = static_cast<int>(nodes.size());
+    DispatchBlock(elem_type, [&](auto &block) { n_elems = block.Size(); });
+    change.affected.assign(n_nodes, 1);
+    INFO("uniform refinement to %d nodes and %d elements", n_nodes, n_elems);
+    InvalidateTopology();
+    return change;
+}
+
+const Adjacency& Mesh::NodeElements()
+{
+    BuildTopology();
+    return node_elems;
+}
+
+const Adjacency& Mesh::ElementNeighbours()
+{
+    BuildTopology();
+    return elem_neighbours;
+}
+
+const Adjacency& Mesh::NodeNeighbours()
+{
+    BuildTopology();
+    return node_neighbours;
+}
+
+std::size_t Mesh::MemoryBytes(const MemoryUse &use) const
+{
+    std::size_t bytes = 0;
+    if (use == MemoryUse::Mesh)
+    {
+        const std::size_t node_bytes = (n_dims == 1) ? sizeof(Node1D) : (n_dims == 2) ? sizeof(Node2D) : sizeof(Node3D);
+        bytes += Bytes(nodes) + nodes.size()*node_bytes + Bytes(vtx) + Bytes(vtx_geom_idx);
+        for (const Adjacency *adj : {&node_elems, &elem_neighbours, &node_neighbours}) { bytes += Bytes(adj->offset) + Bytes(adj->index); }
+        std::apply([&bytes](const auto &...block) { ((bytes += Bytes(block.geom_idx) + Bytes(block.cached)), ...); }, blocks);
+    }
+    else if (use == MemoryUse::Geometry)
+    {
+        std::apply([&bytes](const auto &...block) { ((bytes += Bytes(block.elems) + Bytes(block.scatter)), ...); }, blocks);
+    }
+    return bytes;
+}
+
+void Mesh::BuildTopology()
+{
+    if (topology_valid) { return; }
+    DispatchBlock(elem_type, [&](auto &block) { BuildTopology(block); });
+    topology_valid = true;
+    DEBUG("topology: %d node-element, %d element-element and %d node-node entries",
+          static_cast<int>(node_elems.index.size()), static_cast<int>(elem_neighbours.index.size()),
+          static_cast<int>(node_neighbours.index.size()));
+}
+
+/** @brief nodes two domain elements of a conforming mesh have in common when they share a facet */
+template<typename T>
+static constexpr int FacetNodes()
+{
+    if constexpr (std::is_same_v<T, LinLine> || std::is_same_v<T, QuadLine>) { return 1; }
+    else if constexpr (std::is_same_v<T, QuadTri> || std::is_same_v<T, QuadQuad> || std::is_same_v<T, LinTet>) { return 3; }
+    else { return 2; }
+}
+
+/**
+ * @brief fill a CSR adjacency whose rows are produced by gather(i, row) into a sorted, duplicate free
+ * scratch vector.  rows are gathered twice, once to count and once to copy, so both passes run in
+ * parallel without per-row storage
+ */
+template<typename F>
+static void FillAdjacency(Adjacency &adj, const int &n, F &&gather)
+{
+    adj.offset.assign(n + 1, 0);
+    #pragma omp parallel
+    {
+        std::vector<int> row;
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            gather(i, row);
+            adj.offset[i + 1] = static_cast<int>(row.size());
+        }
+    }
+    std::partial_sum(adj.offset.begin(), adj.offset.end(), adj.offset.begin());
+    adj.index.resize(adj.offset[n]);
+    #pragma omp parallel
+    {
+        std::vector<int> row;
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            gather(i, row);
+            std::copy(row.begin(), row.end(), adj.index.begin() + adj.offset[i]);
+        }
+    }
+}
+
+template<typename T>
+void Mesh::BuildTopology(ElementBlock<T> &block)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    const int n_el = block.Size();
+
+    // node to element: count, prefix sum and fill with atomic slots, then sort every row so the
+    // result does not depend on the thread schedule
+    Adjacency &ne = node_elems;
+    ne.offset.assign(n_nodes + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int e = 0; e < n_el; e++)
+    {
+        for (int i = 0; i < npe; i++)
+        {
+            #pragma omp atomic
+            ne.offset[block.elems[e].Nodes(i).node_id + 1]++;
+        }
+    }
+    std::partial_sum(ne.offset.begin(), ne.offset.end(), ne.offset.begin());
+    ne.index.resize(ne.offset[n_nodes]);
+    std::vector<int> slot(ne.offset.begin(), ne.offset.end() - 1);
+    #pragma omp parallel for schedule(static)
+    for (int e = 0; e < n_el; e++)
+    {
+        for (int i = 0; i < npe; i++)
+        {
+            int pos;
+            #pragma omp atomic capture
+            pos = slot[block.elems[e].Nodes(i).node_id]++;
+            ne.index[pos] = e;
+        }
+    }
+    #pragma omp parallel for schedule(static)
+    for (int v = 0; v < n_nodes; v++)
+    {
+        std::sort(ne.index.begin() + ne.offset[v], ne.index.begin() + ne.offset[v + 1]);
+    }
+
+    // node to node: the nodes of the elements around a node
+    FillAdjacency(node_neighbours, n_nodes, [&](const int &v, std::vector<int> &row)
+    {
+        row.clear();
+        for (const int *e = ne.Begin(v); e != ne.End(v); e++)
+        {
+            for (int i = 0; i < npe; i++) { row.push_back(block.elems[*e].Nodes(i).node_id); }
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    });
+
+    // element to element: elements met at least FacetNodes times around the nodes of an element
+    FillAdjacency(elem_neighbours, n_el, [&](const int &e, std::vector<int> &row)
+    {
+        row.clear();
+        for (int i = 0; i < npe; i++)
+        {
+            const int v = block.elems[e].Nodes(i).node_id;
+            for (const int *f = ne.Begin(v); f != ne.End(v); f++)
+            {
+                if (*f != e) { row.push_back(*f); }
+            }
+        }
+        std::sort(row.begin(), row.end());
+        int n_row = 0;
+        for (std::size_t k = 0; k < row.size();)
+        {
+            std::size_t end = k;
+            while (end < row.size() && row[end] == row[k]) { end++; }
+            if (static_cast<int>(end - k) >= FacetNodes<T>()) { row[n_row++] = row[k]; }
+            k = end;
+        }
+        row.resize(n_row);
+    });
+}
+
+template<typename T>
+void Mesh::SetElementNodes(T &elem, const int *ids)
+{
+    for (int a = 0; a < ElementBlock<T>::NPE(); a++)
+    {
+        auto &node = elem.Nodes(a);
+        node.node_id = ids[a];
+        node.ebc_flag = false;
+        for (int j = 0; j < n_dims; j++) { node.Coords(j) = nodes[ids[a]]->Coords(j); }
+    }
 }
 
 void Mesh::InitElements(const std::string &type_str)
 {
     std::unordered_map<std::string, std::tuple<ElementType, int>> elem_map = {
                                                         {"LinLine",     std::make_tuple(ElementType::LinLine,   2)},
-                                                        {"QuadLine",    std::make_tuple(ElementType::QuadLine,  2)},
+                                                        {"QuadLine",    std::make_tuple(ElementType::QuadLine,  3)},
                                                         {"LinTri",      std::make_tuple(ElementType::LinTri,    3)},
                                                         {"LinQuad",     std::make_tuple(ElementType::LinQuad,   4)},
-                                                        {"QuadTri",     std::make_tuple(ElementType::QuadLine,  3)},
-                                                        {"QuadQuad",    std::make_tuple(ElementType::QuadQuad,  4)},
+                                                        {"QuadTri",     std::make_tuple(ElementType::QuadTri,   6)},
+                                                        {"QuadQuad",    std::make_tuple(ElementType::QuadQuad,  9)},
                                                         {"LinTet",      std::make_tuple(ElementType::LinTet,    4)}
                                                     };
     
@@ -120,93 +782,50 @@ void Mesh::InitElements(const std::string &type_str)
             break;
         }
     }
-    // TODO: add assertion to ensure element type was found
+    Assert(elem_type != ElementType::NoType, "unknown element type %s", type_str.c_str());
 }
 
 void Mesh::GetMesh()
 {
-    for (int e = 0; e < n_elems; e++)
+    ForEachBlock([&](auto &block)
     {
-        std::cout << "element: " << elems[e]->elem_id << "\n";
-        std::cout << "nodes:" << "\n";
-        for (int n = 0; n < npe; n++)
-        {
-            std::cout << elems[e]->Nodes(n).node_id << " ";
-        }
-        std::cout << "\n";
-        for (int n = 0; n < npe; n++)
+        std::cout << "block: " << block.elems[0].type_str << ", elements: " << block.Size() << "\n";
+        for (int e = 0; e < block.Size(); e++)
         {
-            std::cout << "node: " << elems[e]->Nodes(n).node_id << ", coords:";
-            for (int i = 0; i < n_dims; i++)
+            auto &elem = block.elems[e];
+            std::cout << "element: " << elem.elem_id << ", geometric entity: " << block.geom_idx[e] << "\n";
+            std::cout << "nodes:" << "\n";
+            for (int n = 0; n < block.NPE(); n++)
             {
-                std::cout << " " << elems[e]->Nodes(n).Coords(i);
+                std::cout << elem.Nodes(n).node_id << " ";
             }
             std::cout << "\n";
+            for (int n = 0; n < block.NPE(); n++)
+            {
+                std::cout << "node: " << elem.Nodes(n).node_id << ", coords:";
+                for (int i = 0; i < n_dims; i++)
+                {
+                    std::cout << " " << elem.Nodes(n).Coords(i);
+                }
+                std::cout << "\n";
+            }
         }
-    }
+    });
 }
 
-void Mesh::AllocateElements()
+ElementType Mesh::ComsolType(const std::string &name)
 {
-    switch (elem_type)
-    {
-        case ElementType::LinLine:
-            elems.reserve(sizeof(LinLine*)*n_elems);
-            break;
-        case ElementType::QuadLine:
-            // TODO
-            break;
-        case ElementType::LinTri:
-            elems.reserve(sizeof(LinTri*)*n_elems);
-            break;
-        case ElementType::LinQuad:
-            // TODO
-            break;
-        case ElementType::QuadTri:
-            // TODO
-            break;
-        case ElementType::QuadQuad:
-            // TODO
-            break;
-        case ElementType::LinTet:
-            elems.reserve(sizeof(LinTet*)*n_elems);
-            break;
-        default:
-            FATAL_MSG("unknown element type for allocation");
-            break;
-    }
-}
-
-Element* Mesh::CreateElement()
-{
-    switch (elem_type)
-    {
-        case ElementType::LinLine:
-            return new LinLine();
-            break;
-        case ElementType::QuadLine:
-            // TODO
-            break;
-        case ElementType::LinTri:
-            return new LinTri();
-            break;
-        case ElementType::LinQuad:
-            // TODO
-            break;
-        case ElementType::QuadTri:
-            // TODO
-            break;
-        case ElementType::QuadQuad:
-            // TODO
-            break;
-        case ElementType::LinTet:
-            return new LinTet();
-            break;
-        default:
-            FATAL_MSG("unknown element type for creation");
-            return new NullElem();
-            break;
-    }
+    std::unordered_map<std::string, ElementType> comsol_map = {
+                                                        {"edg",     ElementType::LinLine},
+                                                        {"edg2",    ElementType::QuadLine},
+                                                        {"tri",     ElementType::LinTri},
+                                                        {"quad",    ElementType::LinQuad},
+                                                        {"tri2",    ElementType::QuadTri},
+                                                        {"quad2",   ElementType::QuadQuad},
+                                                        {"tet",     ElementType::LinTet}
+                                                    };
+    auto it = comsol_map.find(name);
+    return (it == comsol_map.end()) ? ElementType::NoType : it->second;
 }
 
 Node* Mesh::CreateNode()
@@ -231,6 +850,4 @@ Mesh::~Mesh()
 {
     for (Node* n : nodes) { delete n; }
     nodes.clear();
-    for (Element* e : elems) { delete e; }
-    elems.clear();
 }
\ No newline at end of file
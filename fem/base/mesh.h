@@ -1,55 +1,305 @@
 #ifndef MESH_INCL
 #define MESH_INCL
 
+#include "memory.h"
 #include "elements/element.h"
+#include "elements/linline.h"
+#include "elements/quadline.h"
+#include "elements/lintri.h"
+#include "elements/linquad.h"
+#include "elements/quadtri.h"
+#include "elements/quadquad.h"
+#include "elements/lintet.h"
 
+#include <algorithm>
 #include <array>
 #include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief contiguous storage for every element of one type in the mesh.  elements are stored by value
+ * so a kernel loop over a block walks memory linearly and calls the (final) element methods directly.
+ * @tparam T element type stored in the block
+ */
+template<typename T>
+struct ElementBlock
+{
+    typedef T ElemType;
+    std::vector<T> elems;       /** @brief elements of this type */
+    std::vector<int> geom_idx;  /** @brief geometric entity (domain/boundary) index of each element */
+    std::vector<int> scatter;   /** @brief position of each local entry (e, i, j) in the global matrix values */
+    std::vector<char> cached;   /** @brief element matrices are up to date with the element geometry */
+
+    /** @brief number of elements in the block */
+    inline int Size() const { return static_cast<int>(elems.size()); }
+
+    /**
+     * @brief add an element at the end of the block. its matrices and scatter entries are not set
+     * @return index of the new element
+     */
+    inline int Append(const T &elem, const int &geom)
+    {
+        elems.push_back(elem);
+        geom_idx.push_back(geom);
+        cached.push_back(0);
+        scatter.resize(elems.size()*NPE()*NPE(), -1);
+        return Size() - 1;
+    }
+
+    /**
+     * @brief remove an element by moving the last element of the block into its slot
+     * @return previous index of the element moved into slot e, or -1 if e was the last element
+     */
+    inline int Remove(const int &e)
+    {
+        const int last = Size() - 1;
+        const int nn = NPE()*NPE();
+        if (e != last)
+        {
+            elems[e] = elems[last];
+            geom_idx[e] = geom_idx[last];
+            cached[e] = cached[last];
+            std::copy(scatter.begin() + last*nn, scatter.begin() + (last + 1)*nn, scatter.begin() + e*nn);
+        }
+        elems.pop_back();
+        geom_idx.pop_back();
+        cached.pop_back();
+        scatter.resize(elems.size()*nn);
+        return (e != last) ? last : -1;
+    }
+
+    /** @brief dimension of the parent domain of the element type */
+    static constexpr int Dim() { return T::Basis::dim; }
+
+    /** @brief number of nodes per element */
+    static constexpr int NPE() { return T::Basis::n_nodes; }
+};
+
+/** @brief how the nodes of a mesh changed in one refinement or coarsening pass */
+struct MeshChange
+{
+    std::vector<int> node_map;                  /** @brief new index of every node before the pass, -1 if removed */
+    std::vector<std::array<int, 2>> new_nodes;  /** @brief end points of the edge split by each added node.  added nodes are numbered last, in this order */
+    std::vector<char> affected;                 /** @brief per node after the pass, true if its column of the sparsity pattern changed */
+
+    /** @brief true if the pass left the mesh unchanged */
+    inline bool Empty() const { return std::find(affected.begin(), affected.end(), 1) == affected.end(); }
+};
+
+/**
+ * @brief adjacency relation in compressed sparse row form.  the neighbours of entry i are
+ * index[offset[i]] to index[offset[i + 1] - 1], in increasing order
+ */
+struct Adjacency
+{
+    std::vector<int> offset;    /** @brief first neighbour of every entry, one past the last at the end */
+    std::vector<int> index;     /** @brief neighbours of all entries, one after the other */
+
+    /** @brief number of entries */
+    inline int Size() const { return offset.empty() ? 0 : static_cast<int>(offset.size()) - 1; }
+
+    /** @brief number of neighbours of entry i */
+    inline int Degree(const int &i) const { return offset[i + 1] - offset[i]; }
+
+    inline const int* Begin(const int &i) const { return index.data() + offset[i]; }
+    inline const int* End(const int &i) const { return index.data() + offset[i + 1]; }
+};
+
+/** @brief one block per supported element type.  the order matches ElementType */
+typedef std::tuple<
+                    ElementBlock<LinLine>, ElementBlock<QuadLine>,
+                    ElementBlock<LinTri>, ElementBlock<LinQuad>, ElementBlock<QuadTri>, ElementBlock<QuadQuad>,
+                    ElementBlock<LinTet>
+                  > ElementBlocks;
 
 class Mesh
 {
+    friend class Refiner;
     public:
         /** @brief default constructor */
         Mesh() = default;
         ~Mesh();
 
         /**
-         * @brief initializes mesh element type and number of nodes per element based on
-         * the element type specified in the condition file. this is called before the mesh file
-         * is read, so memory allocation is done in a separate function.
+         * @brief initializes the domain element type and number of nodes per element based on
+         * the element type specified in the condition file. the mesh file may contain blocks of
+         * other element types (e.g. boundary edges), which are read into their own blocks.
          * @param type_str element type string
          */
         void InitElements(const std::string &type_str);
 
         /**
-         * @brief read in nodal coordinates and element connectivities from a comsol .mphtxt file
-         * @param mesh_file 
+         * @brief read in nodal coordinates and the element blocks (vertices, edges, domain elements,
+         * and their geometric entity indices) from a comsol .mphtxt file, or from a gmsh file if the name
+         * ends in .msh.  @see ReadGmsh
+         * @param mesh_file
          */
         void ReadMesh(const std::string &mesh_file);
 
+        /**
+         * @brief read a binary gmsh 4.1 .msh file.  the file is mapped into memory and the node and element
+         * blocks are converted in bulk, from the byte order and the size_t width of the writer, to the node
+         * coordinates and the connectivity of the element blocks, with the local nodes reordered to the ones of
+         * the elements.  the geometric entity index of an element is the first physical group of its
+         * entity, or the entity tag if it is in none, so the physical groups are the boundary entities of
+         * the dirichlet conditions.  point elements are the geometric vertices, other unsupported element
+         * types are skipped.  the spatial dimension is the one of the domain element type
+         * @param mesh_file
+         */
+        void ReadGmsh(const std::string &mesh_file);
+
+        /**
+         * @brief refine every element uniformly (red refinement): edges are split at their midpoints,
+         * triangles into 4 and tetrahedra into 8 by Bey's scheme, and boundary blocks with them, so the refined mesh is nested in the current one.  existing nodes keep
+         * their index and the midpoints are numbered after them.  needs a LinTri mesh in 2D or LinTet in 3D.
+         * @return added nodes, with the edge each one splits
+         */
+        MeshChange RefineUniform();
+
         /** @brief prints element connectivity and nodal coordinates.  mostly for testing purposes */
         void GetMesh();
 
+        /**
+         * @brief call f on every non-empty element block. f is a generic callable, so it is instantiated
+         * once per element type and the loop over the block inside it is specialised for that type.
+         * @tparam F callable taking an ElementBlock<T>&
+         */
+        template<typename F>
+        void ForEachBlock(F &&f)
+        {
+            std::apply([&f](auto &...block) { ((block.Size() > 0 ? f(block) : void()), ...); }, blocks);
+        }
+
+        /**
+         * @brief call f on the block holding elements of the given type
+         * @param type element type of the block
+         * @param f callable taking an ElementBlock<T>&
+         */
+        template<typename F>
+        void DispatchBlock(const ElementType &type, F &&f);
+
+        /** @brief get the block storing elements of type T */
+        template<typename T>
+        inline ElementBlock<T>& Block() { return std::get<ElementBlock<T>>(blocks); }
+
+        /** @brief number of spatial dimensions */
+        inline int Dim() const { return n_dims; }
+
+        /** @brief global number of nodes */
+        inline int NumNodes() const { return n_nodes; }
+
+        /** @brief number of domain elements */
+        inline int NumElems() const { return n_elems; }
+
+        /** @brief type of the domain elements */
+        inline ElementType ElemType() const { return elem_type; }
+
+        /** @brief global node list */
+        inline Node& Nodes(const int &idx) { return *nodes[idx]; }
+
+        /**
+         * @brief domain elements around every node, elements by their index in the domain block.  the
+         * topology (this, ElementNeighbours and NodeNeighbours) is built in parallel on first use and kept
+         * until the mesh changes, so call one of them before using it from parallel code
+         */
+        const Adjacency& NodeElements();
+
+        /** @brief domain elements sharing a facet (an edge in 2D, a face in 3D) with every domain element */
+        const Adjacency& ElementNeighbours();
+
+        /** @brief nodes sharing a domain element with every node, the node itself included */
+        const Adjacency& NodeNeighbours();
+
+        /**
+         * @brief bytes held by the mesh.  MemoryUse::Mesh counts the nodes, the geometric vertices and the topology,
+         * MemoryUse::Geometry the element blocks, i.e. the elements with their cached matrices and the scatter maps
+         */
+        std::size_t MemoryBytes(const MemoryUse &use) const;
+
+        /** @brief nodes of the geometric vertices */
+        inline const std::vector<int>& Vertices() const { return vtx; }
+
+        /** @brief geometric entity index of each geometric vertex */
+        inline const std::vector<int>& VertexGeomIdx() const { return vtx_geom_idx; }
+
     private: // methods
-        /** @brief allocate memory for the global mesh element list based on the element type */
-        void AllocateElements();
+        /**
+         * @brief map a comsol type name (vtx, edg, tri, ...) to an element type
+         * @return ElementType::NoType for vertices and unsupported types
+         */
+        ElementType ComsolType(const std::string &name);
 
         /**
-         * @brief create an element to be added into the global mesh element list
-         * @return Element* a new element with type determined by the mesh file
+         * @brief fill the block of an element type from the connectivity and geometric entity indices read in
+         * @param type element type of the block
+         * @param block_npe nodes per element in conn
+         * @param conn node indices of the elements, block_npe per element in the local order of the element
+         * @param geom geometric entity index of each element
          */
-        Element* CreateElement();
+        void StoreBlock(const ElementType &type, const int &block_npe, const std::vector<int> &conn, const std::vector<int> &geom);
 
         Node* CreateNode();
 
+        /** @brief build the node to element, element to element and node to node adjacency if out of date */
+        void BuildTopology();
+
+        template<typename T>
+        void BuildTopology(ElementBlock<T> &block);
+
+        /** @brief drop the topology, called whenever the mesh changes */
+        inline void InvalidateTopology() { topology_valid = false; }
+
+        /** @brief set the node ids and coordinates of an element from the global nodes */
+        template<typename T>
+        void SetElementNodes(T &elem, const int *ids);
+
     private: // variables
         int n_dims;                                     /** @brief number of spatial dimenions */
-        ElementType elem_type;                          /** @brief type of element used in the mesh */
-        int npe;                                        /** @brief number of nodes per element */
+        ElementType elem_type;                          /** @brief type of element used in the mesh domain */
+        int npe;                                        /** @brief number of nodes per domain element */
         int n_nodes;                                    /** @brief global number of nodes */
-        std::vector<Node*> nodes;       /** @brief global node list. shared by elements */
-        int n_elems;                                    /** @brief global number of elements */
-        std::vector<Element*> elems;    /** @brief global element list */
+        std::vector<Node*> nodes;                       /** @brief global node list. shared by elements */
+        int n_elems;                                    /** @brief global number of domain elements */
+        ElementBlocks blocks;                           /** @brief element storage, one block per element type */
+        std::vector<int> vtx;                           /** @brief geometric vertex nodes */
+        std::vector<int> vtx_geom_idx;                  /** @brief geometric entity index of each vertex */
+        Adjacency node_elems;                           /** @brief domain elements of every node */
+        Adjacency elem_neighbours;                      /** @brief facet neighbours of every domain element */
+        Adjacency node_neighbours;                      /** @brief nodes coupled to every node by a domain element */
+        bool topology_valid = false;                    /** @brief the adjacency is up to date with the mesh */
 };
 
-#endif // MESH_INCL
\ No newline at end of file
+template<typename F>
+void Mesh::DispatchBlock(const ElementType &type, F &&f)
+{
+    switch (type)
+    {
+        case ElementType::LinLine:
+            f(Block<LinLine>());
+            break;
+        case ElementType::QuadLine:
+            f(Block<QuadLine>());
+            break;
+        case ElementType::LinTri:
+            f(Block<LinTri>());
+            break;
+        case ElementType::LinQuad:
+            f(Block<LinQuad>());
+            break;
+        case ElementType::QuadTri:
+            f(Block<QuadTri>());
+            break;
+        case ElementType::QuadQuad:
+            f(Block<QuadQuad>());
+            break;
+        case ElementType::LinTet:
+            f(Block<LinTet>());
+            break;
+        default:
+            FATAL_MSG("unknown element type for block dispatch");
+            break;
+    }
+}
+
+#endif // MESH_INCL
@@ -2,10 +2,68 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+#include <omp.h>
+
+namespace
+{
+    /** @brief name of a linear solver backend as given in the condition file */
+    const char* SolverName(const SolverType &type)
+    {
+        switch (type)
+        {
+            case SolverType::Cholesky: return "Cholesky";
+            case SolverType::CG: return "CG";
+            case SolverType::AMG: return "AMG";
+            case SolverType::GMG: return "GMG";
+            case SolverType::Pardiso: return "Pardiso";
+            case SolverType::PardisoLU: return "PardisoLU";
+            case SolverType::MatrixFree: return "MatrixFree";
+            default: return "unknown";
+        }
+    }
+}
 
 Model::Model()
+: step{0}, n_species{1}, reassembly_tol{1e-3}, uniform_refinements{0}, refine_fraction{0.5}, coarsen_fraction{0.05}, max_refinement_level{8},
+  adapt_interval{0}, output_interval{1}, history_keyframes{32}, monitor_slots{4}, system_species{-1}, implicit_reactions{false},
+  preferred_solver{SolverType::Cholesky}, memory_budget{0.0}, recycled_vectors{0}, extrapolation_order{2},
+  rates_factorized{false}, parareal_slices{0}, parareal_coarsening{10}, parareal_max_iters{10}, parareal_tol{1e-8},
+  steady_tol{1e-8}, steady_max_iters{100}, steady_initial_step{0.0}, steady_max_step{1e12}, steady_growth{2.0},
+  steady_refactor_ratio{4.0}, steady_rejections{0}
 {
     ReadCondition();
+    diffusivity.resize(std::max<std::size_t>(diffusivity.size(), n_species));
+    substeps.resize(std::max<std::size_t>(substeps.size(), n_species), 1);
+    Ks.resize(n_species);
+    reactions.Compile(n_species);
+    elem_coef.resize(n_species);
+    recyclers.assign(n_species, Recycler(recycled_vectors, extrapolation_order));
+
+    // uniform refinements of the mesh read in, each kept as a level of the geometric multigrid
+    const bool gmg = solver.Type() == SolverType::GMG || solver.Type() == SolverType::MatrixFree;
+    if (gmg) { solver.GetMultigrid().AddLevel(mesh, MeshChange()); }
+    for (int r = 0; r < uniform_refinements; r++)
+    {
+        const MeshChange change = mesh.RefineUniform();
+        if (gmg) { solver.GetMultigrid().AddLevel(mesh, change); }
+    }
+
+    refiner.Init(mesh);
+    assembler.Init(mesh);
+    constraints.Init(mesh, assembler.Pattern());
+    if (gmg) { solver.GetMultigrid().SetConstraints(constraints.Dofs()); }
+    locator.Build(mesh);
+    SelectSolver();
+    u.setZero(mesh.NumNodes()*n_species);
+    GlobalAssembly();
+    if (!history_file.empty()) { history.Open(history_file, history_keyframes); }
+    if (!monitor_file.empty()) { monitor.Open(monitor_file, monitor_slots); }
 }
 
 void Model::ReadCondition()
@@ -30,10 +88,1024 @@ void Model::ReadCondition()
             std::string type = line.substr(line.find(" = ") + 3);
             mesh.InitElements(type);
         }
+        if (line.find("number of species") != std::string::npos)
+        {
+            n_species = std::stoi(line.substr(line.find(" = ") + 3)); // 3 = length(" = ")
+        }
+        // diffusivity <species> = <D0> [<beta>]
+        if (line.find("diffusivity") != std::string::npos)
+        {
+            int species = std::stoi(line.substr(line.find("diffusivity") + 11)); // 11 = length("diffusivity")
+            if (species >= static_cast<int>(diffusivity.size())) { diffusivity.resize(species + 1); }
+            std::istringstream iss(line.substr(line.find(" = ") + 3));
+            iss >> diffusivity[species].D0;
+            if (!(iss >> diffusivity[species].beta)) { diffusivity[species].beta = 0.0; }
+        }
+        // substeps <species> = <substeps per time step>
+        if (line.find("substeps") == 0)
+        {
+            int species = std::stoi(line.substr(8)); // 8 = length("substeps")
+            if (species >= static_cast<int>(substeps.size())) { substeps.resize(species + 1, 1); }
+            substeps[species] = std::max(1, std::stoi(line.substr(line.find(" = ") + 3)));
+        }
+        // parameter <name> = <value>, used in reaction expressions
+        if (line.find("parameter") == 0)
+        {
+            std::istringstream iss(line.substr(9)); // 9 = length("parameter")
+            std::string name;
+            iss >> name;
+            reactions.SetParameter(name, std::stod(line.substr(line.find(" = ") + 3)));
+        }
+        // reaction <species> = <expression in u0, u1, ... and the parameters>
+        if (line.find("reaction") == 0)
+        {
+            int species = std::stoi(line.substr(8)); // 8 = length("reaction")
+            reactions.SetReaction(species, line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("implicit reactions") != std::string::npos)
+        {
+            implicit_reactions = std::stoi(line.substr(line.find(" = ") + 3)) != 0;
+        }
+        if (line.find("reassembly tolerance") != std::string::npos)
+        {
+            reassembly_tol = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("mixed precision") != std::string::npos)
+        {
+            solver.SetMixedPrecision(std::stoi(line.substr(line.find(" = ") + 3)) != 0);
+        }
+        if (line.find("symmetric storage") != std::string::npos)
+        {
+            // K, M and the system matrices as their upper triangle only, all of them are symmetric
+            const bool symmetric = std::stoi(line.substr(line.find(" = ") + 3)) != 0;
+            assembler.SetSymmetric(symmetric);
+            solver.SetSymmetricStorage(symmetric);
+        }
+        if (line.find("recycled vectors") != std::string::npos)
+        {
+            recycled_vectors = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("extrapolation order") != std::string::npos)
+        {
+            extrapolation_order = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("parareal slices") != std::string::npos)
+        {
+            parareal_slices = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("parareal coarsening") != std::string::npos)
+        {
+            parareal_coarsening = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("parareal iterations") != std::string::npos)
+        {
+            parareal_max_iters = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("parareal tolerance") != std::string::npos)
+        {
+            parareal_tol = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady tolerance") != std::string::npos)
+        {
+            steady_tol = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady iterations") != std::string::npos)
+        {
+            steady_max_iters = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady initial step") != std::string::npos)
+        {
+            steady_initial_step = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady max step") != std::string::npos)
+        {
+            steady_max_step = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady growth") != std::string::npos)
+        {
+            steady_growth = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("steady refactor ratio") != std::string::npos)
+        {
+            steady_refactor_ratio = std::max(1.0, std::stod(line.substr(line.find(" = ") + 3)));
+        }
+        if (line.find("uniform refinements") != std::string::npos)
+        {
+            uniform_refinements = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("refine fraction") != std::string::npos)
+        {
+            refine_fraction = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("coarsen fraction") != std::string::npos)
+        {
+            coarsen_fraction = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("max refinement level") != std::string::npos)
+        {
+            max_refinement_level = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        // adapt interval = <steps>, Run adapts the mesh to the solution after every this many steps
+        if (line.find("adapt interval") != std::string::npos)
+        {
+            adapt_interval = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        // output file = <prefix>, solutions are written to <prefix>_<step>.dat by Run
+        if (line.find("output file") != std::string::npos)
+        {
+            output_file = line.substr(line.find(" = ") + 3);
+        }
+        if (line.find("output interval") != std::string::npos)
+        {
+            output_interval = std::max(1, std::stoi(line.substr(line.find(" = ") + 3)));
+        }
+        if (line.find("history file") != std::string::npos)
+        {
+            history_file = line.substr(line.find(" = ") + 3);
+        }
+        if (line.find("history keyframes") != std::string::npos)
+        {
+            history_keyframes = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("monitor file") != std::string::npos)
+        {
+            monitor_file = line.substr(line.find(" = ") + 3);
+        }
+        if (line.find("monitor slots") != std::string::npos)
+        {
+            monitor_slots = std::stoi(line.substr(line.find(" = ") + 3));
+        }
+        if (line.find("linear solver") != std::string::npos)
+        {
+            std::string type = line.substr(line.find(" = ") + 3);
+            if (type == "CG") { solver.SetType(SolverType::CG); }
+            else if (type == "AMG") { solver.SetType(SolverType::AMG); }
+            else if (type == "GMG") { solver.SetType(SolverType::GMG); }
+            else if (type == "Pardiso" || type == "PardisoLU")
+            {
+#ifndef EIGEN_USE_MKL_ALL
+                Assert(false, "linear solver %s needs eigen with mkl, EIGEN_USE_MKL_ALL is not defined", type.c_str());
+#endif
+                solver.SetType(type == "Pardiso" ? SolverType::Pardiso : SolverType::PardisoLU);
+            }
+            else if (type == "MatrixFree") { solver.SetType(SolverType::MatrixFree); }
+            else
+            {
+                Assert(type == "Cholesky", "unknown linear solver %s, one of Cholesky, CG, AMG, GMG, Pardiso, PardisoLU or MatrixFree",
+                       type.c_str());
+                solver.SetType(SolverType::Cholesky);
+            }
+            preferred_solver = solver.Type();
+        }
+        // memory budget = <MB>, the linear solver falls back to backends needing less memory to stay within it
+        if (line.find("memory budget") != std::string::npos)
+        {
+            memory_budget = std::stod(line.substr(line.find(" = ") + 3));
+        }
+        // dirichlet <geometric entity index> = <value>
+        if (line.find("dirichlet") != std::string::npos)
+        {
+            int geom_idx = std::stoi(line.substr(line.find("dirichlet") + 9)); // 9 = length("dirichlet")
+            double value = std::stod(line.substr(line.find(" = ") + 3));
+            constraints.AddCondition(geom_idx, value);
+        }
         if (line.find("mesh file") != std::string::npos)
         {   
             std::string mesh_file = line.substr(line.find(" = ") + 3); // 3 = length(" = ")
             mesh.ReadMesh(mesh_file);
         }
     }
-}
\ No newline at end of file
+}
+
+void Model::GlobalAssembly()
+{
+    assembler.Assemble(mesh, K, M, Mb);
+    if (assembler.Symmetric()) { M_sym.Assign(M); } else { M_sell.Assign(M); }
+    // the element matrices changed, so every weighted stiffness is rebuilt on the next solve
+    for (auto &coef : elem_coef) { coef.clear(); }
+    system_species = -1;
+    rates_factorized = false;
+    TrackMemory();
+}
+
+void Model::Solve()
+{
+    step++;
+    if (Multirate())
+    {
+        SolveMultirate();
+        return;
+    }
+    Eigen::VectorXd B(u.size());
+    RightHandSides(B);
+    for (int s = 0; s < n_species; s++) { UpdateStiffness(s); }
+    SolveSpecies(B);
+}
+
+void Model::Run(const int &n_steps)
+{
+    Eigen::VectorXd B(u.size());
+    std::array<Eigen::VectorXd, 2> snapshot;
+    const bool output = !output_file.empty();
+    const int first = step;
+
+    // dependence tokens of the task graph.  a task reading u^n declares in on u, the species solves declare
+    // inout, so stages of one step that only read u^n run concurrently.  snapshots alternate between two
+    // buffers, so writing and diagnosing step n overlaps step n + 1 and blocks step n + 2 at most.  depend
+    // clauses do not count as uses, hence maybe_unused
+    [[maybe_unused]] char dep_u = 0, dep_rhs = 0, dep_diag = 0, dep_hist = 0;
+    [[maybe_unused]] char dep_snap[2] = {0, 0};
+
+    // stages keep their own parallel loops, nested in the tasks.  up to outer stages run at once, so each
+    // nested loop gets its share of the threads and together they do not oversubscribe the machine
+    const int max_threads = omp_get_max_threads();
+    const int outer = std::min(4, max_threads);
+    const int inner = std::max(1, max_threads / outer);
+    const int max_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(inner > 1 ? 2 : 1);
+    #pragma omp parallel num_threads(outer)
+    #pragma omp single
+    {
+        // the tasks inherit the thread count of their nested regions from here
+        omp_set_num_threads(inner);
+        for (int n = 0; n <= n_steps; n++)
+        {
+            const int index = first + n;
+            if (n > 0 && Multirate())
+            {
+                #pragma omp task depend(inout: dep_u)
+                SolveMultirate();
+            }
+            else if (n > 0)
+            {
+                #pragma omp task shared(B) depend(in: dep_u) depend(out: dep_rhs)
+                RightHandSides(B);
+                for (int s = 0; s < n_species; s++)
+                {
+                    if (diffusivity[s].Linear()) { continue; }
+                    #pragma omp task firstprivate(s) depend(in: dep_u)
+                    UpdateStiffness(s);
+                }
+                #pragma omp task shared(B) depend(in: dep_rhs) depend(inout: dep_u)
+                SolveSpecies(B);
+            }
+            if (monitor.IsOpen())
+            {
+                #pragma omp task firstprivate(index) depend(in: dep_u)
+                monitor.Publish(index, index*dt, u, mesh.NumNodes(), n_species);
+            }
+            if (n % output_interval == 0)
+            {
+                const int k = (n / output_interval) % 2;
+                #pragma omp task firstprivate(k) shared(snapshot) depend(in: dep_u) depend(out: dep_snap[k])
+                snapshot[k] = u;
+                if (output)
+                {
+                    #pragma omp task firstprivate(index, k) shared(snapshot) depend(in: dep_snap[k])
+                    WriteSolution(index, snapshot[k]);
+                }
+                if (history.IsOpen())
+                {
+                    // frames are coded against the previous ones, so they are appended in step order
+                    #pragma omp task firstprivate(index, k) shared(snapshot) depend(in: dep_snap[k]) depend(inout: dep_hist)
+                    history.Append(index, index*dt, snapshot[k], mesh.NumNodes(), n_species);
+                }
+                #pragma omp task firstprivate(index, k) shared(snapshot) depend(in: dep_snap[k]) depend(inout: dep_diag)
+                diagnostics.push_back(Diagnose(index, snapshot[k]));
+            }
+
+            // the mesh, u and the matrices change size, so every task of the step is finished first
+            if (adapt_interval > 0 && n > 0 && n % adapt_interval == 0)
+            {
+                #pragma omp taskwait
+                Adapt();
+                B.resize(u.size());
+            }
+        }
+    }
+    omp_set_max_active_levels(max_levels);
+    step = first + n_steps;
+    memory.Report();
+}
+
+void Model::SolveMultirate()
+{
+    const int n_nodes = mesh.NumNodes();
+    if (!rates_factorized)
+    {
+        rate_solvers = std::vector<Solver>(n_species); // cholesky, solvers are not copyable
+        rate_constraints.assign(n_species, constraints);
+        for (int s = 0; s < n_species; s++)
+        {
+            rate_solvers[s].SetSymmetricStorage(assembler.Symmetric());
+            if (diffusivity[s].Linear()) { FactorizeRate(s); }
+        }
+        rates_factorized = true;
+    }
+
+    // species with the same substeps are advanced together, the slow ones first
+    std::vector<int> rates(substeps.begin(), substeps.begin() + n_species);
+    std::sort(rates.begin(), rates.end());
+    rates.erase(std::unique(rates.begin(), rates.end()), rates.end());
+
+    const Eigen::VectorXd u0 = u;
+    Eigen::VectorXd v(u.size()), w(u.size()), b(n_nodes), u_s(n_nodes);
+    for (const int &m : rates)
+    {
+        const double h = dt / m;
+        for (int k = 0; k < m; k++)
+        {
+            // the slower species interpolated to the start of the substep.  the others are in u, the
+            // species of this rate at the substep and the faster ones still at the start of the step
+            const double theta = static_cast<double>(k) / m;
+            for (int j = 0; j < n_species; j++)
+            {
+                if (substeps[j] < m) { v.segment(j*n_nodes, n_nodes) = u0.segment(j*n_nodes, n_nodes) + theta*(u.segment(j*n_nodes, n_nodes) - u0.segment(j*n_nodes, n_nodes)); }
+                else { v.segment(j*n_nodes, n_nodes) = u.segment(j*n_nodes, n_nodes); }
+            }
+            if (reactions.Empty()) { w = v; }
+            else if (implicit_reactions) { integrator.Step(reactions, v.data(), n_nodes, h, w.data()); }
+            else
+            {
+                R.resize(u.size());
+                reactions.Evaluate(v.data(), n_nodes, R.data());
+                w = v + h*R;
+            }
+
+            for (int s = 0; s < n_species; s++)
+            {
+                if (substeps[s] != m) { continue; }
+                if (!diffusivity[s].Linear())
+                {
+                    UpdateStiffness(s);
+                    FactorizeRate(s);
+                }
+                if (assembler.Symmetric()) { M_sym.Multiply(w.data() + s*n_nodes, b.data()); }
+                else { M_sell.Multiply(w.data() + s*n_nodes, b.data()); }
+                rate_constraints[s].ApplyRHS(b);
+                u_s = u.segment(s*n_nodes, n_nodes);
+                rate_solvers[s].Solve(b, u_s);
+                u.segment(s*n_nodes, n_nodes) = u_s;
+            }
+        }
+    }
+    TrackMemory();
+}
+
+void Model::FactorizeRate(const int &s)
+{
+    const Diffusivity &D = diffusivity[s];
+    const double h = dt / substeps[s];
+    if (A.nonZeros() != M.nonZeros()) { A = M; }
+    if (D.Linear()) { A.coeffs() = M.coeffs() + (h*D.D0)*K.coeffs(); }
+    else { A.coeffs() = M.coeffs() + h*Ks[s].coeffs(); }
+    rate_constraints[s].ApplyMatrix(A);
+    rate_solvers[s].Factorize(A);
+    // A no longer holds the system of Solve
+    system_species = -1;
+}
+
+int Model::Parareal(const int &n_steps)
+{
+    // the largest slice count up to the requested one that divides the steps, so all slices are alike
+    int n_slices = std::max(1, std::min(n_steps, parareal_slices > 0 ? parareal_slices : omp_get_max_threads()));
+    while (n_steps % n_slices != 0) { n_slices--; }
+    const int fine_steps = n_steps / n_slices;
+    const int coarse_steps = std::max(1, fine_steps / parareal_coarsening);
+    INFO("parareal over %d slices of %d steps, %d coarse steps per slice", n_slices, fine_steps, coarse_steps);
+
+    Stepper coarse;
+    InitStepper(coarse, fine_steps*dt / coarse_steps, true);
+    std::vector<Stepper> fine(std::min(n_slices, omp_get_max_threads()));
+    for (Stepper &st : fine) { InitStepper(st, dt, false); }
+
+    // U are the starts of the slices, G and F the coarse and fine propagation of the previous iterate
+    std::vector<Eigen::VectorXd> U(n_slices + 1, u), G(n_slices + 1), F(n_slices + 1);
+    for (int j = 0; j < n_slices; j++)
+    {
+        G[j + 1] = U[j];
+        Advance(coarse, G[j + 1], coarse_steps);
+        U[j + 1] = G[j + 1];
+    }
+    int k = 0;
+    double change = 0.0;
+    while (k < std::min(parareal_max_iters, n_slices))
+    {
+        k++;
+        // after k - 1 iterations the slices before k - 1 are exact, only the others are propagated again
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(static_cast<int>(fine.size()))
+        for (int j = k - 1; j < n_slices; j++)
+        {
+            F[j + 1] = U[j];
+            Advance(fine[omp_get_thread_num()], F[j + 1], fine_steps);
+        }
+        change = 0.0;
+        for (int j = k - 1; j < n_slices; j++)
+        {
+            Eigen::VectorXd g = U[j];
+            Advance(coarse, g, coarse_steps);
+            Eigen::VectorXd next = g + F[j + 1] - G[j + 1];
+            change = std::max(change, (next - U[j + 1]).norm() / std::max(next.norm(), 1e-300));
+            U[j + 1] = std::move(next);
+            G[j + 1] = std::move(g);
+        }
+        DEBUG("parareal iteration %d, change %e", k, change);
+        if (change <= parareal_tol) { break; }
+    }
+    // after as many iterations as slices the result is the sequential one whatever the change
+    if (change > parareal_tol && k < n_slices)
+    {
+        WARN("parareal stopped after %d iterations at a change of %e", k, change);
+    }
+    INFO("parareal converged in %d iterations for %d slices", k, n_slices);
+
+    for (int j = 1; j <= n_slices; j++) { diagnostics.push_back(Diagnose(step + j*fine_steps, U[j])); }
+    u = U[n_slices];
+    step += n_steps;
+    return k;
+}
+
+int Model::SolveSteady()
+{
+    const int n_nodes = mesh.NumNodes();
+    // the multigrid hierarchy belongs to the solver of the time steps, the jacobians have their own solvers
+    SolverType type = solver.Type();
+    if (type == SolverType::GMG || type == SolverType::MatrixFree) { type = SolverType::CG; }
+    steady_solvers = std::vector<Solver>(n_species); // solvers are not copyable
+    for (Solver &s : steady_solvers)
+    {
+        s.SetType(type);
+        s.SetSymmetricStorage(assembler.Symmetric());
+        s.SetMixedPrecision(solver.MixedPrecision());
+    }
+
+    // the iterates meet the dirichlet conditions, so the updates vanish on the constrained nodes
+    const std::vector<int> &dofs = constraints.Dofs();
+    for (int s = 0; s < n_species; s++)
+    {
+        for (std::size_t k = 0; k < dofs.size(); k++) { u(s*n_nodes + dofs[k]) = constraints.Values()(k); }
+    }
+    const Eigen::VectorXd lumped_mass = M.selfadjointView<Eigen::Upper>()*Eigen::VectorXd::Ones(n_nodes);
+
+    Eigen::VectorXd F(u.size()), J_diag(u.size()), u_prev, F_prev, J_prev, b(n_nodes), d(n_nodes);
+    SteadyResidual(F, J_diag);
+    const double norm_0 = F.norm();
+    double norm = norm_0;
+    double tau = steady_initial_step > 0.0 ? steady_initial_step : dt;
+    double tau_factorized = 0.0;
+    double fresh_ratio = 1.0;
+    bool refactor = true;
+    int iter = 0;
+    int n_factorizations = 0;
+    steady_rejections = 0;
+    while (norm > steady_tol*norm_0 && iter < steady_max_iters)
+    {
+        iter++;
+        const bool factorize = refactor || tau > steady_refactor_ratio*tau_factorized || tau*steady_refactor_ratio < tau_factorized;
+        if (factorize)
+        {
+            for (int s = 0; s < n_species; s++) { FactorizeSteady(s, tau, lumped_mass, J_diag); }
+            tau_factorized = tau;
+            n_factorizations++;
+        }
+
+        // (M + tau J) d = tau F with the tau of the factorizations, the constrained rows of F are zero
+        u_prev = u;
+        F_prev = F;
+        J_prev = J_diag;
+        for (int s = 0; s < n_species; s++)
+        {
+            b = tau_factorized*F.segment(s*n_nodes, n_nodes);
+            d.setZero();
+            steady_solvers[s].Solve(b, d);
+            u.segment(s*n_nodes, n_nodes) += d;
+        }
+        const double norm_prev = norm;
+        SteadyResidual(F, J_diag);
+        norm = F.norm();
+        DEBUG("steady iteration %d, pseudo time step %e, residual %e", iter, tau_factorized, norm / norm_0);
+
+        if (!(norm <= 10.0*norm_prev))
+        {
+            // undo the step and retry it closer to a time step
+            u.swap(u_prev);
+            F.swap(F_prev);
+            J_diag.swap(J_prev);
+            norm = norm_prev;
+            tau = 0.1*tau_factorized;
+            refactor = true;
+            steady_rejections++;
+            continue;
+        }
+        // switched evolution relaxation, and new jacobians when the old ones contract the residual much less than fresh ones did
+        tau = std::min(steady_max_step, steady_growth*tau*norm_prev / std::max(norm, 1e-300));
+        const double ratio = norm / std::max(norm_prev, 1e-300);
+        if (factorize) { fresh_ratio = ratio; }
+        refactor = ratio > std::max(0.5, 1.5*fresh_ratio);
+    }
+    if (norm > steady_tol*norm_0)
+    {
+        WARN("no steady state after %d iterations, the residual is %e of the initial one", iter, norm / norm_0);
+    }
+    else
+    {
+        INFO("steady state in %d iterations with %d factorizations and %d rejected steps, the residual is %e of the initial one",
+             iter, n_factorizations, steady_rejections, norm_0 > 0.0 ? norm / norm_0 : 0.0);
+    }
+
+    TrackMemory();
+    steady_solvers.clear();
+    // A held the jacobians, and the solutions recycled by the time steps no longer lead to u
+    system_species = -1;
+    if (solver.Type() == SolverType::MatrixFree) { A = SparseMatrix(); }
+    for (Recycler &recycler : recyclers) { recycler.Clear(); }
+    return iter;
+}
+
+void Model::SteadyResidual(Eigen::VectorXd &F, Eigen::VectorXd &J_diag)
+{
+    const int n_nodes = mesh.NumNodes();
+    J_diag.setZero(u.size());
+    if (reactions.Empty()) { F.setZero(u.size()); }
+    else
+    {
+        const std::vector<std::pair<int, int>> &pattern = reactions.JacobianPattern();
+        Eigen::VectorXd J(pattern.size()*n_nodes);
+        R.resize(u.size());
+        reactions.Evaluate(u.data(), n_nodes, R.data(), J.data());
+        for (std::size_t k = 0; k < pattern.size(); k++)
+        {
+            const auto &[r, s] = pattern[k];
+            if (r == s) { J_diag.segment(s*n_nodes, n_nodes) = J.segment(k*n_nodes, n_nodes); }
+        }
+        MassProduct(R, F);
+    }
+    Eigen::VectorXd w(n_nodes);
+    for (int s = 0; s < n_species; s++)
+    {
+        UpdateStiffness(s);
+        const Diffusivity &D = diffusivity[s];
+        const SparseMatrix &S = D.Linear() ? K : Ks[s];
+        w = (D.Linear() ? D.D0 : 1.0)*u.segment(s*n_nodes, n_nodes);
+        // K and Ks hold the upper triangle only with symmetric storage
+        if (assembler.Symmetric()) { F.segment(s*n_nodes, n_nodes) -= S.selfadjointView<Eigen::Upper>()*w; }
+        else { F.segment(s*n_nodes, n_nodes) -= S*w; }
+        for (const int &dof : constraints.Dofs()) { F(s*n_nodes + dof) = 0.0; }
+    }
+}
+
+void Model::FactorizeSteady(const int &s, const double &tau, const Eigen::VectorXd &lumped_mass, const Eigen::VectorXd &J_diag)
+{
+    const Diffusivity &D = diffusivity[s];
+    const int n_nodes = mesh.NumNodes();
+    if (A.nonZeros() != M.nonZeros()) { A = M; }
+    if (D.Linear()) { A.coeffs() = M.coeffs() + (tau*D.D0)*K.coeffs(); }
+    else { A.coeffs() = M.coeffs() + tau*Ks[s].coeffs(); }
+    // decaying reactions only, a growing one would make the jacobian indefinite for the symmetric backends
+    A.diagonal() -= tau*lumped_mass.cwiseProduct(J_diag.segment(s*n_nodes, n_nodes).cwiseMin(0.0));
+    constraints.ApplyMatrix(A);
+    steady_solvers[s].Factorize(A);
+}
+
+void Model::InitStepper(Stepper &st, const double &dt, const bool &lumped)
+{
+    st.dt = dt;
+    st.lumped_mass = lumped ? Eigen::VectorXd(M.selfadjointView<Eigen::Upper>()*Eigen::VectorXd::Ones(M.rows())) : Eigen::VectorXd();
+    st.solvers = std::vector<Solver>(n_species); // cholesky, solvers are not copyable
+    st.constraints.assign(n_species, constraints);
+    st.Ks.assign(n_species, SparseMatrix());
+    st.coef.assign(n_species, std::vector<double>());
+    for (int s = 0; s < n_species; s++)
+    {
+        if (diffusivity[s].Linear()) { FactorizeStepper(st, s); }
+    }
+}
+
+void Model::FactorizeStepper(Stepper &st, const int &s)
+{
+    const Diffusivity &D = diffusivity[s];
+    if (st.A.nonZeros() != M.nonZeros()) { st.A = M; }
+    if (D.Linear()) { st.A.coeffs() = (st.dt*D.D0)*K.coeffs(); }
+    else { st.A.coeffs() = st.dt*st.Ks[s].coeffs(); }
+    if (st.lumped_mass.size() > 0) { st.A.diagonal() += st.lumped_mass; }
+    else { st.A.coeffs() += M.coeffs(); }
+    st.constraints[s].ApplyMatrix(st.A);
+    st.solvers[s].Factorize(st.A);
+}
+
+void Model::Advance(Stepper &st, Eigen::VectorXd &v, const int &steps)
+{
+    const int n_nodes = mesh.NumNodes();
+    Eigen::VectorXd w(v.size()), B(v.size()), b(n_nodes), v_s(n_nodes);
+    // weighted stiffness matrices are re-assembled in full first, so the result only depends on v and
+    // not on what the stepper propagated before
+    for (auto &coef : st.coef) { coef.clear(); }
+    for (int sub = 0; sub < steps; sub++)
+    {
+        // the reaction part of the right hand side, as in RightHandSides
+        if (reactions.Empty()) { w = v; }
+        else if (implicit_reactions) { st.integrator.Step(reactions, v.data(), n_nodes, st.dt, w.data()); }
+        else
+        {
+            reactions.Evaluate(v.data(), n_nodes, B.data());
+            w = v + st.dt*B;
+        }
+        if (st.lumped_mass.size() > 0)
+        {
+            for (int s = 0; s < n_species; s++) { B.segment(s*n_nodes, n_nodes) = st.lumped_mass.cwiseProduct(w.segment(s*n_nodes, n_nodes)); }
+        }
+        else { MassProduct(w, B); }
+
+        for (int s = 0; s < n_species; s++)
+        {
+            const Diffusivity &D = diffusivity[s];
+            if (!D.Linear())
+            {
+                assembler.Reassemble(mesh, D, v.segment(s*n_nodes, n_nodes), st.Ks[s], st.coef[s], reassembly_tol);
+                FactorizeStepper(st, s);
+            }
+            b = B.segment(s*n_nodes, n_nodes);
+            st.constraints[s].ApplyRHS(b);
+            st.solvers[s].Solve(b, v_s);
+            v.segment(s*n_nodes, n_nodes) = v_s;
+        }
+    }
+}
+
+void Model::Adapt()
+{
+    if (!refiner.Supported(mesh))
+    {
+        WARN("adaptive refinement needs a LinTri or LinTet mesh, skipping");
+        return;
+    }
+    if (solver.Type() == SolverType::GMG)
+    {
+        WARN("adaptive refinement would break the nested meshes of the multigrid solver, skipping");
+        return;
+    }
+
+    std::vector<double> eta = ErrorIndicator();
+    double eta_max = *std::max_element(eta.begin(), eta.end());
+    std::vector<char> marked(eta.size());
+    for (std::size_t e = 0; e < eta.size(); e++)
+    {
+        marked[e] = refiner.Generation(mesh)[e] > 0 && eta[e] < coarsen_fraction*eta_max;
+    }
+    ApplyChange(refiner.Coarsen(mesh, marked));
+
+    eta = ErrorIndicator();
+    eta_max = *std::max_element(eta.begin(), eta.end());
+    marked.resize(eta.size());
+    for (std::size_t e = 0; e < eta.size(); e++)
+    {
+        marked[e] = refiner.Generation(mesh)[e] < max_refinement_level && eta[e] > refine_fraction*eta_max;
+    }
+    ApplyChange(refiner.Refine(mesh, marked));
+}
+
+void Model::SetSolution(const Eigen::VectorXd &v)
+{
+    Assert(v.size() == u.size(), "solution of size %d for %d nodes and %d species", static_cast<int>(v.size()), mesh.NumNodes(), n_species);
+    u = v;
+    for (Recycler &recycler : recyclers) { recycler.Clear(); }
+}
+
+std::vector<double> Model::ErrorIndicator()
+{
+    const int n_nodes = mesh.NumNodes();
+    std::vector<double> eta;
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() != mesh.Dim()) { return; }
+        constexpr int npe = std::decay_t<decltype(block)>::NPE();
+        eta.resize(block.Size());
+        #pragma omp parallel for
+        for (int e = 0; e < block.Size(); e++)
+        {
+            auto &elem = block.elems[e];
+            double volume = 0.0;
+            double grad = 0.0;
+            for (int i = 0; i < npe; i++)
+            {
+                for (int j = 0; j < npe; j++)
+                {
+                    volume += elem.m(i,j);
+                    for (int s = 0; s < n_species; s++)
+                    {
+                        grad += u(s*n_nodes + elem.Nodes(i).node_id)*elem.k(i,j)*u(s*n_nodes + elem.Nodes(j).node_id);
+                    }
+                }
+            }
+            const double h = std::pow(volume, 1.0 / mesh.Dim());
+            eta[e] = h*std::sqrt(std::max(grad, 0.0));
+        }
+    });
+    return eta;
+}
+
+void Model::ApplyChange(const MeshChange &change)
+{
+    if (change.Empty()) { return; }
+
+    // nodes that remain keep their values, added nodes interpolate the edge they split
+    const int n_old = static_cast<int>(change.node_map.size());
+    const int n_nodes = mesh.NumNodes();
+    const int first_new = n_nodes - static_cast<int>(change.new_nodes.size());
+    Eigen::VectorXd v(n_nodes*n_species);
+    for (int s = 0; s < n_species; s++)
+    {
+        for (int n = 0; n < n_old; n++)
+        {
+            if (change.node_map[n] >= 0) { v(s*n_nodes + change.node_map[n]) = u(s*n_old + n); }
+        }
+        for (int k = 0; k < static_cast<int>(change.new_nodes.size()); k++)
+        {
+            const auto &[a, b] = change.new_nodes[k];
+            v(s*n_nodes + first_new + k) = 0.5*(v(s*n_nodes + a) + v(s*n_nodes + b));
+        }
+    }
+    u.swap(v);
+
+    assembler.Update(mesh, change);
+    constraints.Init(mesh, assembler.Pattern());
+    for (auto &Ks_s : Ks) { Ks_s.resize(0, 0); }
+    A.resize(0, 0);
+    // the mesh of the matrix-free operator is gone, and the backend that fits the budget may differ on the new mesh
+    if (solver.Type() == SolverType::MatrixFree) { solver.GetMultigrid().Clear(); }
+    SelectSolver();
+    solver.ResetPattern();
+    for (Recycler &recycler : recyclers) { recycler.Clear(); }
+    GlobalAssembly();
+    locator.Build(mesh);
+    if (probes.cols() > 0) { SetProbes(probes); }
+}
+
+void Model::SetProbes(const Eigen::Ref<const Eigen::MatrixXd> &points)
+{
+    probes = points;
+    const std::vector<PointLocation> locations = locator.Locate(mesh, probes);
+    const int n_outside = static_cast<int>(std::count_if(locations.begin(), locations.end(), [](const PointLocation &loc) { return loc.elem < 0; }));
+    if (n_outside > 0) { WARN("%d probe points are outside the mesh", n_outside); }
+    probe_interp = locator.Interpolation(mesh, locations);
+}
+
+Eigen::MatrixXd Model::Probe() const
+{
+    // species are contiguous blocks of u, so u is a nodes x species matrix and all species are interpolated at once
+    const Eigen::Map<const Eigen::MatrixXd> U(u.data(), mesh.NumNodes(), n_species);
+    return probe_interp*U;
+}
+
+void Model::RightHandSides(Eigen::VectorXd &B)
+{
+    // right hand sides M (u + dt R) of all species in one product over M
+    if (reactions.Empty())
+    {
+        MassProduct(u, B);
+        return;
+    }
+    if (implicit_reactions)
+    {
+        // stiff reactions over the whole step at every node first, then diffusion from there
+        u_react.resize(u.size());
+        integrator.Step(reactions, u.data(), mesh.NumNodes(), dt, u_react.data());
+        MassProduct(u_react, B);
+        return;
+    }
+    R.resize(u.size());
+    reactions.Evaluate(u.data(), mesh.NumNodes(), R.data());
+    MassProduct(u + dt*R, B);
+}
+
+void Model::MassProduct(const Eigen::VectorXd &W, Eigen::VectorXd &B) const
+{
+    if (assembler.Symmetric()) { M_sym.Multiply(W.data(), B.data(), n_species); }
+    else { M_sell.Multiply(W.data(), B.data(), n_species); }
+}
+
+void Model::UpdateStiffness(const int &s)
+{
+    const Diffusivity &D = diffusivity[s];
+    if (D.Linear()) { return; }
+    const int n_nodes = mesh.NumNodes();
+    assembler.Reassemble(mesh, D, u.segment(s*n_nodes, n_nodes), Ks[s], elem_coef[s], reassembly_tol);
+}
+
+void Model::SolveSpecies(const Eigen::VectorXd &B)
+{
+    const int n_nodes = mesh.NumNodes();
+    Eigen::VectorXd b(n_nodes);
+    Eigen::VectorXd u_s(n_nodes);
+    for (int s = 0; s < n_species; s++)
+    {
+        BuildSystem(s);
+        b = B.segment(s*n_nodes, n_nodes);
+        constraints.ApplyRHS(b);
+        u_s = u.segment(s*n_nodes, n_nodes);
+        solver.Solve(b, u_s, recyclers[s]);
+        u.segment(s*n_nodes, n_nodes) = u_s;
+    }
+    TrackMemory();
+}
+
+void Model::BuildSystem(const int &s)
+{
+    const Diffusivity &D = diffusivity[s];
+    if (D.Linear() && system_species >= 0 && diffusivity[system_species].D0 == D.D0) { return; }
+
+    if (solver.Type() == SolverType::MatrixFree)
+    {
+        // nothing is formed, the multigrid applies the system and the constraints keep the lift of its columns
+        Assert(D.Linear(), "the matrix-free solver needs constant diffusivities, species %d has a solution dependent one", s);
+        constraints.SetLift(M, 1.0, K, dt*D.D0);
+        solver.GetMultigrid().SetOperator(1.0, dt*D.D0);
+        solver.Factorize();
+        system_species = s;
+        return;
+    }
+
+    // K, Ks and M share the assembled pattern, so the system matrix is formed on the value arrays
+    if (A.nonZeros() != M.nonZeros()) { A = M; }
+    if (D.Linear())
+    {
+        A.coeffs() = M.coeffs() + (dt*D.D0)*K.coeffs();
+    }
+    else
+    {
+        A.coeffs() = M.coeffs() + dt*Ks[s].coeffs();
+    }
+    constraints.ApplyMatrix(A);
+    // the multigrid works on the constant part of the diffusivity, which still preconditions the weighted stiffness
+    if (solver.Type() == SolverType::GMG) { solver.GetMultigrid().SetOperator(1.0, dt*D.D0); }
+    solver.Factorize(A);
+    system_species = D.Linear() ? s : -1;
+}
+
+std::size_t Model::EstimateMemory(const SolverType &type) const
+{
+    const SparseMatrix &pattern = assembler.Pattern();
+    const std::size_t n = pattern.rows();
+    const std::size_t nnz = pattern.nonZeros();
+    const std::size_t matrix = Bytes(pattern);
+    // a sell or symmetric copy holds a value, a row or column and a source position per entry, sell some padding
+    const std::size_t copy = nnz*(sizeof(double) + 2*sizeof(int))*11/10;
+    const int n_nonlinear = static_cast<int>(std::count_if(diffusivity.begin(), diffusivity.begin() + n_species,
+                                                           [](const Diffusivity &D) { return !D.Linear(); }));
+
+    // mesh, elements, pattern, K, M, Mb, the copy of M, the weighted stiffness matrices and the vectors of all species
+    std::size_t bytes = mesh.MemoryBytes(MemoryUse::Mesh) + mesh.MemoryBytes(MemoryUse::Geometry) + assembler.MemoryBytes();
+    bytes += (3 + n_nonlinear)*matrix + copy + 4*n*n_species*sizeof(double);
+
+    // element geometry, coloring, diagonals and work vectors of a multigrid level of the current simplex mesh
+    const std::size_t n_elems = mesh.NumElems();
+    const std::size_t geometry = n_elems*((n_dims + 1)*sizeof(int) + (1 + (n_dims + 1)*n_dims)*sizeof(double) + sizeof(int))
+                               + n*(sizeof(char) + 7*sizeof(double));
+    const bool mixed = solver.MixedPrecision();
+    const std::size_t scalar = mixed ? sizeof(float) : sizeof(double);
+    switch (type)
+    {
+        case SolverType::Cholesky:
+        case SolverType::Pardiso:
+        case SolverType::PardisoLU:
+        {
+            // the system, the factor with its diagonal and orderings, and the reordered system copied by every factorization
+            std::size_t factor = CholeskyNonZeros(pattern);
+            if (type == SolverType::PardisoLU) { factor *= 2; }
+            bytes += 2*matrix + factor*(scalar + sizeof(int)) + n*(scalar + 4*sizeof(int));
+            // the single precision system and the copy for the residuals of the refinement
+            if (mixed) { bytes += nnz*(sizeof(float) + sizeof(int)) + copy + 3*n*sizeof(double); }
+            break;
+        }
+        case SolverType::CG:
+        case SolverType::AMG:
+        case SolverType::GMG:
+            // the system, its copy, the cg vectors with the jacobi diagonal and the recycled solutions with their basis
+            bytes += matrix + copy + 5*n*scalar + 3*recycled_vectors*n*n_species*sizeof(double);
+            if (mixed) { bytes += nnz*sizeof(float); }
+            // smoothed aggregation has an operator complexity of about 1.5, and every level a copy and transfers
+            if (type == SolverType::AMG) { bytes += matrix + copy; }
+            if (type == SolverType::GMG) { bytes += geometry; }
+            break;
+        case SolverType::MatrixFree:
+            bytes += geometry + 5*n*sizeof(double);
+            break;
+        default:
+            break;
+    }
+    return bytes;
+}
+
+bool Model::MatrixFreeAvailable() const
+{
+    const bool simplex = (mesh.ElemType() == ElementType::LinTri && mesh.Dim() == 2) || (mesh.ElemType() == ElementType::LinTet && mesh.Dim() == 3);
+    const bool linear = std::all_of(diffusivity.begin(), diffusivity.begin() + n_species, [](const Diffusivity &D) { return D.Linear(); });
+    return simplex && linear && !solver.MixedPrecision();
+}
+
+void Model::SelectSolver()
+{
+    if (memory_budget > 0.0)
+    {
+        constexpr double MB = 1024.0*1024.0;
+        // the backend of the condition file, then the ones holding less memory
+        std::vector<SolverType> candidates{preferred_solver};
+        if (preferred_solver != SolverType::CG && preferred_solver != SolverType::GMG && preferred_solver != SolverType::MatrixFree)
+        {
+            candidates.push_back(SolverType::CG);
+        }
+        if (preferred_solver != SolverType::MatrixFree && MatrixFreeAvailable()) { candidates.push_back(SolverType::MatrixFree); }
+
+        SolverType type = candidates.back();
+        std::size_t bytes = 0;
+        for (const SolverType &candidate : candidates)
+        {
+            type = candidate;
+            bytes = EstimateMemory(candidate);
+            if (bytes <= memory_budget*MB) { break; }
+        }
+        if (bytes > memory_budget*MB)
+        {
+            WARN("the %s solver needs an estimated %.1f MB, more than the memory budget of %.1f MB", SolverName(type), bytes / MB, memory_budget);
+        }
+        else
+        {
+            INFO("%s solver within the memory budget of %.1f MB, estimated %.1f MB", SolverName(type), memory_budget, bytes / MB);
+        }
+        if (type != solver.Type())
+        {
+            solver.SetType(type);
+            system_species = -1;
+            if (type == SolverType::MatrixFree) { A = SparseMatrix(); }
+        }
+    }
+
+    // the matrix-free backend applies the system on the current mesh
+    Multigrid &levels = solver.GetMultigrid();
+    if (solver.Type() == SolverType::MatrixFree && levels.NumNodes() != mesh.NumNodes())
+    {
+        levels.Clear();
+        levels.AddLevel(mesh, MeshChange());
+        levels.SetConstraints(constraints.Dofs());
+    }
+}
+
+void Model::TrackMemory()
+{
+    std::size_t geometry = mesh.MemoryBytes(MemoryUse::Geometry);
+    std::size_t matrices = assembler.MemoryBytes() + Bytes(K) + Bytes(M) + Bytes(Mb) + Bytes(A) + M_sell.MemoryBytes() + M_sym.MemoryBytes();
+    std::size_t factorization = 0;
+    std::size_t krylov = 0;
+    for (const SparseMatrix &Ks_s : Ks) { matrices += Bytes(Ks_s); }
+    for (const Recycler &recycler : recyclers) { krylov += recycler.MemoryBytes(); }
+    auto add = [&](const Solver &s)
+    {
+        geometry += s.MemoryBytes(MemoryUse::Geometry);
+        matrices += s.MemoryBytes(MemoryUse::Matrices);
+        factorization += s.MemoryBytes(MemoryUse::Factorization);
+        krylov += s.MemoryBytes(MemoryUse::Krylov);
+    };
+    add(solver);
+    for (const Solver &s : rate_solvers) { add(s); }
+    for (const Solver &s : steady_solvers) { add(s); }
+    memory.Set(MemoryUse::Mesh, mesh.MemoryBytes(MemoryUse::Mesh));
+    memory.Set(MemoryUse::Geometry, geometry);
+    memory.Set(MemoryUse::Matrices, matrices);
+    memory.Set(MemoryUse::Factorization, factorization);
+    memory.Set(MemoryUse::Krylov, krylov);
+}
+
+StepDiagnostics Model::Diagnose(const int &step, const Eigen::VectorXd &v) const
+{
+    const Eigen::Map<const Eigen::MatrixXd> V(v.data(), mesh.NumNodes(), n_species);
+    StepDiagnostics diag;
+    diag.step = step;
+    diag.time = step*dt;
+    // M holds the upper triangle only with symmetric storage, which the view reads for both storages
+    diag.mass = (M.selfadjointView<Eigen::Upper>()*V).colwise().sum().transpose();
+    diag.min = V.colwise().minCoeff().transpose();
+    diag.max = V.colwise().maxCoeff().transpose();
+    if (probe_interp.rows() > 0) { diag.probes = probe_interp*V; }
+    return diag;
+}
+
+void Model::WriteSolution(const int &step, const Eigen::VectorXd &v)
+{
+    const std::string file_name = output_file + "_" + std::to_string(step) + ".dat";
+    std::ofstream out(file_name);
+    if (!out)
+    {
+        WARN("could not open output file %s", file_name.c_str());
+        return;
+    }
+    const int n_nodes = mesh.NumNodes();
+    out << "# step " << step << " time " << step*dt << "\n";
+    out.precision(12);
+    for (int n = 0; n < n_nodes; n++)
+    {
+        out << mesh.Nodes(n).Coords(0);
+        for (int d = 1; d < mesh.Dim(); d++) { out << " " << mesh.Nodes(n).Coords(d); }
+        for (int s = 0; s < n_species; s++) { out << " " << v(s*n_nodes + n); }
+        out << "\n";
+    }
+}
@@ -1,27 +1,335 @@
 #ifndef MODEL_INCL
 #define MODEL_INCL
 
+#include "assembler.h"
+#include "constraints.h"
+#include "history.h"
+#include "locator.h"
+#include "memory.h"
 #include "mesh.h"
+#include "monitor.h"
+#include "refiner.h"
 #include "solver.h"
+#include "reaction/integrator.h"
+#include "reaction/reaction.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
+
+/** @brief diffusivity of a species as a function of its own concentration, D(u) = D0 (1 + beta u) */
+struct Diffusivity
+{
+    double D0 = 1.0;    /** @brief diffusivity at u = 0 */
+    double beta = 0.0;  /** @brief linear dependence on u */
+
+    inline double operator()(const double &u) const { return D0*(1.0 + beta*u); }
+
+    /** @brief true if the diffusivity does not depend on the solution */
+    inline bool Linear() const { return beta == 0.0; }
+};
+
+/** @brief summary of the solution at one step of Run */
+struct StepDiagnostics
+{
+    int step = 0;           /** @brief time step index */
+    double time = 0.0;      /** @brief simulated time */
+    Eigen::VectorXd mass;   /** @brief integral of each species over the domain */
+    Eigen::VectorXd min;    /** @brief smallest nodal value of each species */
+    Eigen::VectorXd max;    /** @brief largest nodal value of each species */
+    Eigen::MatrixXd probes; /** @brief values at the probe points, empty without probes.  @see Model::Probe */
+};
 
 class Model
 {
     public:
         Model();
         void ReadCondition();
-        void GlobalAssembly() {};
-        void Solve() {};
-        void WriteSolution() {};
+
+        /** @brief assemble the global matrices by looping over the mesh element blocks */
+        void GlobalAssembly();
+
+        /**
+         * @brief advance every species one step, backward euler in the diffusion and explicit in the
+         * reactions, (M + dt D K) u^{n+1} = M (u^{n} + dt R(u^{n})), with the dirichlet conditions
+         * eliminated from the system.  with implicit reactions the explicit term is replaced by a
+         * backward euler step of the reactions alone at every node, u* = u^{n} + dt R(u*), and
+         * (M + dt D K) u^{n+1} = M u*
+         */
+        void Solve();
+
+        /**
+         * @brief advance every species one step of dt in substeps of dt / m_s, with m_s from the substeps of the
+         * condition file.  species are advanced from the fewest substeps to the most, each with its own
+         * factorization of M + dt/m_s D_s K kept between steps.  the reaction terms of a substep are
+         * evaluated with the species already advanced interpolated linearly in time over the step, the
+         * species being advanced at their current values and the others at the start of the step.  Solve
+         * and Run use it when a species has more than one substep.
+         */
+        void SolveMultirate();
+
+        /**
+         * @brief advance n_steps steps as a task graph.  within a step the reaction terms and the right hand
+         * sides are formed while the solution dependent stiffness matrices are re-assembled, and the solution
+         * of every output step (step 0 included) is copied aside, diagnosed and written while the next step
+         * is solved.  at most four stages run at once, and the parallel loops nested in them share the threads.
+         * the results are those of calling Solve n_steps times.  with a monitor file the solution of
+         * every step is also published to it, as a task overlapping the next step.  @see MonitorPublisher.  with a
+         * history file the output steps are compressed and appended to it by the writer tasks.  @see HistoryWriter.
+         * the memory of the subsystems and its peaks are logged at the end.  @see MemoryTracker.  steps are
+         * numbered on from Step(), so successive runs continue the numbering of the outputs.  with an adapt interval
+         * the tasks are drained and the mesh is adapted after every adapt interval steps, as Solve followed by Adapt
+         * @param n_steps number of time steps
+         */
+        void Run(const int &n_steps);
+
+        /**
+         * @brief advance n_steps steps with parareal, parallel in time.  the steps are cut into time slices
+         * and a coarse propagator (steps of coarse factor * dt with a lumped mass matrix) predicts the state at
+         * the start of every slice sequentially.  each iteration runs the fine propagator, the scheme of Solve,
+         * over all unconverged slices in parallel threads and corrects the starts of the slices with the
+         * coarse propagator, U_{j+1} = G(U_j) + F(U_j^{old}) - G(U_j^{old}), until they change by less than the
+         * parareal tolerance.  after k iterations the first k slices are exact, so this converges to the
+         * sequential result in at most as many iterations as slices.  every propagator has its own systems
+         * and cholesky factorizations, parareal is meant for meshes too small to keep the threads busy
+         * with spatial parallelism.  the diagnostics of the end of every slice are added, numbered on from
+         * Step() like the steps of Run, the current step is not recorded again.
+         * @param n_steps number of fine time steps
+         * @return number of parareal iterations
+         */
+        int Parareal(const int &n_steps);
+
+        /**
+         * @brief solve for the steady state F(u) = M R(u) - D K u = 0 of every species directly, by newton's method
+         * with pseudo-transient continuation: (M / tau + J) d = F(u), u += d.  the pseudo time step tau grows by
+         * switched evolution relaxation with the steady growth g, tau_{k+1} = g tau_k |F(u_{k-1})| / |F(u_k)| up to
+         * the steady max step, so the iteration starts as backward euler steps and ends as newton's method.  g > 1
+         * keeps tau growing through the slow decay of the residual on large domains.  J of a species is
+         * D K, with the stiffness weighted by the diffusivity at u if it depends on u, plus the lumped mass
+         * times the decay rate of the species in its own reaction; the coupling of the species by the
+         * reactions is left to the iteration.  the factorizations of J (the preconditioners of the
+         * iterative backends) are kept while tau stays within the refactor ratio of the tau they were
+         * formed with and they contract the residual about as well as fresh ones, so they are reused once tau
+         * stops growing.  a step raising the residual tenfold is undone and retried with a tenth of tau.
+         * the multigrid backends are replaced by cg.  Run(0) writes and diagnoses the result
+         * @return number of nonlinear iterations
+         */
+        int SolveSteady();
+
+        /** @brief diagnostics of the output steps of Run, in step order */
+        inline const std::vector<StepDiagnostics>& Diagnostics() const { return diagnostics; }
+
+        /** @brief current solution, one contiguous block of nodes per species */
+        inline const Eigen::VectorXd& Solution() const { return u; }
+
+        /** @brief set the current solution, e.g. an initial condition, in the layout of Solution */
+        void SetSolution(const Eigen::VectorXd &v);
+
+        /** @brief global mesh, the nodes of the current solution */
+        inline Mesh& GetMesh() { return mesh; }
+
+        /** @brief time steps taken by Solve, Run and Parareal, the step index of the current solution */
+        inline int Step() const { return step; }
+
+        /** @brief steps undone and retried with a smaller pseudo time step by the last SolveSteady */
+        inline int SteadyRejections() const { return steady_rejections; }
+
+        /**
+         * @brief adapt the mesh to the solution.  elements with a small error indicator are coarsened
+         * first, then elements with a large indicator on the coarsened mesh are refined.  the solution is
+         * transferred by linear interpolation and the pattern, matrices and constraints are updated.
+         */
+        void Adapt();
+
+        /**
+         * @brief set the points the solution is sampled at.  the points are located once, and again
+         * whenever the mesh changes
+         * @param points one column per point, one row per spatial dimension of the mesh
+         */
+        void SetProbes(const Eigen::Ref<const Eigen::MatrixXd> &points);
+
+        /** @brief solution at the probe points, one row per point and one column per species */
+        Eigen::MatrixXd Probe() const;
+
+        /** @brief current and peak memory of the subsystems, updated by GlobalAssembly and every step and reported at the end of Run */
+        inline const MemoryTracker& Memory() const { return memory; }
+
+        /**
+         * @brief estimate of the memory a time step needs with a linear solver backend, from the mesh, the
+         * sparsity pattern and the symbolic analysis of the factorization for the direct backends
+         * @return bytes
+         */
+        std::size_t EstimateMemory(const SolverType &type) const;
+
+        /** @brief write a solution to <output file>_<step>.dat, one line per node with its coordinates and species values */
+        void WriteSolution(const int &step, const Eigen::VectorXd &v);
+
+    private:
+        /**
+         * @brief error indicator of each domain element, eta_e = h_e |grad u|_{L2(e)} summed over the
+         * species.  computed from the cached unit element matrices, |grad u|^2_{L2(e)} = u_e^T K_e u_e
+         * and |e| = sum of M_e.
+         */
+        std::vector<double> ErrorIndicator();
+
+        /** @brief backward euler time stepper with its own systems and factorizations, so steppers run concurrently */
+        struct Stepper
+        {
+            double dt = 0.0;                        /** @brief step size */
+            Eigen::VectorXd lumped_mass;            /** @brief row sums of M, empty for the consistent mass matrix */
+            std::vector<Solver> solvers;            /** @brief factorized system of each species */
+            std::vector<Constraints> constraints;   /** @brief dirichlet conditions with the lift values of each species system */
+            std::vector<SparseMatrix> Ks;           /** @brief weighted stiffness of each species */
+            std::vector<std::vector<double>> coef;  /** @brief element diffusivities assembled into Ks */
+            ReactionIntegrator integrator;          /** @brief implicit reaction steps */
+            SparseMatrix A;                         /** @brief system matrix being formed */
+        };
+
+        /** @brief true if a species takes more than one substep per time step */
+        inline bool Multirate() const { return std::any_of(substeps.begin(), substeps.end(), [](const int &m) { return m > 1; }); }
+
+        /** @brief form and factorize the substep system M + dt/m_s D_s K of species s for SolveMultirate */
+        void FactorizeRate(const int &s);
+
+        /**
+         * @brief steady residual F_s = M R_s(u) - D_s K u_s of every species, zero in the constrained rows, and
+         * the derivative dR_s/du_s of the reaction of every species by itself at the nodes
+         * @param F residuals, same layout as u
+         * @param J_diag reaction derivatives, same layout as u
+         */
+        void SteadyResidual(Eigen::VectorXd &F, Eigen::VectorXd &J_diag);
+
+        /** @brief form and factorize the pseudo-transient jacobian M + tau (D_s K - M_L min(dR_s/du_s, 0)) of species s for SolveSteady */
+        void FactorizeSteady(const int &s, const double &tau, const Eigen::VectorXd &lumped_mass, const Eigen::VectorXd &J_diag);
+
+        /** @brief set up a stepper and factorize the systems of the species with a constant diffusivity */
+        void InitStepper(Stepper &st, const double &dt, const bool &lumped);
+
+        /** @brief form and factorize the system matrix of species s in a stepper */
+        void FactorizeStepper(Stepper &st, const int &s);
+
+        /** @brief advance a solution by a number of steps of a stepper, the scheme of Solve */
+        void Advance(Stepper &st, Eigen::VectorXd &v, const int &steps);
+
+        /** @brief true if the systems can be solved matrix-free: simplex elements spanning the space, constant diffusivities and double precision */
+        bool MatrixFreeAvailable() const;
+
+        /**
+         * @brief with a memory budget, choose the linear solver backend of Solve and Run: the one of the condition
+         * file if its estimate fits the budget, else the assembled cg, else the matrix-free cg, which need
+         * less memory in this order.  the one needing the least is used if none fits.  the matrix-free
+         * backend gets the current mesh as its only level unless the hierarchy of the mesh is there
+         */
+        void SelectSolver();
+
+        /** @brief report the memory held by the mesh, matrices and solvers to the tracker */
+        void TrackMemory();
+
+        /**
+         * @brief bring the solution and the global matrices up to date with a changed mesh
+         * @param change change returned by the refiner
+         */
+        void ApplyChange(const MeshChange &change);
+
+        /**
+         * @brief right hand sides M (u + dt R(u)) of all species, with the reaction terms evaluated at u,
+         * or M u* after the implicit reaction step
+         * @param B right hand sides, same layout as u
+         */
+        void RightHandSides(Eigen::VectorXd &B);
+
+        /** @brief B = M W for all species at once, with the copy of M for the storage of the assembler */
+        void MassProduct(const Eigen::VectorXd &W, Eigen::VectorXd &B) const;
+
+        /**
+         * @brief re-assemble the stiffness of species s for its solution dependent diffusivity,
+         * incrementally for dirty elements only.  does nothing for a constant diffusivity
+         * @param s species index
+         */
+        void UpdateStiffness(const int &s);
+
+        /**
+         * @brief solve the systems of all species in turn and update u
+         * @param B right hand sides from RightHandSides
+         */
+        void SolveSpecies(const Eigen::VectorXd &B);
+
+        /**
+         * @brief form and factorize the system matrix M + dt D_s K of species s, with Ks from
+         * UpdateStiffness for a solution dependent diffusivity.  the factorization is kept when the previous
+         * system had the same constant diffusivity.
+         * @param s species index
+         */
+        void BuildSystem(const int &s);
+
+        /** @brief mass, range and probe values of a solution */
+        StepDiagnostics Diagnose(const int &step, const Eigen::VectorXd &v) const;
     private:
         int n_dims;         /** @brief number of spatial dimensions */
         double dt;          /** @brief time step size */
+        int step;           /** @brief time steps taken, the index of the solution in u */
         int n_species;      /** @brief number of chemical species */
+        std::vector<Diffusivity> diffusivity; /** @brief diffusivity of each species */
+        double reassembly_tol; /** @brief relative change of an element diffusivity that triggers re-assembly */
+        int uniform_refinements; /** @brief uniform refinements of the mesh read in, the levels of the geometric multigrid */
+        double refine_fraction; /** @brief elements with an error indicator above this fraction of the largest are refined */
+        double coarsen_fraction; /** @brief elements with an error indicator below this fraction of the largest are coarsened */
+        int max_refinement_level; /** @brief maximum number of bisections of an initial element */
+        int adapt_interval; /** @brief steps between adaptations of the mesh by Run, 0 for none */
+        std::string output_file; /** @brief prefix of the solution files written by Run, empty for no output */
+        int output_interval; /** @brief steps between outputs and diagnostics of Run */
+        std::string history_file; /** @brief compressed history the output steps of Run are appended to, empty for none */
+        int history_keyframes; /** @brief frames between keyframes of the history */
+        HistoryWriter history; /** @brief writer of the history file */
+        std::string monitor_file; /** @brief shared file the solutions of Run are published to, empty for none */
+        int monitor_slots;  /** @brief slots of the ring buffer in the monitor file */
+        MonitorPublisher monitor; /** @brief live view of the solution for monitoring processes */
+        std::vector<StepDiagnostics> diagnostics; /** @brief diagnostics of the output steps of Run */
         SparseMatrix K;     /** @brief global stiffness/tangent matrix */
-        Eigen::VectorXd u;  /** @brief global solution vector */
+        SparseMatrix M;     /** @brief global mass matrix */
+        SellMatrix M_sell;  /** @brief copy of M for the products with all species at once */
+        SymmetricMatrix M_sym; /** @brief copy of M used instead of M_sell with symmetric storage */
+        SparseMatrix Mb;    /** @brief global boundary mass matrix, assembled from the boundary element blocks */
+        std::vector<SparseMatrix> Ks; /** @brief stiffness weighted by a solution dependent diffusivity, per species */
+        std::vector<std::vector<double>> elem_coef; /** @brief element diffusivities assembled into Ks, per species */
+        SparseMatrix A;     /** @brief system matrix M + dt K with constraints applied */
+        int system_species; /** @brief species whose constant coefficient system is in A, -1 if none */
+        Eigen::VectorXd u;  /** @brief global solution vector, one contiguous block of nodes per species */
+        ReactionSystem reactions; /** @brief compiled reaction terms */
+        Eigen::VectorXd R;  /** @brief nodal reaction terms, same layout as u */
+        bool implicit_reactions; /** @brief backward euler in the reactions, split from the diffusion */
+        ReactionIntegrator integrator; /** @brief pointwise implicit reaction steps */
+        Eigen::VectorXd u_react; /** @brief solution after the implicit reaction step, same layout as u */
         Mesh mesh;          /** @brief global mesh */
-        //Solver solver;
+        Refiner refiner;    /** @brief adaptive refinement and coarsening of the mesh */
+        Assembler assembler; /** @brief global sparsity pattern and element block scatter maps */
+        Locator locator;    /** @brief point location in the domain elements */
+        Eigen::MatrixXd probes; /** @brief probe points, one column per point */
+        InterpolationMatrix probe_interp; /** @brief interpolation from the nodes to the probe points */
+        Constraints constraints; /** @brief dirichlet boundary conditions */
+        Solver solver;      /** @brief linear solver for the system matrix */
+        SolverType preferred_solver; /** @brief linear solver backend of the condition file */
+        double memory_budget; /** @brief memory in MB the linear solver backend is chosen for, 0 for none */
+        MemoryTracker memory; /** @brief current and peak memory of the subsystems */
+        int recycled_vectors; /** @brief previous solutions per species recycled by iterative solves, 0 for none */
+        int extrapolation_order; /** @brief degree of the extrapolation in time of the initial guess of iterative solves */
+        std::vector<Recycler> recyclers; /** @brief previous solutions of each species */
+        std::vector<int> substeps; /** @brief substeps of each species per time step */
+        std::vector<Solver> rate_solvers; /** @brief factorized substep system of each species */
+        std::vector<Constraints> rate_constraints; /** @brief dirichlet conditions with the lift values of each substep system */
+        bool rates_factorized; /** @brief the substep systems of the constant diffusivities are up to date */
+        int parareal_slices; /** @brief time slices of Parareal, 0 for one per thread */
+        int parareal_coarsening; /** @brief ratio of the coarse to the fine step of Parareal */
+        int parareal_max_iters; /** @brief maximum iterations of Parareal */
+        double parareal_tol; /** @brief change of the slice starts relative to their norm at which Parareal stops */
+        double steady_tol;  /** @brief residual relative to the initial one at which SolveSteady stops */
+        int steady_max_iters; /** @brief maximum nonlinear iterations of SolveSteady */
+        double steady_initial_step; /** @brief first pseudo time step of SolveSteady, 0 for the time step */
+        double steady_max_step; /** @brief largest pseudo time step of SolveSteady */
+        double steady_growth; /** @brief factor on the residual ratio by which SolveSteady grows the pseudo time step */
+        double steady_refactor_ratio; /** @brief change of the pseudo time step that makes SolveSteady factorize the jacobians again */
+        std::vector<Solver> steady_solvers; /** @brief factorized jacobian of each species during SolveSteady */
+        int steady_rejections; /** @brief steps undone by the last SolveSteady */
 };
 
 #endif // MODEL_INCL
\ No newline at end of file
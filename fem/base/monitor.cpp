@@ -0,0 +1,184 @@
+#include "monitor.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief slots are kept a multiple of a cache line, so the values of every slot are aligned */
+static std::size_t RoundUp(const std::size_t &bytes)
+{
+    return (bytes + 63) / 64 * 64;
+}
+
+MonitorPublisher::~MonitorPublisher()
+{
+    Close();
+}
+
+void MonitorPublisher::Open(const std::string &file_name, const int &n_slots)
+{
+    Close();
+    Assert(n_slots >= 2 && n_slots <= MonitorHeader::max_slots, "monitor ring of %d slots, needs 2 to %d", n_slots,
+           MonitorHeader::max_slots);
+    this->n_slots = n_slots;
+    fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    Assert(fd >= 0, "could not open monitor file %s", file_name.c_str());
+    slot_bytes = RoundUp(sizeof(MonitorHeader::SlotInfo));
+    map_bytes = sizeof(MonitorHeader) + n_slots*slot_bytes;
+    Assert(ftruncate(fd, map_bytes) == 0, "could not size monitor file %s", file_name.c_str());
+    void *addr = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    Assert(addr != MAP_FAILED, "could not map monitor file %s", file_name.c_str());
+
+    // the file is zero filled, so the counters start at 0.  the magic number is written last, a reader
+    // that sees it sees the rest of the header
+    header = static_cast<MonitorHeader*>(addr);
+    header->n_slots = n_slots;
+    header->slot_bytes.store(slot_bytes, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MonitorHeader::magic_number;
+    INFO("publishing solutions to %s in %d slots", file_name.c_str(), n_slots);
+}
+
+void MonitorPublisher::Close()
+{
+    if (header != nullptr) { munmap(header, map_bytes); }
+    if (fd >= 0) { close(fd); }
+    header = nullptr;
+    fd = -1;
+    map_bytes = 0;
+}
+
+void MonitorPublisher::Publish(const int &step, const double &time, const Eigen::VectorXd &u, const int &n_nodes, const int &n_species)
+{
+    Assert(IsOpen(), "monitor file is not open");
+    Assert(u.size() == static_cast<Eigen::Index>(n_nodes)*n_species, "solution of %d values for %d nodes and %d species",
+           static_cast<int>(u.size()), n_nodes, n_species);
+    const std::size_t bytes = sizeof(MonitorHeader::SlotInfo) + u.size()*sizeof(double);
+    if (bytes > slot_bytes) { Grow(bytes); }
+
+    const std::uint64_t count = header->count.load(std::memory_order_relaxed) + 1;
+    const int i = static_cast<int>((count - 1) % n_slots);
+    std::uint64_t seq = header->seq[i].load(std::memory_order_relaxed);
+    if (seq % 2 == 0) { header->seq[i].store(++seq, std::memory_order_relaxed); }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const MonitorHeader::SlotInfo info{count, step, time, n_nodes, n_species};
+    std::memcpy(Slot(i), &info, sizeof(info));
+    std::memcpy(Slot(i) + sizeof(info), u.data(), u.size()*sizeof(double));
+
+    header->seq[i].store(seq + 1, std::memory_order_release);
+    header->count.store(count, std::memory_order_release);
+}
+
+void MonitorPublisher::Grow(const std::size_t &bytes)
+{
+    // the slots move, so every one of them is marked as being written until it is published again.
+    // the file only grows, so a reader still copying with the old layout stays inside its mapping and
+    // drops the copy on the changed sequence
+    for (int i = 0; i < n_slots; i++)
+    {
+        const std::uint64_t seq = header->seq[i].load(std::memory_order_relaxed);
+        if (seq % 2 == 0) { header->seq[i].store(seq + 1, std::memory_order_relaxed); }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const std::size_t new_slot_bytes = RoundUp(std::max(bytes, 2*slot_bytes));
+    const std::size_t new_map_bytes = sizeof(MonitorHeader) + n_slots*new_slot_bytes;
+    Assert(ftruncate(fd, new_map_bytes) == 0, "could not grow monitor file to %zu bytes", new_map_bytes);
+    munmap(header, map_bytes);
+    void *addr = mmap(nullptr, new_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    Assert(addr != MAP_FAILED, "could not map monitor file of %zu bytes", new_map_bytes);
+    header = static_cast<MonitorHeader*>(addr);
+    map_bytes = new_map_bytes;
+    slot_bytes = new_slot_bytes;
+    header->slot_bytes.store(slot_bytes, std::memory_order_release);
+}
+
+MonitorReader::~MonitorReader()
+{
+    Close();
+}
+
+bool MonitorReader::Open(const std::string &file_name)
+{
+    Close();
+    fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    if (!Remap(sizeof(MonitorHeader)) || header->magic != MonitorHeader::magic_number)
+    {
+        Close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+void MonitorReader::Close()
+{
+    if (header != nullptr) { munmap(header, map_bytes); }
+    if (fd >= 0) { close(fd); }
+    header = nullptr;
+    fd = -1;
+    map_bytes = 0;
+}
+
+std::uint64_t MonitorReader::Count() const
+{
+    return header != nullptr ? header->count.load(std::memory_order_acquire) : 0;
+}
+
+bool MonitorReader::Read(MonitorSnapshot &snapshot, const int &max_retries)
+{
+    for (int attempt = 0; header != nullptr && attempt < max_retries; attempt++)
+    {
+        const std::uint64_t count = header->count.load(std::memory_order_acquire);
+        if (count == 0) { return false; }
+        const int i = static_cast<int>((count - 1) % header->n_slots);
+        const std::uint64_t seq = header->seq[i].load(std::memory_order_acquire);
+        if (seq % 2 == 1) { continue; }
+        const std::size_t slot_bytes = header->slot_bytes.load(std::memory_order_acquire);
+        if (!Remap(sizeof(MonitorHeader) + header->n_slots*slot_bytes)) { return false; }
+
+        // everything copied may be torn until the sequence is checked, so the sizes are only bounded
+        const char *slot = reinterpret_cast<const char*>(header) + sizeof(MonitorHeader) + i*slot_bytes;
+        MonitorHeader::SlotInfo info;
+        std::memcpy(&info, slot, sizeof(info));
+        const std::size_t n_values = static_cast<std::size_t>(info.n_nodes)*static_cast<std::size_t>(info.n_species);
+        if (info.n_nodes < 0 || info.n_species < 0 || sizeof(info) + n_values*sizeof(double) > slot_bytes) { continue; }
+        if (snapshot.u.size() != static_cast<Eigen::Index>(n_values)) { snapshot.u.resize(n_values); }
+        std::memcpy(snapshot.u.data(), slot + sizeof(info), n_values*sizeof(double));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->seq[i].load(std::memory_order_relaxed) != seq) { continue; }
+        snapshot.count = info.count;
+        snapshot.step = static_cast<int>(info.step);
+        snapshot.time = info.time;
+        snapshot.n_nodes = static_cast<int>(info.n_nodes);
+        snapshot.n_species = static_cast<int>(info.n_species);
+        return true;
+    }
+    return false;
+}
+
+bool MonitorReader::Remap(const std::size_t &bytes)
+{
+    if (bytes <= map_bytes) { return true; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < bytes) { return false; }
+    if (header != nullptr) { munmap(header, map_bytes); }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        header = nullptr;
+        map_bytes = 0;
+        return false;
+    }
+    header = static_cast<MonitorHeader*>(addr);
+    map_bytes = st.st_size;
+    return true;
+}
@@ -0,0 +1,140 @@
+#ifndef MONITOR_INCL
+#define MONITOR_INCL
+
+#include <eigen/Eigen/Core>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** @brief one published solution, as read by a MonitorReader */
+struct MonitorSnapshot
+{
+    std::uint64_t count = 0;    /** @brief publication number, 1 for the first solution published */
+    int step = 0;               /** @brief time step index */
+    double time = 0.0;          /** @brief simulated time */
+    int n_nodes = 0;            /** @brief number of nodes */
+    int n_species = 0;          /** @brief number of species */
+    Eigen::VectorXd u;          /** @brief solution, one contiguous block of nodes per species */
+};
+
+/**
+ * @brief layout of the memory mapped file shared by a MonitorPublisher and its readers: this header, then
+ * max_slots slots of slot_bytes each.  a slot holds a SlotInfo followed by the values.  every slot has a
+ * sequence number in the header that is odd while the slot is written (a seqlock): a reader copies a slot
+ * and keeps the copy only if the sequence was even and unchanged around it.  the publisher writes the slot
+ * after the latest one, so it never waits for readers and readers of the latest slot are only disturbed
+ * when they are lapped.
+ */
+struct MonitorHeader
+{
+    static constexpr std::uint64_t magic_number = 0x52544e4f4d4d4546; /** @brief "FEMMONTR" */
+    static constexpr int max_slots = 8;                                 /** @brief largest ring size */
+
+    /** @brief per slot metadata, stored at the start of the slot */
+    struct SlotInfo
+    {
+        std::uint64_t count;    /** @brief publication number */
+        std::int64_t step;      /** @brief time step index */
+        double time;            /** @brief simulated time */
+        std::int64_t n_nodes;   /** @brief number of nodes */
+        std::int64_t n_species; /** @brief number of species */
+    };
+
+    std::uint64_t magic;                            /** @brief magic_number once the header is initialized */
+    std::int64_t n_slots;                           /** @brief slots in the ring */
+    std::atomic<std::uint64_t> slot_bytes;          /** @brief size of a slot, grows with the solution */
+    std::atomic<std::uint64_t> count;               /** @brief solutions published, the latest is in slot (count - 1) % n_slots */
+    std::atomic<std::uint64_t> seq[max_slots];      /** @brief seqlock of each slot, odd while it is written */
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the header atomics are shared between processes");
+};
+
+/**
+ * @brief publishes solutions into a memory mapped ring buffer for monitoring processes on the same machine.
+ * the file is best placed on a memory backed file system (/dev/shm on linux), so nothing reaches the disk.
+ * publishing is a copy into the mapping and never blocks on readers.
+ */
+class MonitorPublisher
+{
+    public:
+        MonitorPublisher() = default;
+        ~MonitorPublisher();
+        MonitorPublisher(const MonitorPublisher&) = delete;
+        MonitorPublisher& operator=(const MonitorPublisher&) = delete;
+
+        /**
+         * @brief create (or truncate) the shared file and map it
+         * @param file_name path of the file
+         * @param n_slots slots in the ring, at least 2 and at most MonitorHeader::max_slots
+         */
+        void Open(const std::string &file_name, const int &n_slots = 4);
+
+        /** @brief unmap and close the file.  the file is left for readers, which see no further publications */
+        void Close();
+
+        /** @brief true if the shared file is open */
+        inline bool IsOpen() const { return header != nullptr; }
+
+        /**
+         * @brief copy a solution into the next slot of the ring and make it the latest.  the slots grow when
+         * the solution does not fit, e.g. after the mesh was refined
+         * @param u solution, n_nodes values per species
+         */
+        void Publish(const int &step, const double &time, const Eigen::VectorXd &u, const int &n_nodes, const int &n_species);
+
+    private:
+        /** @brief enlarge the slots to hold at least bytes and remap the file */
+        void Grow(const std::size_t &bytes);
+
+        /** @brief start of slot i in the mapping */
+        inline char* Slot(const int &i) const { return reinterpret_cast<char*>(header) + sizeof(MonitorHeader) + i*slot_bytes; }
+
+    private:
+        int fd = -1;                        /** @brief descriptor of the shared file */
+        MonitorHeader *header = nullptr;    /** @brief start of the mapping */
+        std::size_t map_bytes = 0;          /** @brief size of the mapping */
+        std::size_t slot_bytes = 0;         /** @brief current size of a slot */
+        int n_slots = 0;                    /** @brief slots in the ring */
+};
+
+/** @brief reads consistent snapshots of the solutions of a MonitorPublisher, from another process or thread */
+class MonitorReader
+{
+    public:
+        MonitorReader() = default;
+        ~MonitorReader();
+        MonitorReader(const MonitorReader&) = delete;
+        MonitorReader& operator=(const MonitorReader&) = delete;
+
+        /**
+         * @brief map the shared file of a publisher
+         * @return false if the file does not exist or is not initialized yet
+         */
+        bool Open(const std::string &file_name);
+
+        void Close();
+
+        /** @brief solutions published so far, 0 before the first one */
+        std::uint64_t Count() const;
+
+        /**
+         * @brief copy the latest solution
+         * @param snapshot filled with the solution, its storage is reused between calls
+         * @param max_retries attempts before giving up while the publisher keeps overwriting the slot
+         * @return false if nothing was published yet or no consistent copy was made
+         */
+        bool Read(MonitorSnapshot &snapshot, const int &max_retries = 1000);
+
+    private:
+        /** @brief map the whole file again if it grew past the mapping */
+        bool Remap(const std::size_t &bytes);
+
+    private:
+        int fd = -1;                        /** @brief descriptor of the shared file */
+        MonitorHeader *header = nullptr;    /** @brief start of the mapping */
+        std::size_t map_bytes = 0;          /** @brief size of the mapping */
+};
+
+#endif // MONITOR_INCL
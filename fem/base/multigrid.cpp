@@ -0,0 +1,407 @@
+#include "multigrid.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace
+{
+    /**
+     * @brief y += A x over the elements of a level, A = alpha M + beta K with linear simplex basis functions.
+     * the element stiffness is vol G G^T and the element mass vol (1 + delta_ab) / ((D + 1)(D + 2)), so an
+     * element needs its volume and gradients only.  constrained nodes are skipped in x and y.
+     * @tparam D spatial dimension
+     */
+    template<int D>
+    void ApplyElements(const std::vector<int> &conn, const std::vector<double> &geom,
+                       const std::vector<std::vector<int>> &colors, const std::vector<char> &fixed,
+                       const double &alpha, const double &beta, const double *x, double *y)
+    {
+        constexpr int npe = D + 1;
+        constexpr int stride = 1 + npe*D;
+        const double c = alpha / ((D + 1)*(D + 2));
+        #pragma omp parallel
+        for (const std::vector<int> &color : colors)
+        {
+            #pragma omp for schedule(static)
+            for (int k = 0; k < static_cast<int>(color.size()); k++)
+            {
+                const int e = color[k];
+                const int *ids = &conn[e*npe];
+                const double vol = geom[e*stride];
+                const double *G = &geom[e*stride + 1];
+                double xl[npe];
+                double grad[D] = {};
+                double sum = 0.0;
+                for (int a = 0; a < npe; a++)
+                {
+                    xl[a] = fixed[ids[a]] ? 0.0 : x[ids[a]];
+                    sum += xl[a];
+                    for (int d = 0; d < D; d++) { grad[d] += G[a*D + d]*xl[a]; }
+                }
+                for (int a = 0; a < npe; a++)
+                {
+                    if (fixed[ids[a]]) { continue; }
+                    double kx = 0.0;
+                    for (int d = 0; d < D; d++) { kx += G[a*D + d]*grad[d]; }
+                    y[ids[a]] += vol*(beta*kx + c*(sum + xl[a]));
+                }
+            }
+        }
+    }
+}
+
+void Multigrid::AddLevel(Mesh &mesh, const MeshChange &change)
+{
+    Level level;
+    level.n_nodes = mesh.NumNodes();
+    dim = mesh.Dim();
+    if (!levels.empty())
+    {
+        Assert(level.n_nodes == levels.back().n_nodes + static_cast<int>(change.new_nodes.size()),
+               "multigrid level of %d nodes is not a refinement of the previous level", level.n_nodes);
+        level.parents = change.new_nodes;
+    }
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() == dim) { CacheGeometry(level, block); }
+    });
+    level.fixed.assign(level.n_nodes, 0);
+    level.x.resize(level.n_nodes);
+    level.b.resize(level.n_nodes);
+    level.r.resize(level.n_nodes);
+    level.d.resize(level.n_nodes);
+    levels.push_back(std::move(level));
+    dirty = true;
+}
+
+void Multigrid::Clear()
+{
+    levels.clear();
+    coarse_m = SparseMatrix();
+    coarse_k = SparseMatrix();
+    coarse_a = SparseMatrix();
+    dirty = true;
+}
+
+template<typename T>
+void Multigrid::CacheGeometry(Level &level, ElementBlock<T> &block)
+{
+    if constexpr (std::is_same<T, LinTri>::value || std::is_same<T, LinTet>::value)
+    {
+        constexpr int D = ElementBlock<T>::Dim();
+        constexpr int npe = ElementBlock<T>::NPE();
+        constexpr int stride = 1 + npe*D;
+        Assert(D == dim, "multigrid needs the elements to span the space, %dD elements in %dD", D, dim);
+        const int n_elems = block.Size();
+        level.npe = npe;
+        level.conn.resize(n_elems*npe);
+        level.geom.resize(n_elems*stride);
+
+        #pragma omp parallel for
+        for (int e = 0; e < n_elems; e++)
+        {
+            T &elem = block.elems[e];
+            Eigen::Matrix<double, D, D> J;
+            for (int k = 0; k < D; k++)
+            {
+                for (int d = 0; d < D; d++) { J(d, k) = elem.Nodes(k + 1).Coords(d) - elem.Nodes(0).Coords(d); }
+            }
+            // the gradients of the basis functions 1..D are the rows of J^{-1}, the first one is minus their sum
+            const Eigen::Matrix<double, D, D> J_inv = J.inverse();
+            double *g = &level.geom[e*stride];
+            g[0] = std::abs(J.determinant()) / ((D == 2) ? 2.0 : 6.0);
+            double *G = g + 1;
+            for (int d = 0; d < D; d++)
+            {
+                G[d] = 0.0;
+                for (int k = 0; k < D; k++)
+                {
+                    G[(k + 1)*D + d] = J_inv(k, d);
+                    G[d] -= J_inv(k, d);
+                }
+            }
+            for (int a = 0; a < npe; a++) { level.conn[e*npe + a] = elem.Nodes(a).node_id; }
+        }
+
+        // diagonals of M and K, and a greedy coloring so elements of a color can be applied in parallel
+        const double c = 1.0 / ((D + 1)*(D + 2));
+        level.diag_m.setZero(level.n_nodes);
+        level.diag_k.setZero(level.n_nodes);
+        std::vector<std::uint64_t> used(level.n_nodes, 0);
+        level.colors.clear();
+        for (int e = 0; e < n_elems; e++)
+        {
+            const int *ids = &level.conn[e*npe];
+            const double *g = &level.geom[e*stride];
+            std::uint64_t taken = 0;
+            for (int a = 0; a < npe; a++)
+            {
+                level.diag_m(ids[a]) += 2.0*c*g[0];
+                double gg = 0.0;
+                for (int d = 0; d < D; d++) { gg += g[1 + a*D + d]*g[1 + a*D + d]; }
+                level.diag_k(ids[a]) += g[0]*gg;
+                taken |= used[ids[a]];
+            }
+            Assert(~taken != 0, "multigrid element coloring needs more than 64 colors");
+            int color = 0;
+            while (taken & (std::uint64_t(1) << color)) { color++; }
+            if (color >= static_cast<int>(level.colors.size())) { level.colors.resize(color + 1); }
+            level.colors[color].push_back(e);
+            for (int a = 0; a < npe; a++) { used[ids[a]] |= std::uint64_t(1) << color; }
+        }
+    }
+    else
+    {
+        FATAL_MSG("multigrid needs a LinTri or LinTet mesh");
+    }
+}
+
+void Multigrid::AssembleCoarse()
+{
+    const Level &level = levels[0];
+    const int npe = level.npe;
+    const int stride = 1 + npe*dim;
+    const double c = 1.0 / ((dim + 1)*(dim + 2));
+    std::vector<Eigen::Triplet<double>> m_triplets, k_triplets;
+    for (int e = 0; e < static_cast<int>(level.conn.size()) / npe; e++)
+    {
+        const int *ids = &level.conn[e*npe];
+        const double vol = level.geom[e*stride];
+        const double *G = &level.geom[e*stride + 1];
+        for (int a = 0; a < npe; a++)
+        {
+            for (int b = 0; b < npe; b++)
+            {
+                double gg = 0.0;
+                for (int d = 0; d < dim; d++) { gg += G[a*dim + d]*G[b*dim + d]; }
+                m_triplets.emplace_back(ids[a], ids[b], vol*c*((a == b) ? 2.0 : 1.0));
+                k_triplets.emplace_back(ids[a], ids[b], vol*gg);
+            }
+        }
+    }
+    coarse_m.resize(level.n_nodes, level.n_nodes);
+    coarse_k.resize(level.n_nodes, level.n_nodes);
+    coarse_m.setFromTriplets(m_triplets.begin(), m_triplets.end());
+    coarse_k.setFromTriplets(k_triplets.begin(), k_triplets.end());
+}
+
+void Multigrid::SetOperator(const double &alpha, const double &beta)
+{
+    if (alpha == this->alpha && beta == this->beta) { return; }
+    this->alpha = alpha;
+    this->beta = beta;
+    dirty = true;
+}
+
+void Multigrid::SetConstraints(const std::vector<int> &dofs)
+{
+    Assert(!levels.empty(), "multigrid constraints set before any level was added");
+    std::vector<char> &fixed = levels.back().fixed;
+    std::fill(fixed.begin(), fixed.end(), 0);
+    for (const int &n : dofs) { fixed[n] = 1; }
+    // coarse nodes keep their index on the finer levels
+    for (int l = NumLevels() - 2; l >= 0; l--)
+    {
+        std::copy(levels[l + 1].fixed.begin(), levels[l + 1].fixed.begin() + levels[l].n_nodes, levels[l].fixed.begin());
+    }
+    dirty = true;
+}
+
+void Multigrid::Setup()
+{
+    if (!dirty) { return; }
+    if (coarse_m.rows() != levels[0].n_nodes) { AssembleCoarse(); }
+    for (int l = 1; l < NumLevels(); l++)
+    {
+        Level &level = levels[l];
+        level.inv_diag = (alpha*level.diag_m + beta*level.diag_k).cwiseInverse();
+        for (int i = 0; i < level.n_nodes; i++)
+        {
+            if (level.fixed[i]) { level.inv_diag(i) = 1.0; }
+        }
+        // largest eigenvalue of D^{-1} A by power iterations, from a rough start so the oscillatory modes are present
+        Eigen::VectorXd v(level.n_nodes), w(level.n_nodes);
+        for (int i = 0; i < level.n_nodes; i++) { v(i) = static_cast<double>((i*2654435761u) >> 16 & 1023) / 1023.0 - 0.5; }
+        v.normalize();
+        for (int it = 0; it < power_iterations; it++)
+        {
+            Multiply(l, v, w);
+            w = w.cwiseProduct(level.inv_diag);
+            level.lambda = w.norm();
+            v = w / level.lambda;
+        }
+    }
+
+    // eliminate the constrained rows and columns of the coarsest operator
+    const std::vector<char> &fixed = levels[0].fixed;
+    coarse_a = alpha*coarse_m + beta*coarse_k;
+    for (int j = 0; j < coarse_a.outerSize(); j++)
+    {
+        for (SparseMatrix::InnerIterator it(coarse_a, j); it; ++it)
+        {
+            if (fixed[it.row()] || fixed[j]) { it.valueRef() = (it.row() == j) ? 1.0 : 0.0; }
+        }
+    }
+    coarse.compute(coarse_a);
+    Assert(coarse.info() == Eigen::Success, "multigrid coarse level factorization failed");
+    dirty = false;
+}
+
+void Multigrid::Multiply(const int &l, const Eigen::VectorXd &x, Eigen::VectorXd &y) const
+{
+    y.resize(levels[l].n_nodes);
+    Multiply(l, x.data(), y.data());
+}
+
+void Multigrid::Multiply(const int &l, const double *x, double *y) const
+{
+    const Level &level = levels[l];
+    std::fill(y, y + level.n_nodes, 0.0);
+    if (dim == 2)
+    {
+        ApplyElements<2>(level.conn, level.geom, level.colors, level.fixed, alpha, beta, x, y);
+    }
+    else
+    {
+        ApplyElements<3>(level.conn, level.geom, level.colors, level.fixed, alpha, beta, x, y);
+    }
+    for (int i = 0; i < level.n_nodes; i++)
+    {
+        if (level.fixed[i]) { y[i] = x[i]; }
+    }
+}
+
+Eigen::VectorXd Multigrid::Diagonal() const
+{
+    const Level &level = levels.back();
+    Eigen::VectorXd diag = alpha*level.diag_m + beta*level.diag_k;
+    for (int i = 0; i < level.n_nodes; i++)
+    {
+        if (level.fixed[i]) { diag(i) = 1.0; }
+    }
+    return diag;
+}
+
+std::size_t Multigrid::MemoryBytes(const MemoryUse &use) const
+{
+    std::size_t bytes = 0;
+    switch (use)
+    {
+        case MemoryUse::Geometry:
+            for (const Level &level : levels)
+            {
+                bytes += Bytes(level.conn) + Bytes(level.geom) + Bytes(level.parents) + Bytes(level.fixed);
+                for (const std::vector<int> &color : level.colors) { bytes += Bytes(color); }
+            }
+            break;
+        case MemoryUse::Matrices:
+            bytes = Bytes(coarse_m) + Bytes(coarse_k) + Bytes(coarse_a);
+            break;
+        case MemoryUse::Factorization:
+            bytes = FactorBytes(coarse);
+            break;
+        case MemoryUse::Krylov:
+            for (const Level &level : levels)
+            {
+                bytes += Bytes(level.diag_m) + Bytes(level.diag_k) + Bytes(level.inv_diag);
+                bytes += Bytes(level.x) + Bytes(level.b) + Bytes(level.r) + Bytes(level.d);
+            }
+            break;
+        default:
+            break;
+    }
+    return bytes;
+}
+
+void Multigrid::Apply(const Eigen::VectorXd &r, Eigen::VectorXd &z) const
+{
+    Assert(!dirty, "multigrid applied before its setup");
+    levels.back().b = r;
+    VCycle(NumLevels() - 1);
+    z = levels.back().x;
+}
+
+void Multigrid::Smooth(const Level &level, const int &l, const bool &zero_guess) const
+{
+    // chebyshev iteration on [hi / smoothing_range, hi], damping the upper part of the spectrum of D^{-1} A
+    const double hi = 1.2*level.lambda;
+    const double lo = hi / smoothing_range;
+    const double theta = 0.5*(hi + lo);
+    const double delta = 0.5*(hi - lo);
+    const double sigma = theta / delta;
+    double rho = 1.0 / sigma;
+
+    if (zero_guess)
+    {
+        level.r = level.b;
+    }
+    else
+    {
+        Multiply(l, level.x, level.r);
+        level.r = level.b - level.r;
+    }
+    level.d = level.inv_diag.cwiseProduct(level.r) / theta;
+    if (zero_guess) { level.x = level.d; } else { level.x += level.d; }
+    for (int k = 1; k < degree; k++)
+    {
+        Multiply(l, level.x, level.r);
+        level.r = level.b - level.r;
+        const double rho_new = 1.0 / (2.0*sigma - rho);
+        level.d = (rho_new*rho)*level.d + (2.0*rho_new / delta)*level.inv_diag.cwiseProduct(level.r);
+        level.x += level.d;
+        rho = rho_new;
+    }
+}
+
+void Multigrid::VCycle(const int &l) const
+{
+    const Level &level = levels[l];
+    if (l == 0)
+    {
+        level.x = coarse.solve(level.b);
+        return;
+    }
+
+    Smooth(level, l, true);
+    Multiply(l, level.x, level.r);
+    level.r = level.b - level.r;
+
+    // restriction, the transpose of the interpolation of the added nodes
+    const Level &next = levels[l - 1];
+    const int n_coarse = next.n_nodes;
+    next.b = level.r.head(n_coarse);
+    double *b = next.b.data();
+    #pragma omp parallel for
+    for (int k = 0; k < static_cast<int>(level.parents.size()); k++)
+    {
+        const double half = 0.5*level.r(n_coarse + k);
+        #pragma omp atomic
+        b[level.parents[k][0]] += half;
+        #pragma omp atomic
+        b[level.parents[k][1]] += half;
+    }
+    for (int i = 0; i < n_coarse; i++)
+    {
+        if (next.fixed[i]) { b[i] = 0.0; }
+    }
+    VCycle(l - 1);
+
+    // interpolation of the coarse correction
+    #pragma omp parallel for
+    for (int i = 0; i < level.n_nodes; i++)
+    {
+        if (level.fixed[i]) { continue; }
+        if (i < n_coarse)
+        {
+            level.x(i) += next.x(i);
+        }
+        else
+        {
+            const std::array<int, 2> &p = level.parents[i - n_coarse];
+            level.x(i) += 0.5*(next.x(p[0]) + next.x(p[1]));
+        }
+    }
+    Smooth(level, l, false);
+}
@@ -0,0 +1,129 @@
+#ifndef MULTIGRID_INCL
+#define MULTIGRID_INCL
+
+#include "mesh.h"
+#include "sparse.h"
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Sparse>
+#include <eigen/Eigen/OrderingMethods>
+#include <eigen/Eigen/SparseCholesky>
+
+#include <array>
+#include <vector>
+
+/**
+ * @brief geometric multigrid on a hierarchy of nested, uniformly refined LinTri or LinTet meshes, for
+ * A = alpha M + beta K with dirichlet rows and columns eliminated.  nothing is assembled above the
+ * coarsest level: each level keeps the volume and basis gradients of its elements and applies A element by
+ * element, in parallel over element colors.  the transfers between levels are matrix-free as well, a node
+ * added by refinement takes the mean of the two ends of the edge it split, and the restriction is the
+ * transpose.  the v-cycle smooths with chebyshev polynomials in D^{-1} A and solves the coarsest level
+ * with a factorization, so the setup is a few operator applications per level.  the coarsest level is only
+ * assembled by the first setup, so a single level serves as a matrix-free operator without assembling it.
+ */
+class Multigrid
+{
+    public:
+        Multigrid() = default;
+
+        /**
+         * @brief add the current mesh as the finest level.  the previous finest level must be the mesh before
+         * the refinement that gave change
+         * @param mesh LinTri mesh in 2D or LinTet mesh in 3D
+         * @param change nodes added by Mesh::RefineUniform, ignored for the first level
+         */
+        void AddLevel(Mesh &mesh, const MeshChange &change);
+
+        /** @brief true if no level was added */
+        inline bool Empty() const { return levels.empty(); }
+
+        inline int NumLevels() const { return static_cast<int>(levels.size()); }
+
+        /** @brief nodes of the finest level, 0 without levels */
+        inline int NumNodes() const { return levels.empty() ? 0 : levels.back().n_nodes; }
+
+        /** @brief remove every level, e.g. when the mesh changed */
+        void Clear();
+
+        /** @brief set the operator to alpha M + beta K */
+        void SetOperator(const double &alpha, const double &beta);
+
+        /** @brief eliminate the rows and columns of constrained nodes of the finest level, also on the coarse levels */
+        void SetConstraints(const std::vector<int> &dofs);
+
+        /** @brief smoother bounds and coarse factorization for the operator and constraints, if they changed */
+        void Setup();
+
+        /**
+         * @brief apply one v-cycle, z ~ A^{-1} r on the finest level.  uses work vectors of the hierarchy,
+         * so it is not reentrant
+         */
+        void Apply(const Eigen::VectorXd &r, Eigen::VectorXd &z) const;
+
+        /** @brief y = A x on level l, level 0 being the coarsest */
+        void Multiply(const int &l, const Eigen::VectorXd &x, Eigen::VectorXd &y) const;
+
+        /** @brief y = A x on level l for vectors of its number of nodes.  on the finest level this is a matrix-free product with the system */
+        void Multiply(const int &l, const double *x, double *y) const;
+
+        /** @brief diagonal of A on the finest level, 1 on constrained nodes.  needs no setup */
+        Eigen::VectorXd Diagonal() const;
+
+        /**
+         * @brief bytes held by the hierarchy.  MemoryUse::Geometry counts the element geometry and coloring of the
+         * levels, MemoryUse::Matrices the assembled coarsest level, MemoryUse::Factorization its factorization and
+         * MemoryUse::Krylov the smoother diagonals and v-cycle vectors
+         */
+        std::size_t MemoryBytes(const MemoryUse &use) const;
+
+    private:
+        /** @brief one mesh of the hierarchy */
+        struct Level
+        {
+            int n_nodes = 0;                            /** @brief number of nodes */
+            int npe = 0;                                /** @brief nodes per element */
+            std::vector<int> conn;                      /** @brief element nodes, npe per element */
+            std::vector<double> geom;                   /** @brief per element the volume, then the npe x dim basis gradients */
+            std::vector<std::vector<int>> colors;       /** @brief elements by color, elements of a color share no node */
+            std::vector<std::array<int, 2>> parents;    /** @brief ends of the coarse edge split by each node added to the previous level */
+            std::vector<char> fixed;                    /** @brief constrained nodes */
+            Eigen::VectorXd diag_m;                     /** @brief diagonal of M */
+            Eigen::VectorXd diag_k;                     /** @brief diagonal of K */
+            Eigen::VectorXd inv_diag;                   /** @brief inverse diagonal of A, 1 on constrained nodes */
+            double lambda = 1.0;                        /** @brief estimate of the largest eigenvalue of D^{-1} A */
+            mutable Eigen::VectorXd x;                  /** @brief v-cycle correction */
+            mutable Eigen::VectorXd b;                  /** @brief v-cycle right hand side */
+            mutable Eigen::VectorXd r;                  /** @brief v-cycle residual */
+            mutable Eigen::VectorXd d;                  /** @brief chebyshev update */
+        };
+
+        /** @brief cache the geometry of the domain elements of a block and color them */
+        template<typename T>
+        void CacheGeometry(Level &level, ElementBlock<T> &block);
+
+        /** @brief assembled M and K of the coarsest level */
+        void AssembleCoarse();
+
+        /** @brief chebyshev smoothing of A x = b on a level, from x or from zero */
+        void Smooth(const Level &level, const int &l, const bool &zero_guess) const;
+
+        /** @brief v-cycle from level l with the right hand side in levels[l].b and the result in levels[l].x */
+        void VCycle(const int &l) const;
+
+    private:
+        int dim = 0;                    /** @brief spatial dimension */
+        double alpha = 1.0;             /** @brief mass coefficient */
+        double beta = 1.0;              /** @brief stiffness coefficient */
+        int degree = 3;                 /** @brief degree of the chebyshev smoother */
+        int power_iterations = 20;      /** @brief power iterations estimating the largest eigenvalue of D^{-1} A */
+        double smoothing_range = 20.0;  /** @brief ratio of the largest to the smallest eigenvalue targeted by the smoother */
+        bool dirty = true;              /** @brief operator or constraints changed since the last setup */
+        std::vector<Level> levels;      /** @brief hierarchy, coarsest first */
+        SparseMatrix coarse_m;          /** @brief mass matrix of the coarsest level */
+        SparseMatrix coarse_k;          /** @brief stiffness matrix of the coarsest level */
+        SparseMatrix coarse_a;          /** @brief operator of the coarsest level with the constraints eliminated */
+        Eigen::SimplicialLDLT<SparseMatrix> coarse; /** @brief direct solver of the coarsest level */
+};
+
+#endif // MULTIGRID_INCL
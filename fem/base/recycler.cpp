@@ -0,0 +1,110 @@
+#include "recycler.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+
+Recycler::Recycler(const int &max_vectors, const int &order)
+: max_vectors{max_vectors}, order{order}, stale{true}, prepared_id{-1}, drop_tol{1e-8}
+{
+
+}
+
+void Recycler::SetMaxVectors(const int &max_vectors)
+{
+    this->max_vectors = max_vectors;
+    while (Size() > max_vectors) { solutions.pop_front(); }
+    stale = true;
+}
+
+void Recycler::Clear()
+{
+    solutions.clear();
+    W.resize(0, 0);
+    AW.resize(0, 0);
+    stale = true;
+}
+
+std::size_t Recycler::MemoryBytes() const
+{
+    std::size_t bytes = Bytes(W) + Bytes(AW) + W.cols()*W.cols()*sizeof(double);
+    for (const Eigen::VectorXd &x : solutions) { bytes += Bytes(x); }
+    return bytes;
+}
+
+void Recycler::Add(const Eigen::VectorXd &x)
+{
+    if (max_vectors <= 0) { return; }
+    if (!solutions.empty() && solutions.back().size() != x.size()) { Clear(); }
+    if (Size() == max_vectors) { solutions.pop_front(); }
+    solutions.push_back(x);
+    stale = true;
+}
+
+void Recycler::Extrapolate(Eigen::VectorXd &x) const
+{
+    if (solutions.empty()) { return; }
+    // x_{n+1} = sum_j (-1)^j binomial(p + 1, j + 1) x_{n-j}, exact for polynomials of degree p in time
+    const int p = std::min(order, Size() - 1);
+    x.setZero(solutions.back().size());
+    double binomial = 1.0;
+    for (int j = 0; j <= p; j++)
+    {
+        binomial *= static_cast<double>(p + 1 - j) / (j + 1);
+        x += ((j % 2 == 0) ? binomial : -binomial)*solutions[Size() - 1 - j];
+    }
+}
+
+bool Recycler::Orthonormalize(const int &rows, const int &matrix_id)
+{
+    if (!solutions.empty() && solutions.back().size() != rows) { Clear(); }
+    if (!stale && matrix_id == prepared_id) { return false; }
+    if (stale)
+    {
+        // modified gram-schmidt from the newest solution, twice for orthogonality to rounding
+        W.resize(rows, Size());
+        int rank = 0;
+        for (int k = Size() - 1; k >= 0; k--)
+        {
+            Eigen::VectorXd w = solutions[k];
+            const double norm = w.norm();
+            if (norm == 0.0) { continue; }
+            for (int pass = 0; pass < 2; pass++)
+            {
+                for (int j = 0; j < rank; j++) { w -= W.col(j).dot(w)*W.col(j); }
+            }
+            const double w_norm = w.norm();
+            if (w_norm < drop_tol*norm) { continue; }
+            W.col(rank++) = w / w_norm;
+        }
+        W.conservativeResize(Eigen::NoChange, rank);
+        stale = false;
+    }
+    prepared_id = matrix_id;
+    return W.cols() > 0;
+}
+
+void Recycler::FactorizeProjection()
+{
+    const Eigen::MatrixXd WAW = W.transpose()*AW;
+    E.compute(0.5*(WAW + WAW.transpose()));
+    if (E.info() != Eigen::Success)
+    {
+        WARN("recycled space is not positive definite for the system matrix, not used");
+        W.resize(W.rows(), 0);
+        AW.resize(W.rows(), 0);
+    }
+}
+
+void Recycler::Project(Eigen::VectorXd &x, Eigen::VectorXd &r) const
+{
+    if (W.cols() == 0) { return; }
+    const Eigen::VectorXd c = E.solve(W.transpose()*r);
+    x += W*c;
+    r -= AW*c;
+}
+
+void Recycler::Deflate(const Eigen::VectorXd &z, Eigen::VectorXd &p) const
+{
+    if (W.cols() == 0) { return; }
+    p -= W*E.solve(AW.transpose()*z);
+}
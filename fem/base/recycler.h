@@ -0,0 +1,96 @@
+#ifndef RECYCLER_INCL
+#define RECYCLER_INCL
+
+#include "sparse.h"
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Cholesky>
+
+#include <deque>
+
+/**
+ * @brief solutions of previous systems in a sequence of slowly varying ones, A_n x_n = b_n, recycled by the
+ * conjugate gradient solver.  the last solutions span a deflation space W.  the initial guess is the
+ * extrapolation in time of the last solutions corrected by the galerkin projection of the new system onto W,
+ * which minimizes the A-norm of the error over W, and the search directions are kept A-orthogonal to W so cg
+ * only resolves the part of the solution the previous steps did not predict.
+ */
+class Recycler
+{
+    public:
+        /**
+         * @param max_vectors number of previous solutions kept, 0 disables recycling
+         * @param order degree of the extrapolation in time of the initial guess
+         */
+        Recycler(const int &max_vectors = 0, const int &order = 2);
+
+        /** @brief change the number of previous solutions kept, dropping the oldest ones */
+        void SetMaxVectors(const int &max_vectors);
+
+        inline int MaxVectors() const { return max_vectors; }
+
+        /** @brief number of stored solutions */
+        inline int Size() const { return static_cast<int>(solutions.size()); }
+
+        /** @brief dimension of the deflation space, the stored solutions without the linearly dependent ones */
+        inline int Rank() const { return static_cast<int>(W.cols()); }
+
+        /** @brief bytes held by the stored solutions, the basis and its products */
+        std::size_t MemoryBytes() const;
+
+        /** @brief forget the previous solutions, e.g. when the number of unknowns changed */
+        void Clear();
+
+        /** @brief store the solution of a solve, the oldest one is dropped if the space is full */
+        void Add(const Eigen::VectorXd &x);
+
+        /**
+         * @brief extrapolate the stored solutions to the next one, as the polynomial in equal steps through
+         * the last order + 1 solutions.  x is left unchanged without stored solutions
+         */
+        void Extrapolate(Eigen::VectorXd &x) const;
+
+        /**
+         * @brief orthonormal basis of the stored solutions, its product with A and the factorization of
+         * E = W^T A W.  only redone if the solutions or the matrix changed since the last call
+         * @param A system matrix, a SellMatrix or SymmetricMatrix
+         * @param matrix_id identifier of the values of A, changes whenever they do
+         */
+        template<typename Matrix>
+        void Prepare(const Matrix &A, const int &matrix_id)
+        {
+            if (!Orthonormalize(A.rows(), matrix_id)) { return; }
+            AW.resize(W.rows(), W.cols());
+            A.Multiply(W.data(), AW.data(), static_cast<int>(W.cols()));
+            FactorizeProjection();
+        }
+
+        /** @brief galerkin correction of x on W for the residual r = b - A x, and the matching update of r */
+        void Project(Eigen::VectorXd &x, Eigen::VectorXd &r) const;
+
+        /** @brief remove the A-conjugate components along W from a search direction, p -= W E^{-1} (AW)^T z */
+        void Deflate(const Eigen::VectorXd &z, Eigen::VectorXd &p) const;
+
+    private:
+        /**
+         * @brief rebuild W if the solutions changed since the last call
+         * @return true if A W must be recomputed, i.e. W or the matrix changed and W is not empty
+         */
+        bool Orthonormalize(const int &rows, const int &matrix_id);
+
+        /** @brief factorize E = W^T A W once A W is up to date */
+        void FactorizeProjection();
+
+    private:
+        int max_vectors;                        /** @brief number of previous solutions kept */
+        int order;                              /** @brief degree of the extrapolation */
+        std::deque<Eigen::VectorXd> solutions;  /** @brief previous solutions, the newest last */
+        Eigen::MatrixXd W;                      /** @brief orthonormal basis of the solutions */
+        Eigen::MatrixXd AW;                     /** @brief A W */
+        Eigen::LLT<Eigen::MatrixXd> E;          /** @brief factorization of W^T A W */
+        bool stale;                             /** @brief solutions changed since the basis was built */
+        int prepared_id;                        /** @brief matrix the products with W were computed for */
+        double drop_tol;                        /** @brief relative norm under which an orthogonalized solution is dropped */
+};
+
+#endif // RECYCLER_INCL
@@ -0,0 +1,430 @@
+#include "refiner.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <type_traits>
+
+template<typename F>
+void Refiner::ForEachBlock(Mesh &mesh, F &&f)
+{
+    auto visit = [&](auto &block, auto &hist)
+    {
+        if (block.Size() == 0) { return; }
+        if (block.Dim() != mesh.Dim() && block.Dim() != mesh.Dim() - 1) { return; }
+        f(block, hist);
+    };
+    visit(mesh.Block<LinLine>(), std::get<History<LinLine>>(history));
+    visit(mesh.Block<LinTri>(), std::get<History<LinTri>>(history));
+    visit(mesh.Block<LinTet>(), std::get<History<LinTet>>(history));
+}
+
+void Refiner::Init(Mesh &mesh)
+{
+    ForEachBlock(mesh, [&](auto &block, auto &hist)
+    {
+        hist.bisections.clear();
+        hist.parent.assign(block.Size(), -1);
+        hist.gen.assign(block.Size(), 0);
+        hist.flag.assign(block.Size(), 0);
+        if (!NewestVertex(mesh, block)) { return; }
+
+        // the initial refinement edge of a triangle is its longest edge.  rotating the nodes keeps the orientation
+        for (int e = 0; e < block.Size(); e++)
+        {
+            const std::array<int, 2> edge = LongestEdge(mesh, block, e);
+            std::array<int, 4> ids = {-1, -1, -1, -1};
+            std::array<int, 4> rotated = {-1, -1, -1, -1};
+            for (int i = 0; i < 3; i++) { ids[i] = block.elems[e].Nodes(i).node_id; }
+            // edges (0, 1), (1, 2) and (0, 2) = (2, 0) become (0, 1) after rotating by 0, 1 and 2 nodes
+            const int shift = (edge[0] == 1) ? 1 : ((edge[1] == 2) ? 2 : 0);
+            for (int i = 0; i < 3; i++) { rotated[i] = ids[(i + shift) % 3]; }
+            SetNodes(mesh, block.elems[e], rotated);
+        }
+    });
+}
+
+bool Refiner::Supported(Mesh &mesh) const
+{
+    if (!(mesh.Dim() == 2 && mesh.ElemType() == ElementType::LinTri) && !(mesh.Dim() == 3 && mesh.ElemType() == ElementType::LinTet))
+    {
+        return false;
+    }
+    // every element on the domain and its boundary has to be a simplex
+    bool simplex = true;
+    mesh.ForEachBlock([&](auto &block)
+    {
+        typedef typename std::decay_t<decltype(block)>::ElemType T;
+        const bool is_simplex = std::is_same<T, LinLine>::value || std::is_same<T, LinTri>::value || std::is_same<T, LinTet>::value;
+        if ((block.Dim() == mesh.Dim() || block.Dim() == mesh.Dim() - 1) && !is_simplex) { simplex = false; }
+    });
+    return simplex;
+}
+
+const std::vector<int>& Refiner::Generation(Mesh &mesh) const
+{
+    if (mesh.ElemType() == ElementType::LinTet) { return std::get<History<LinTet>>(history).gen; }
+    return std::get<History<LinTri>>(history).gen;
+}
+
+MeshChange Refiner::Refine(Mesh &mesh, const std::vector<char> &marked)
+{
+    MeshChange change;
+    const int n_old = mesh.NumNodes();
+    change.node_map.resize(n_old);
+    for (int n = 0; n < n_old; n++) { change.node_map[n] = n; }
+    midpoints.clear();
+    split_end.assign(n_old, 0);
+
+    ForEachBlock(mesh, [&](auto &block, auto &hist)
+    {
+        if (block.Dim() == mesh.Dim())
+        {
+            Assert(static_cast<int>(marked.size()) == block.Size(), "%d refinement marks for %d elements", static_cast<int>(marked.size()), block.Size());
+            hist.flag = marked;
+        }
+        else
+        {
+            hist.flag.assign(block.Size(), 0);
+        }
+    });
+
+    int n_flagged = 0;
+    int n_bisected = 0;
+    do
+    {
+        // bisect flagged elements.  children are appended, so they are only visited in the next pass
+        ForEachBlock(mesh, [&](auto &block, auto &hist)
+        {
+            const int n_elems = block.Size();
+            for (int e = 0; e < n_elems; e++)
+            {
+                if (!hist.flag[e]) { continue; }
+                hist.flag[e] = 0;
+                Bisect(mesh, block, hist, e, change);
+                n_bisected++;
+            }
+            hist.flag.resize(block.Size(), 0);
+        });
+
+        // conforming closure: an element with a split edge has a hanging node and is bisected as well
+        n_flagged = 0;
+        ForEachBlock(mesh, [&](auto &block, auto &hist)
+        {
+            constexpr int npe = std::decay_t<decltype(block)>::NPE();
+            #pragma omp parallel for reduction(+:n_flagged)
+            for (int e = 0; e < block.Size(); e++)
+            {
+                auto &elem = block.elems[e];
+                bool hanging = false;
+                for (int i = 0; i < npe && !hanging; i++)
+                {
+                    const int a = elem.Nodes(i).node_id;
+                    if (!split_end[a]) { continue; }
+                    for (int j = i + 1; j < npe && !hanging; j++)
+                    {
+                        const int b = elem.Nodes(j).node_id;
+                        hanging = split_end[b] && midpoints.count(EdgeKey(a, b)) > 0;
+                    }
+                }
+                if (hanging)
+                {
+                    hist.flag[e] = 1;
+                    n_flagged++;
+                }
+            }
+        });
+    } while (n_flagged > 0);
+
+    change.affected.resize(mesh.NumNodes(), 0);
+    UpdateSize(mesh);
+    INFO("refinement bisected %d elements and added %d nodes", n_bisected, static_cast<int>(change.new_nodes.size()));
+    return change;
+}
+
+MeshChange Refiner::Coarsen(Mesh &mesh, const std::vector<char> &marked)
+{
+    MeshChange change;
+    const int n_old = mesh.NumNodes();
+
+    // a node can be removed if every element around it, on the domain and on the boundary, is the
+    // child of an undoable bisection that added it: both children are still leaves and, on the domain,
+    // both are marked.  count the elements around each node and the undoable bisections at it
+    std::vector<int> domain_valence(n_old, 0), domain_undoable(n_old, 0);
+    std::vector<int> boundary_valence(n_old, 0), boundary_undoable(n_old, 0);
+    ForEachBlock(mesh, [&](auto &block, auto &hist)
+    {
+        const bool domain = block.Dim() == mesh.Dim();
+        if (domain)
+        {
+            Assert(static_cast<int>(marked.size()) == block.Size(), "%d coarsening marks for %d elements", static_cast<int>(marked.size()), block.Size());
+        }
+        std::vector<int> &valence = domain ? domain_valence : boundary_valence;
+        std::vector<int> &undoable = domain ? domain_undoable : boundary_undoable;
+        for (auto &elem : block.elems)
+        {
+            for (int i = 0; i < block.NPE(); i++) { valence[elem.Nodes(i).node_id]++; }
+        }
+        for (int b = 0; b < static_cast<int>(hist.bisections.size()); b++)
+        {
+            const Bisection &bis = hist.bisections[b];
+            if (!bis.active || hist.parent[bis.child[0]] != b || hist.parent[bis.child[1]] != b) { continue; }
+            if (domain && !(marked[bis.child[0]] && marked[bis.child[1]])) { continue; }
+            undoable[bis.midpoint]++;
+        }
+    });
+    std::vector<char> removed(n_old, 0);
+    int n_removed = 0;
+    for (int n = 0; n < n_old; n++)
+    {
+        removed[n] = domain_valence[n] > 0 && 2*domain_undoable[n] == domain_valence[n] && 2*boundary_undoable[n] == boundary_valence[n];
+        n_removed += removed[n];
+    }
+    if (n_removed == 0)
+    {
+        change.node_map.resize(n_old);
+        for (int n = 0; n < n_old; n++) { change.node_map[n] = n; }
+        change.affected.assign(n_old, 0);
+        return change;
+    }
+
+    // restore the parents.  nodes touched are in the old numbering until the nodes are renumbered below
+    std::vector<char> touched(n_old, 0);
+    int n_undone = 0;
+    ForEachBlock(mesh, [&](auto &block, auto &hist)
+    {
+        for (int b = 0; b < static_cast<int>(hist.bisections.size()); b++)
+        {
+            const Bisection &bis = hist.bisections[b];
+            if (!bis.active || !removed[bis.midpoint]) { continue; }
+            if (hist.parent[bis.child[0]] != b || hist.parent[bis.child[1]] != b) { continue; }
+            Undo(mesh, block, hist, b, touched);
+            n_undone++;
+        }
+    });
+
+    // fill the slots of removed nodes with the last remaining nodes, so only those are renumbered
+    const int n_new = n_old - n_removed;
+    change.node_map.resize(n_old);
+    for (int n = 0; n < n_old; n++) { change.node_map[n] = removed[n] ? -1 : n; }
+    int tail = n_old - 1;
+    for (int n = 0; n < n_new; n++)
+    {
+        if (!removed[n]) { continue; }
+        while (removed[tail]) { tail--; }
+        change.node_map[tail] = n;
+        tail--;
+    }
+    for (int n = 0; n < n_old; n++)
+    {
+        if (removed[n]) { delete mesh.nodes[n]; mesh.nodes[n] = nullptr; }
+    }
+    for (int n = n_new; n < n_old; n++)
+    {
+        const int to = change.node_map[n];
+        if (to < 0) { continue; }
+        mesh.nodes[to] = mesh.nodes[n];
+        mesh.nodes[to]->node_id = to;
+    }
+    mesh.nodes.resize(n_new);
+    mesh.n_nodes = n_new;
+
+    change.affected.assign(n_new, 0);
+    for (int n = 0; n < n_old; n++)
+    {
+        if (touched[n] && change.node_map[n] >= 0) { change.affected[change.node_map[n]] = 1; }
+    }
+    for (auto &v : mesh.vtx) { v = change.node_map[v]; }
+
+    // renumber the element nodes.  an element with a moved node changes the columns of all its nodes
+    ForEachBlock(mesh, [&](auto &block, auto &hist)
+    {
+        for (auto &elem : block.elems)
+        {
+            bool moved = false;
+            for (int i = 0; i < block.NPE(); i++)
+            {
+                const int n = elem.Nodes(i).node_id;
+                Assert(change.node_map[n] >= 0, "removed node %d is still used by an element", n);
+                moved = moved || change.node_map[n] != n;
+                elem.Nodes(i).node_id = change.node_map[n];
+            }
+            if (!moved) { continue; }
+            for (int i = 0; i < block.NPE(); i++) { change.affected[elem.Nodes(i).node_id] = 1; }
+        }
+        for (auto &bis : hist.bisections)
+        {
+            if (!bis.active) { continue; }
+            for (int i = 0; i < block.NPE(); i++) { bis.nodes[i] = change.node_map[bis.nodes[i]]; }
+            bis.midpoint = change.node_map[bis.midpoint];
+        }
+    });
+
+    UpdateSize(mesh);
+    INFO("coarsening undid %d bisections and removed %d nodes", n_undone, n_removed);
+    return change;
+}
+
+template<typename T>
+bool Refiner::NewestVertex(Mesh &mesh, ElementBlock<T> &block) const
+{
+    return std::is_same<T, LinTri>::value && block.Dim() == mesh.Dim();
+}
+
+template<typename T>
+std::array<int, 2> Refiner::RefinementEdge(Mesh &mesh, ElementBlock<T> &block, const int &e) const
+{
+    if (ElementBlock<T>::NPE() == 2 || NewestVertex(mesh, block)) { return {0, 1}; }
+    return LongestEdge(mesh, block, e);
+}
+
+template<typename T>
+std::array<int, 2> Refiner::LongestEdge(Mesh &mesh, ElementBlock<T> &block, const int &e) const
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    auto &elem = block.elems[e];
+    std::array<int, 2> longest = {0, 1};
+    double max_len = -1.0;
+    std::uint64_t max_key = 0;
+    for (int i = 0; i < npe; i++)
+    {
+        for (int j = i + 1; j < npe; j++)
+        {
+            // lengths come from the global node list, so elements sharing an edge see the same value
+            const int a = elem.Nodes(i).node_id;
+            const int b = elem.Nodes(j).node_id;
+            double len = 0.0;
+            for (int d = 0; d < mesh.Dim(); d++)
+            {
+                const double dx = mesh.nodes[a]->Coords(d) - mesh.nodes[b]->Coords(d);
+                len += dx*dx;
+            }
+            const std::uint64_t key = EdgeKey(a, b);
+            if (len > max_len || (len == max_len && key < max_key))
+            {
+                longest = {i, j};
+                max_len = len;
+                max_key = key;
+            }
+        }
+    }
+    return longest;
+}
+
+void Refiner::UpdateSize(Mesh &mesh)
+{
+    mesh.ForEachBlock([&](auto &block)
+    {
+        if (block.Dim() == mesh.Dim()) { mesh.n_elems = block.Size(); }
+    });
+    mesh.InvalidateTopology();
+}
+
+template<typename T>
+void Refiner::SetNodes(Mesh &mesh, T &elem, const std::array<int, 4> &ids)
+{
+    for (int i = 0; i < ElementBlock<T>::NPE(); i++)
+    {
+        auto &node = elem.Nodes(i);
+        node.node_id = ids[i];
+        node.ebc_flag = false;
+        for (int j = 0; j < 3; j++) { node.Coords(j) = (j < mesh.Dim()) ? mesh.nodes[ids[i]]->Coords(j) : 0.0; }
+    }
+}
+
+int Refiner::Midpoint(Mesh &mesh, const int &a, const int &b, MeshChange &change)
+{
+    const std::uint64_t key = EdgeKey(a, b);
+    auto it = midpoints.find(key);
+    if (it != midpoints.end()) { return it->second; }
+
+    Node *node = mesh.CreateNode();
+    node->node_id = static_cast<int>(mesh.nodes.size());
+    for (int j = 0; j < mesh.Dim(); j++) { node->Coords(j) = 0.5*(mesh.nodes[a]->Coords(j) + mesh.nodes[b]->Coords(j)); }
+    mesh.nodes.push_back(node);
+    mesh.n_nodes = static_cast<int>(mesh.nodes.size());
+
+    change.new_nodes.push_back({a, b});
+    midpoints[key] = node->node_id;
+    split_end.resize(mesh.nodes.size(), 0);
+    split_end[a] = 1;
+    split_end[b] = 1;
+    return node->node_id;
+}
+
+template<typename T>
+void Refiner::Bisect(Mesh &mesh, ElementBlock<T> &block, History<T> &hist, const int &e, MeshChange &change)
+{
+    constexpr int npe = ElementBlock<T>::NPE();
+    std::array<int, 4> v = {-1, -1, -1, -1};
+    for (int i = 0; i < npe; i++) { v[i] = block.elems[e].Nodes(i).node_id; }
+    const std::array<int, 2> edge = RefinementEdge(mesh, block, e);
+    const int m = Midpoint(mesh, v[edge[0]], v[edge[1]], change);
+
+    // each child keeps one end point of the refinement edge and gets the midpoint in place of the other
+    std::array<int, 4> c0 = v;
+    std::array<int, 4> c1 = v;
+    c0[edge[1]] = m;
+    c1[edge[0]] = m;
+    if (NewestVertex(mesh, block))
+    {
+        // the edges of the children opposite the midpoint become their refinement edges
+        c0 = {v[2], v[0], m, -1};
+        c1 = {v[1], v[2], m, -1};
+    }
+
+    const int b = static_cast<int>(hist.bisections.size());
+    hist.bisections.push_back(Bisection{v, {e, -1}, m, hist.parent[e], true});
+
+    T child = block.elems[e];
+    SetNodes(mesh, block.elems[e], c0);
+    block.cached[e] = 0;
+    SetNodes(mesh, child, c1);
+    const int e1 = block.Append(child, block.geom_idx[e]);
+    block.elems[e1].elem_id = e1;
+    hist.bisections[b].child[1] = e1;
+    hist.parent[e] = b;
+    hist.parent.push_back(b);
+    hist.gen[e]++;
+    hist.gen.push_back(hist.gen[e]);
+
+    for (int i = 0; i < npe; i++) { Touch(change.affected, v[i]); }
+    Touch(change.affected, m);
+}
+
+template<typename T>
+void Refiner::Undo(Mesh &mesh, ElementBlock<T> &block, History<T> &hist, const int &b, std::vector<char> &touched)
+{
+    Bisection &bis = hist.bisections[b];
+    const int e0 = bis.child[0];
+    const int e1 = bis.child[1];
+    SetNodes(mesh, block.elems[e0], bis.nodes);
+    block.cached[e0] = 0;
+    hist.parent[e0] = bis.parent;
+    hist.gen[e0]--;
+    bis.active = false;
+    for (int i = 0; i < block.NPE(); i++) { touched[bis.nodes[i]] = 1; }
+    RemoveElement(block, hist, e1);
+}
+
+template<typename T>
+void Refiner::RemoveElement(ElementBlock<T> &block, History<T> &hist, const int &e)
+{
+    const int moved = block.Remove(e);
+    if (moved >= 0)
+    {
+        // the element moved into slot e is known by its old index to the bisection that created it.  a
+        // first child sits in the slot of its parent, so the bisections of its ancestors know it as well
+        block.elems[e].elem_id = e;
+        hist.parent[e] = hist.parent[moved];
+        hist.gen[e] = hist.gen[moved];
+        for (int b = hist.parent[e]; b >= 0; b = hist.bisections[b].parent)
+        {
+            std::array<int, 2> &child = hist.bisections[b].child;
+            if (child[1] == moved) { child[1] = e; }
+            if (child[0] != moved) { break; }
+            child[0] = e;
+        }
+    }
+    hist.parent.pop_back();
+    hist.gen.pop_back();
+}
@@ -0,0 +1,136 @@
+#ifndef REFINER_INCL
+#define REFINER_INCL
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief adaptive h-refinement of simplex meshes by bisection.  triangles of a 2D mesh are split by
+ * newest vertex bisection: the refinement edge is stored as local edge (0, 1) and the newest vertex as
+ * local node 2.  tetrahedra, and the triangle facets bounding a 3D mesh, are split on their longest edge,
+ * with ties broken by node index, so a facet is always split the same way as the tetrahedra on it.
+ * elements with a hanging node are bisected until the mesh is conforming again.  every bisection is
+ * recorded, so coarsening removes a node added by refinement by restoring the parents of all the
+ * elements around it.  the mesh blocks are updated in place: a parent is replaced by its first child
+ * and the second child is appended, so untouched elements keep their index and their cached matrices.
+ */
+class Refiner
+{
+    public:
+        Refiner() = default;
+
+        /**
+         * @brief start the bisection history of the initial mesh and label the refinement edge of every
+         * triangle of a 2D mesh with its longest edge.  call before the assembler is initialized.
+         * @param mesh mesh with its element blocks read in
+         */
+        void Init(Mesh &mesh);
+
+        /** @brief true if the mesh can be refined, i.e. it is made of LinTri in 2D or LinTet in 3D */
+        bool Supported(Mesh &mesh) const;
+
+        /**
+         * @brief bisect the marked domain elements, and the elements needed to keep the mesh conforming
+         * @param mesh mesh passed to Init
+         * @param marked flag per domain element
+         * @return added nodes and changed pattern columns
+         */
+        MeshChange Refine(Mesh &mesh, const std::vector<char> &marked);
+
+        /**
+         * @brief undo bisections whose children are all marked.  a node added by refinement is removed
+         * when every domain element around it is marked and is a child of a bisection that added it
+         * @param mesh mesh passed to Init
+         * @param marked flag per domain element
+         * @return node renumbering and changed pattern columns
+         */
+        MeshChange Coarsen(Mesh &mesh, const std::vector<char> &marked);
+
+        /** @brief number of bisections between each domain element and the initial mesh */
+        const std::vector<int>& Generation(Mesh &mesh) const;
+
+    private:
+        /** @brief one bisection of an element into two children */
+        struct Bisection
+        {
+            std::array<int, 4> nodes;   /** @brief nodes of the parent */
+            std::array<int, 2> child;   /** @brief block index of the children */
+            int midpoint;               /** @brief node added on the refinement edge */
+            int parent;                 /** @brief bisection that created the parent, -1 for initial elements */
+            bool active;                /** @brief false once undone by coarsening */
+        };
+
+        /** @brief bisection history of one element block */
+        template<typename T>
+        struct History
+        {
+            std::vector<Bisection> bisections;  /** @brief every bisection done on the block */
+            std::vector<int> parent;            /** @brief per element, bisection that created it, -1 for initial elements */
+            std::vector<int> gen;               /** @brief per element, number of bisections from the initial mesh */
+            std::vector<char> flag;             /** @brief per element, scratch marker */
+        };
+
+        /** @brief call f(block, history) on every non-empty simplex block of the domain and its boundary */
+        template<typename F>
+        void ForEachBlock(Mesh &mesh, F &&f);
+
+        /** @brief local end points of the edge an element is bisected on */
+        template<typename T>
+        std::array<int, 2> RefinementEdge(Mesh &mesh, ElementBlock<T> &block, const int &e) const;
+
+        /** @brief local end points of the longest edge of an element, ties broken by node index */
+        template<typename T>
+        std::array<int, 2> LongestEdge(Mesh &mesh, ElementBlock<T> &block, const int &e) const;
+
+        /** @brief true if the block is refined by newest vertex bisection */
+        template<typename T>
+        bool NewestVertex(Mesh &mesh, ElementBlock<T> &block) const;
+
+        /** @brief bisect element e of the block on its refinement edge */
+        template<typename T>
+        void Bisect(Mesh &mesh, ElementBlock<T> &block, History<T> &hist, const int &e, MeshChange &change);
+
+        /** @brief restore the parent of a bisection into its first child and remove the second */
+        template<typename T>
+        void Undo(Mesh &mesh, ElementBlock<T> &block, History<T> &hist, const int &b, std::vector<char> &touched);
+
+        /** @brief remove element e, moving the last element of the block into its slot */
+        template<typename T>
+        void RemoveElement(ElementBlock<T> &block, History<T> &hist, const int &e);
+
+        /** @brief set the node indices and coordinates of an element from the global node list */
+        template<typename T>
+        void SetNodes(Mesh &mesh, T &elem, const std::array<int, 4> &ids);
+
+        /** @brief update the number of domain elements of the mesh and drop its cached topology */
+        void UpdateSize(Mesh &mesh);
+
+        /** @brief node at the midpoint of edge (a, b), added if it does not exist yet */
+        int Midpoint(Mesh &mesh, const int &a, const int &b, MeshChange &change);
+
+        /** @brief key of the edge (a, b) in the midpoint table */
+        static inline std::uint64_t EdgeKey(const int &a, const int &b)
+        {
+            return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | static_cast<std::uint64_t>(std::max(a, b));
+        }
+
+        /** @brief mark a node's pattern column as changed */
+        static inline void Touch(std::vector<char> &affected, const int &node)
+        {
+            if (node >= static_cast<int>(affected.size())) { affected.resize(node + 1, 0); }
+            affected[node] = 1;
+        }
+
+    private:
+        std::tuple<History<LinLine>, History<LinTri>, History<LinTet>> history; /** @brief bisections per block */
+        std::unordered_map<std::uint64_t, int> midpoints;   /** @brief edges split during the current refinement */
+        std::vector<char> split_end;                        /** @brief nodes that are an end point of a split edge */
+};
+
+#endif // REFINER_INCL
@@ -1,21 +1,384 @@
 #include "solver.h"
+#include "logger/logger.h"
+
+#include <algorithm>
 
 Solver::Solver(const SolverType &type)
+: type{type}, pattern_nnz{-1}, matrix_id{0}, mixed{false}, symmetric{false}, cg_tol{1e-12}, single_tol{1e-5}, max_refinements{20}, iterations{0}
 {
+    SetType(type);
+#ifdef EIGEN_USE_MKL_ALL
+    // two-level parallel factorization, which scales better beyond a few threads
+    pardiso_llt.pardisoParameterArray()[23] = 1;
+    pardiso_llt_single.pardisoParameterArray()[23] = 1;
+#endif
+}
 
+void Solver::SetType(const SolverType &type)
+{
+#ifndef EIGEN_USE_MKL_ALL
+    Assert(type != SolverType::Pardiso && type != SolverType::PardisoLU, "pardiso needs eigen with mkl, EIGEN_USE_MKL_ALL is not defined");
+#endif
+    if (type != this->type) { Release(); }
+    this->type = type;
+    pattern_nnz = -1;
 }
 
-void Solve(const SparseMatrix &K, const SparseMatrix &M, Eigen::VectorXd u)
+void Solver::Release()
 {
+    ldlt.Release();
+    ldlt_single.Release();
+#ifdef EIGEN_USE_MKL_ALL
+    pardiso_llt.Release();
+    pardiso_lu.Release();
+    pardiso_llt_single.Release();
+    pardiso_lu_single.Release();
+#endif
+    sell = SellMatrix();
+    sym = SymmetricMatrix();
+    inv_diag.resize(0);
+    inv_diag_single.resize(0);
+    amg.Clear();
+}
 
+void Solver::SetMixedPrecision(const bool &mixed)
+{
+    this->mixed = mixed;
+    pattern_nnz = -1;
 }
 
-void Solver::LinearSolver()
+void Solver::SetSymmetricStorage(const bool &symmetric)
 {
+    this->symmetric = symmetric;
+    pattern_nnz = -1;
+}
 
+template<typename Scalar>
+void Solver::Multiply(const Scalar *x, Scalar *y) const
+{
+    if constexpr (std::is_same<Scalar, double>::value)
+    {
+        if (type == SolverType::MatrixFree)
+        {
+            gmg.Multiply(gmg.NumLevels() - 1, x, y);
+            return;
+        }
+    }
+    if (symmetric) { sym.Multiply(x, y); } else { sell.Multiply(x, y); }
 }
 
-void Solver::NonLinearSolver()
+template<typename T, typename Matrix>
+void Solver::FactorizeDirect(T &direct, const Matrix &A, const bool &analyze)
 {
+    if (analyze) { direct.analyzePattern(A); }
+    direct.factorize(A);
+    Assert(direct.info() == Eigen::Success, "direct factorization failed");
+}
+
+void Solver::Factorize(const SparseMatrix &A)
+{
+    Assert(type != SolverType::MatrixFree, "the matrix-free backend is set up without a matrix");
+    matrix_id++;
+    const bool analyze = A.nonZeros() != pattern_nnz;
+    pattern_nnz = A.nonZeros();
+    Assert(!symmetric || type != SolverType::PardisoLU, "PardisoLU needs the full matrix, not symmetric storage");
+    // iterative backends and the residuals of mixed precision solves use the sell or symmetric copy.  its
+    // layout is only rebuilt when the pattern changes, otherwise the values are copied
+    if ((!Direct() || mixed) && symmetric)
+    {
+        if (analyze) { sym.Assign(A); } else { sym.UpdateValues(A); }
+        if (mixed && !Direct() && !sym.SingleEnabled()) { sym.EnableSingle(); }
+    }
+    else if (!Direct() || mixed)
+    {
+        if (analyze) { sell.Assign(A); } else { sell.UpdateValues(A); }
+        if (mixed && !Direct() && !sell.SingleEnabled()) { sell.EnableSingle(); }
+    }
+
+    switch (type)
+    {
+        case SolverType::Cholesky:
+            if (mixed) { FactorizeDirect(ldlt_single, SparseMatrixF(A.cast<float>()), analyze); }
+            else { FactorizeDirect(ldlt, A, analyze); }
+            break;
+#ifdef EIGEN_USE_MKL_ALL
+        case SolverType::Pardiso:
+            if (mixed) { FactorizeDirect(pardiso_llt_single, SparseMatrixF(A.cast<float>()), analyze); }
+            else { FactorizeDirect(pardiso_llt, A, analyze); }
+            break;
+        case SolverType::PardisoLU:
+            if (mixed) { FactorizeDirect(pardiso_lu_single, SparseMatrixF(A.cast<float>()), analyze); }
+            else { FactorizeDirect(pardiso_lu, A, analyze); }
+            break;
+#endif
+        case SolverType::CG:
+        case SolverType::AMG:
+        case SolverType::GMG:
+            if (type == SolverType::AMG)
+            {
+                amg.SetSinglePrecision(mixed);
+                if (symmetric) { amg.Update(SparseMatrix(A.selfadjointView<Eigen::Upper>())); }
+                else { amg.Update(A); }
+            }
+            else if (type == SolverType::GMG)
+            {
+                gmg.Setup();
+            }
+            else
+            {
+                inv_diag = (symmetric ? sym.Diagonal() : sell.Diagonal()).cwiseInverse();
+                if (mixed) { inv_diag_single = inv_diag.cast<float>(); }
+            }
+            break;
+        default:
+            Assert(false, "unknown solver type");
+            break;
+    }
+}
+
+void Solver::Factorize()
+{
+    Assert(type == SolverType::MatrixFree, "only the matrix-free backend is set up without a matrix");
+    Assert(!mixed, "the matrix-free backend runs in double precision only");
+    Assert(!gmg.Empty(), "matrix-free backend without a mesh level");
+    matrix_id++;
+    if (gmg.NumLevels() > 1) { gmg.Setup(); }
+    else { inv_diag = gmg.Diagonal().cwiseInverse(); }
+}
+
+void Solver::Solve(const Eigen::VectorXd &b, Eigen::VectorXd &u)
+{
+    if (mixed)
+    {
+        IterativeRefinement(b, u);
+        return;
+    }
+    switch (type)
+    {
+        case SolverType::Cholesky:
+            u = ldlt.solve(b);
+            break;
+#ifdef EIGEN_USE_MKL_ALL
+        case SolverType::Pardiso:
+            u = pardiso_llt.solve(b);
+            break;
+        case SolverType::PardisoLU:
+            u = pardiso_lu.solve(b);
+            break;
+#endif
+        case SolverType::CG:
+        case SolverType::AMG:
+        case SolverType::GMG:
+        case SolverType::MatrixFree:
+            iterations = ConjugateGradient(b, u, cg_tol);
+            break;
+        default:
+            Assert(false, "unknown solver type");
+            break;
+    }
+}
+
+void Solver::Solve(const Eigen::VectorXd &b, Eigen::VectorXd &u, Recycler &recycler)
+{
+    if (Direct() || type == SolverType::MatrixFree || recycler.MaxVectors() <= 0)
+    {
+        Solve(b, u);
+        return;
+    }
+    recycler.Extrapolate(u);
+    if (symmetric) { recycler.Prepare(sym, matrix_id); } else { recycler.Prepare(sell, matrix_id); }
+    if (mixed)
+    {
+        // the projected guess only, the single precision cg is not deflated
+        Eigen::VectorXd r(b.size());
+        Multiply(u.data(), r.data());
+        r = b - r;
+        recycler.Project(u, r);
+        IterativeRefinement(b, u);
+    }
+    else
+    {
+        iterations = ConjugateGradient(b, u, cg_tol, &recycler);
+    }
+    recycler.Add(u);
+}
 
-}
\ No newline at end of file
+void Solver::IterativeRefinement(const Eigen::VectorXd &b, Eigen::VectorXd &u)
+{
+    const int n = static_cast<int>(b.size());
+    const double b_norm = b.norm();
+    iterations = 0;
+    if (b_norm == 0.0)
+    {
+        u.setZero(n);
+        return;
+    }
+    if (u.size() != n) { u.setZero(n); }
+
+    Eigen::VectorXd r(n);
+    Eigen::VectorXf r_single(n), d_single(n);
+    double error = 0.0;
+    for (int k = 0; k <= max_refinements; k++)
+    {
+        Multiply(u.data(), r.data());
+        r = b - r;
+        const double previous = error;
+        error = r.norm() / b_norm;
+        // converged, or stagnating at the accuracy the single precision correction allows
+        if (error <= cg_tol || (k > 0 && error > 0.5*previous)) { break; }
+
+        // the residual is scaled to unit size so it does not underflow in single precision
+        const double scale = r.cwiseAbs().maxCoeff();
+        r_single = (r / scale).cast<float>();
+        if (Direct())
+        {
+            SolveDirectSingle(r_single, d_single);
+            iterations++;
+        }
+        else
+        {
+            // the last step only needs to reduce the residual by what is left to the tolerance
+            d_single.setZero();
+            iterations += ConjugateGradient(r_single, d_single, std::max(single_tol, 0.5*cg_tol / error));
+        }
+        u += scale*d_single.cast<double>();
+    }
+    if (error > cg_tol)
+    {
+        WARN("mixed precision solve stopped at error %e, %d iterations", error, iterations);
+    }
+}
+
+void Solver::SolveDirectSingle(const Eigen::VectorXf &r, Eigen::VectorXf &d) const
+{
+    switch (type)
+    {
+        case SolverType::Cholesky:
+            d = ldlt_single.solve(r);
+            break;
+#ifdef EIGEN_USE_MKL_ALL
+        case SolverType::Pardiso:
+            d = pardiso_llt_single.solve(r);
+            break;
+        case SolverType::PardisoLU:
+            d = pardiso_lu_single.solve(r);
+            break;
+#endif
+        default:
+            Assert(false, "not a direct solver type");
+            break;
+    }
+}
+
+template<typename Scalar>
+int Solver::ConjugateGradient(const Vector<Scalar> &b, Vector<Scalar> &u, const double &tol, Recycler *recycler)
+{
+    const int n = static_cast<int>(b.size());
+    const double b_norm = b.norm();
+    int iters = 0;
+    if (b_norm == 0.0)
+    {
+        u.setZero(n);
+        return iters;
+    }
+    if (u.size() != n) { u.setZero(n); }
+
+    Vector<Scalar> r(n), z(n), p(n), Ap(n);
+    Multiply(u.data(), Ap.data());
+    r = b - Ap;
+    if constexpr (std::is_same<Scalar, double>::value)
+    {
+        if (recycler) { recycler->Project(u, r); }
+    }
+    Precondition(r, z);
+    p = z;
+    if constexpr (std::is_same<Scalar, double>::value)
+    {
+        if (recycler) { recycler->Deflate(z, p); }
+    }
+    Scalar rz = r.dot(z);
+    double error = r.norm() / b_norm;
+    const int max_iters = 2*n;
+    while (error > tol && iters < max_iters)
+    {
+        Multiply(p.data(), Ap.data());
+        const Scalar alpha = rz / p.dot(Ap);
+        u += alpha*p;
+        r -= alpha*Ap;
+        error = r.norm() / b_norm;
+        iters++;
+        Precondition(r, z);
+        const Scalar rz_new = r.dot(z);
+        p = z + (rz_new / rz)*p;
+        if constexpr (std::is_same<Scalar, double>::value)
+        {
+            if (recycler) { recycler->Deflate(z, p); }
+        }
+        rz = rz_new;
+    }
+    if (error > tol)
+    {
+        WARN("cg did not converge, %d iterations, error %e", iters, error);
+    }
+    return iters;
+}
+
+void Solver::Precondition(const Eigen::VectorXd &r, Eigen::VectorXd &z) const
+{
+    if (type == SolverType::AMG)
+    {
+        amg.Apply(r, z);
+    }
+    else if (type == SolverType::GMG || (type == SolverType::MatrixFree && gmg.NumLevels() > 1))
+    {
+        gmg.Apply(r, z);
+    }
+    else
+    {
+        z = inv_diag.cwiseProduct(r);
+    }
+}
+
+void Solver::Precondition(const Eigen::VectorXf &r, Eigen::VectorXf &z) const
+{
+    if (type == SolverType::AMG)
+    {
+        amg.Apply(r, z);
+    }
+    else if (type == SolverType::GMG)
+    {
+        // the multigrid is matrix-free in double precision
+        Eigen::VectorXd z_double;
+        gmg.Apply(r.cast<double>(), z_double);
+        z = z_double.cast<float>();
+    }
+    else
+    {
+        z = inv_diag_single.cwiseProduct(r);
+    }
+}
+
+std::size_t Solver::MemoryBytes(const MemoryUse &use) const
+{
+    switch (use)
+    {
+        case MemoryUse::Geometry:
+            return gmg.MemoryBytes(use);
+        case MemoryUse::Matrices:
+            return sell.MemoryBytes() + sym.MemoryBytes() + amg.MemoryBytes() + gmg.MemoryBytes(use);
+        case MemoryUse::Factorization:
+            // pardiso keeps its factors inside mkl, they are not counted
+            return FactorBytes(ldlt) + FactorBytes(ldlt_single) + gmg.MemoryBytes(use);
+        case MemoryUse::Krylov:
+        {
+            // r, z, p and Ap of cg, and the residuals of the refinement steps in mixed precision
+            const std::size_t n = (type == SolverType::MatrixFree) ? gmg.NumNodes() : std::max(sell.rows(), sym.rows());
+            std::size_t bytes = Bytes(inv_diag) + Bytes(inv_diag_single) + gmg.MemoryBytes(use);
+            if (!Direct()) { bytes += 4*n*(mixed ? sizeof(float) : sizeof(double)); }
+            if (mixed) { bytes += n*(sizeof(double) + 2*sizeof(float)); }
+            return bytes;
+        }
+        default:
+            return 0;
+    }
+}
@@ -1,28 +1,215 @@
 #ifndef SOLVER_INCL
 #define SOLVER_INCL
 
+#include "amg.h"
+#include "multigrid.h"
+#include "recycler.h"
+#include "sparse.h"
+
 #include <eigen/Eigen/Core>
 #include <eigen/Eigen/Sparse>
 #include <eigen/Eigen/OrderingMethods>
+#include <eigen/Eigen/SparseCholesky>
+#ifdef EIGEN_USE_MKL_ALL
+#include <eigen/Eigen/PardisoSupport>
+#endif
 
-typedef Eigen::SparseMatrix<double, Eigen::ColMajor> SparseMatrix;
+#include <type_traits>
 
+/** @brief linear solver backends.  all but PardisoLU require a symmetric positive definite system */
 typedef enum class SolverType
 {
-    Linear, NonLinear
+    Cholesky,   // sparse LDLT factorization
+    CG,         // jacobi preconditioned conjugate gradient on a SELL-C-sigma copy of the matrix
+    AMG,        // conjugate gradient preconditioned with a smoothed aggregation multigrid v-cycle
+    GMG,        // conjugate gradient preconditioned with a geometric multigrid v-cycle on nested meshes
+    Pardiso,    // multithreaded sparse cholesky factorization of mkl pardiso, needs EIGEN_USE_MKL_ALL
+    PardisoLU,  // multithreaded sparse LU factorization of mkl pardiso for unsymmetric systems, needs EIGEN_USE_MKL_ALL
+    MatrixFree  // conjugate gradient applying the system element by element on the finest multigrid level, without a system matrix
 } SolverType;
 
+/** @brief SimplicialLDLT that can free its factor, so a solver switched to another backend gives the memory back */
+template<typename Matrix>
+class ReleasableLDLT : public Eigen::SimplicialLDLT<Matrix, Eigen::Upper>
+{
+    public:
+        /** @brief free the factor, orderings and elimination tree.  the next factorization analyzes the pattern again */
+        inline void Release()
+        {
+            this->m_matrix = typename Eigen::SimplicialLDLT<Matrix, Eigen::Upper>::CholMatrixType();
+            this->m_diag.resize(0);
+            this->m_parent.resize(0);
+            this->m_nonZerosPerCol.resize(0);
+            this->m_P.resize(0);
+            this->m_Pinv.resize(0);
+            this->m_analysisIsOk = false;
+            this->m_factorizationIsOk = false;
+        }
+};
+
+#ifdef EIGEN_USE_MKL_ALL
+/** @brief pardiso solver that can free its factors, which mkl holds, and its copy of the matrix, like ReleasableLDLT */
+template<typename Pardiso>
+class ReleasablePardiso : public Pardiso
+{
+    public:
+        /** @brief release the memory of mkl and the copy of the matrix.  the parameters are kept, the next factorization analyzes the pattern again */
+        inline void Release()
+        {
+            this->pardisoRelease();
+            this->m_matrix = typename Pardiso::SparseMatrixType();
+            this->m_perm.resize(0);
+            this->m_analysisIsOk = false;
+            this->m_factorizationIsOk = false;
+        }
+};
+#endif
+
+/**
+ * @brief linear solves with the backend of a SolverType.  in mixed precision mode the factorizations, or the
+ * sell copy and preconditioner used by cg, are kept in single precision: direct backends factorize the matrix
+ * in float, iterative ones run cg in float to a loose tolerance.  iterative refinement with residuals in
+ * double then corrects u until it meets the double precision tolerance.  the matrix-free backend has no
+ * matrix: its multigrid holds the geometry of the finest mesh and the operator alpha M + beta K, and cg
+ * applies it element by element, preconditioned with its v-cycle on a hierarchy of levels or with its
+ * diagonal on a single one.  it runs in double precision and does not recycle solutions.
+ */
 class Solver
 {
     public:
-        Solver(const SolverType &type);
-        void Solve(const SparseMatrix &K, const SparseMatrix &M, Eigen::VectorXd u);
+        Solver(const SolverType &type = SolverType::Cholesky);
+
+        /** @brief switch the linear solver backend.  the storage of the backend left is freed */
+        void SetType(const SolverType &type);
+
+        /** @brief single precision factorizations and products with iterative refinement, from the next Factorize */
+        void SetMixedPrecision(const bool &mixed);
+
+        inline bool MixedPrecision() const { return mixed; }
+
+        /**
+         * @brief the matrices passed to Factorize hold the upper triangle of a symmetric matrix only.  cg
+         * then runs on a SymmetricMatrix copy, amg expands the matrix, PardisoLU is not available
+         */
+        void SetSymmetricStorage(const bool &symmetric);
+
+        inline bool SymmetricStorage() const { return symmetric; }
+
+        /**
+         * @brief set up the solver for a new system matrix. the symbolic analysis of the direct solver
+         * is only redone when the sparsity pattern changes, otherwise this is a numeric factorization.
+         * @param A system matrix
+         */
+        void Factorize(const SparseMatrix &A);
+
+        /**
+         * @brief set up the matrix-free backend for the operator and constraints of its multigrid, which
+         * the owner of the meshes sets before
+         */
+        void Factorize();
+
+        /**
+         * @brief solve A u = b with the matrix passed to Factorize
+         * @param b right hand side
+         * @param u solution. used as the initial guess for iterative solvers
+         */
+        void Solve(const Eigen::VectorXd &b, Eigen::VectorXd &u);
+
+        /**
+         * @brief solve A u = b as one system of a sequence, recycling the solutions of the previous ones.
+         * iterative backends start from the extrapolation of the stored solutions projected onto their span
+         * and run cg deflated by it, the direct backend ignores the recycler.  the solution is added to it
+         * @param b right hand side
+         * @param u solution
+         * @param recycler previous solutions of the sequence
+         */
+        void Solve(const Eigen::VectorXd &b, Eigen::VectorXd &u, Recycler &recycler);
+
+        /** @brief linear solver backend */
+        inline SolverType Type() const { return type; }
+
+        /** @brief hierarchy of the geometric multigrid backend, filled by the owner of the meshes */
+        inline Multigrid& GetMultigrid() { return gmg; }
+
+        /** @brief iterations of the last iterative solve, in mixed precision the inner cg iterations or the refinement steps of direct backends */
+        inline int Iterations() const { return iterations; }
+
+        /** @brief true for the backends that factorize the matrix */
+        inline bool Direct() const { return type == SolverType::Cholesky || type == SolverType::Pardiso || type == SolverType::PardisoLU; }
+
+        /** @brief redo the symbolic analysis on the next factorization, e.g. after the mesh changed */
+        inline void ResetPattern() { pattern_nnz = -1; }
+
+        /**
+         * @brief bytes held by the solver for a MemoryUse: the sell, symmetric and amg copies of the matrix as
+         * Matrices, the direct factorizations as Factorization, the multigrid element geometry as Geometry,
+         * the cg vectors and preconditioner diagonals as Krylov
+         */
+        std::size_t MemoryBytes(const MemoryUse &use) const;
+
     private:
-        void LinearSolver();
-        void NonLinearSolver();
+        typedef Eigen::SparseMatrix<float, Eigen::ColMajor> SparseMatrixF;
+
+        /** @brief free the factorizations and matrix copies of the current backend */
+        void Release();
+
+        template<typename Scalar>
+        using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+        /** @brief y = A x with the copy of the matrix for the storage, sell or symmetric */
+        template<typename Scalar>
+        void Multiply(const Scalar *x, Scalar *y) const;
+
+        /**
+         * @brief numeric factorization with a direct solver, after the reordering and symbolic analysis
+         * if the pattern changed
+         */
+        template<typename T, typename Matrix>
+        void FactorizeDirect(T &direct, const Matrix &A, const bool &analyze);
+
+        /**
+         * @brief preconditioned conjugate gradient with the sell matrix in double or single precision,
+         * deflated if a recycler is given.  @see Solve
+         * @return number of iterations
+         */
+        template<typename Scalar>
+        int ConjugateGradient(const Vector<Scalar> &b, Vector<Scalar> &u, const double &tol, Recycler *recycler = nullptr);
+
+        /** @brief mixed precision solve, single precision corrections of the double precision residual */
+        void IterativeRefinement(const Eigen::VectorXd &b, Eigen::VectorXd &u);
+
+        /** @brief correction with the single precision factorization of a direct backend */
+        void SolveDirectSingle(const Eigen::VectorXf &r, Eigen::VectorXf &d) const;
+
+        /** @brief apply the preconditioner of the backend, z = P^{-1} r */
+        void Precondition(const Eigen::VectorXd &r, Eigen::VectorXd &z) const;
+
+        /** @brief apply the preconditioner of the backend in single precision */
+        void Precondition(const Eigen::VectorXf &r, Eigen::VectorXf &z) const;
     private:
-        int max_newton_iters;   /** @brief maximum iterations for newton method */
-        double newton_tol;      /** @brief tolerance for newton method */
+        SolverType type;                                        /** @brief backend used for linear solves */
+        int pattern_nnz;                                        /** @brief nonzeros of the analyzed pattern */
+        int matrix_id;                                          /** @brief number of factorizations, identifies the current matrix */
+        bool mixed;                                             /** @brief single precision solves with iterative refinement */
+        bool symmetric;                                         /** @brief matrices stored as their upper triangle */
+        ReleasableLDLT<SparseMatrix> ldlt;                      /** @brief direct solver, reads the upper triangle */
+        ReleasableLDLT<SparseMatrixF> ldlt_single;              /** @brief direct solver in single precision */
+#ifdef EIGEN_USE_MKL_ALL
+        ReleasablePardiso<Eigen::PardisoLLT<SparseMatrix>> pardiso_llt;          /** @brief multithreaded direct solver for symmetric positive definite systems */
+        ReleasablePardiso<Eigen::PardisoLU<SparseMatrix>> pardiso_lu;            /** @brief multithreaded direct solver for unsymmetric systems */
+        ReleasablePardiso<Eigen::PardisoLLT<SparseMatrixF>> pardiso_llt_single;  /** @brief pardiso cholesky in single precision */
+        ReleasablePardiso<Eigen::PardisoLU<SparseMatrixF>> pardiso_lu_single;    /** @brief pardiso LU in single precision */
+#endif
+        SellMatrix sell;                                        /** @brief vectorized copy of the matrix for cg and mixed precision residuals */
+        SymmetricMatrix sym;                                    /** @brief copy used instead of sell with symmetric storage */
+        Eigen::VectorXd inv_diag;                               /** @brief jacobi preconditioner */
+        Eigen::VectorXf inv_diag_single;                        /** @brief jacobi preconditioner in single precision */
+        AMG amg;                                                /** @brief algebraic multigrid preconditioner */
+        Multigrid gmg;                                          /** @brief geometric multigrid preconditioner */
+        double cg_tol;                                          /** @brief cg tolerance on the residual relative to b */
+        double single_tol;                                      /** @brief tolerance of the single precision cg of a refinement step */
+        int max_refinements;                                    /** @brief maximum refinement steps of a mixed precision solve */
+        int iterations;                                         /** @brief iterations of the last cg solve */
 };
 
-#endif // SOLVER_INCL
\ No newline at end of file
+#endif // SOLVER_INCL
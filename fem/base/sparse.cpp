@@ -0,0 +1,620 @@
+#include "sparse.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+#include <numeric>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#ifdef __AVX__
+    /** @brief acc + a*b, fused when the target has fma */
+    inline __m256d MultiplyAdd(const __m256d &a, const __m256d &b, const __m256d &acc)
+    {
+    #ifdef __FMA__
+        return _mm256_fmadd_pd(a, b, acc);
+    #else
+        return _mm256_add_pd(acc, _mm256_mul_pd(a, b));
+    #endif
+    }
+
+    /** @brief acc + a*b in single precision */
+    inline __m256 MultiplyAdd(const __m256 &a, const __m256 &b, const __m256 &acc)
+    {
+    #ifdef __FMA__
+        return _mm256_fmadd_ps(a, b, acc);
+    #else
+        return _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+    #endif
+    }
+
+    /** @brief gather x at four column indices.  avx has no gather instruction, so this is four loads */
+    inline __m256d Gather(const double *x, const int *c)
+    {
+        return _mm256_set_pd(x[c[3]], x[c[2]], x[c[1]], x[c[0]]);
+    }
+
+    /** @brief gather x at eight column indices */
+    inline __m256 Gather(const float *x, const int *c)
+    {
+        return _mm256_set_ps(x[c[7]], x[c[6]], x[c[5]], x[c[4]], x[c[3]], x[c[2]], x[c[1]], x[c[0]]);
+    }
+#endif
+}
+
+void SellMatrix::Assign(const SparseMatrix &A, const int &sigma)
+{
+    Assert(sigma == 1 || sigma % C == 0, "sell sorting window %d is not a multiple of %d", sigma, C);
+    n_rows = static_cast<int>(A.rows());
+    n_cols = static_cast<int>(A.cols());
+    nnz = static_cast<int>(A.nonZeros());
+
+    // row lengths and, for every row, the positions of its entries in the column-major value array
+    std::vector<int> row_len(n_rows, 0);
+    const int *outer = A.outerIndexPtr();
+    const int *inner = A.innerIndexPtr();
+    for (int p = 0; p < nnz; p++) { row_len[inner[p]]++; }
+    std::vector<int> row_ptr(n_rows + 1, 0);
+    for (int r = 0; r < n_rows; r++) { row_ptr[r + 1] = row_ptr[r] + row_len[r]; }
+    std::vector<int> row_col(nnz), row_src(nnz);
+    std::vector<int> fill(row_ptr.begin(), row_ptr.end() - 1);
+    for (int c = 0; c < n_cols; c++)
+    {
+        for (int p = outer[c]; p < outer[c + 1]; p++)
+        {
+            const int slot = fill[inner[p]]++;
+            row_col[slot] = c;
+            row_src[slot] = p;
+        }
+    }
+
+    // sort rows by decreasing length within each window, so rows of similar length share a chunk
+    const int n_chunks = (n_rows + C - 1) / C;
+    perm.assign(n_chunks*C, -1);
+    std::iota(perm.begin(), perm.begin() + n_rows, 0);
+    for (int start = 0; sigma > 1 && start < n_rows; start += sigma)
+    {
+        const int end = std::min(start + sigma, n_rows);
+        std::stable_sort(perm.begin() + start, perm.begin() + end, [&](const int &a, const int &b) { return row_len[a] > row_len[b]; });
+    }
+
+    chunk_ptr.resize(n_chunks + 1);
+    chunk_len.resize(n_chunks);
+    chunk_ptr[0] = 0;
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        int len = 0;
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row >= 0) { len = std::max(len, row_len[row]); }
+        }
+        chunk_len[ch] = len;
+        chunk_ptr[ch + 1] = chunk_ptr[ch] + len*C;
+    }
+    col.assign(chunk_ptr[n_chunks], 0);
+    src.assign(chunk_ptr[n_chunks], -1);
+    val.assign(chunk_ptr[n_chunks], 0.0);
+    #pragma omp parallel for
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row < 0) { continue; }
+            for (int j = 0; j < row_len[row]; j++)
+            {
+                const int slot = chunk_ptr[ch] + j*C + r;
+                col[slot] = row_col[row_ptr[row] + j];
+                src[slot] = row_src[row_ptr[row] + j];
+            }
+        }
+    }
+    UpdateValues(A);
+}
+
+void SellMatrix::UpdateValues(const SparseMatrix &A)
+{
+    Assert(A.nonZeros() == nnz && A.rows() == n_rows, "matrix does not have the pattern of the sell matrix");
+    const double *a = A.valuePtr();
+    const bool single = !val_single.empty();
+    val_single.resize(single ? val.size() : 0);
+    #pragma omp parallel for
+    for (int s = 0; s < static_cast<int>(val.size()); s++)
+    {
+        val[s] = (src[s] >= 0) ? a[src[s]] : 0.0;
+        if (single) { val_single[s] = static_cast<float>(val[s]); }
+    }
+}
+
+void SellMatrix::EnableSingle()
+{
+    val_single.resize(val.size());
+    #pragma omp parallel for
+    for (int s = 0; s < static_cast<int>(val.size()); s++) { val_single[s] = static_cast<float>(val[s]); }
+}
+
+void SellMatrix::Multiply(const double *x, double *y) const
+{
+    const int n_chunks = static_cast<int>(chunk_len.size());
+    #pragma omp parallel for schedule(static)
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        const double *v = &val[chunk_ptr[ch]];
+        const int *c = &col[chunk_ptr[ch]];
+        double out[C];
+#ifdef __AVX__
+        __m256d acc = _mm256_setzero_pd();
+        for (int j = 0; j < chunk_len[ch]; j++)
+        {
+            acc = MultiplyAdd(_mm256_loadu_pd(v + j*C), Gather(x, c + j*C), acc);
+        }
+        _mm256_storeu_pd(out, acc);
+#else
+        for (int r = 0; r < C; r++) { out[r] = 0.0; }
+        for (int j = 0; j < chunk_len[ch]; j++)
+        {
+            #pragma omp simd
+            for (int r = 0; r < C; r++) { out[r] += v[j*C + r]*x[c[j*C + r]]; }
+        }
+#endif
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row >= 0) { y[row] = out[r]; }
+        }
+    }
+}
+
+void SellMatrix::Multiply(const float *x, float *y) const
+{
+    Assert(SingleEnabled(), "single precision product without the single precision copy of the values");
+    const int n_chunks = static_cast<int>(chunk_len.size());
+    #pragma omp parallel for schedule(static)
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        const float *v = &val_single[chunk_ptr[ch]];
+        const int *c = &col[chunk_ptr[ch]];
+        const int len = chunk_len[ch];
+        float out[C];
+#ifdef __AVX__
+        // columns j and j + 1 of the chunk are contiguous, one register holds both and the halves are summed at the end
+        __m256 acc = _mm256_setzero_ps();
+        int j = 0;
+        for (; j + 1 < len; j += 2)
+        {
+            acc = MultiplyAdd(_mm256_loadu_ps(v + j*C), Gather(x, c + j*C), acc);
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        if (j < len)
+        {
+            const int *cj = c + j*C;
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(v + j*C), _mm_set_ps(x[cj[3]], x[cj[2]], x[cj[1]], x[cj[0]])));
+        }
+        _mm_storeu_ps(out, sum);
+#else
+        for (int r = 0; r < C; r++) { out[r] = 0.0f; }
+        for (int j = 0; j < len; j++)
+        {
+            #pragma omp simd
+            for (int r = 0; r < C; r++) { out[r] += v[j*C + r]*x[c[j*C + r]]; }
+        }
+#endif
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row >= 0) { y[row] = out[r]; }
+        }
+    }
+}
+
+void SellMatrix::Multiply(const double *X, double *Y, const int &k) const
+{
+    const int n_chunks = static_cast<int>(chunk_len.size());
+    #pragma omp parallel for schedule(static)
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        const double *v = &val[chunk_ptr[ch]];
+        const int *c = &col[chunk_ptr[ch]];
+        // up to four vectors per sweep over the chunk, so the values and indices are read once per four
+        for (int s0 = 0; s0 < k; s0 += 4)
+        {
+            const int nv = std::min(4, k - s0);
+            double out[4][C];
+#ifdef __AVX__
+            __m256d acc[4] = { _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd() };
+            for (int j = 0; j < chunk_len[ch]; j++)
+            {
+                const __m256d vj = _mm256_loadu_pd(v + j*C);
+                for (int s = 0; s < nv; s++)
+                {
+                    acc[s] = MultiplyAdd(vj, Gather(X + static_cast<std::ptrdiff_t>(s0 + s)*n_cols, c + j*C), acc[s]);
+                }
+            }
+            for (int s = 0; s < nv; s++) { _mm256_storeu_pd(out[s], acc[s]); }
+#else
+            for (int s = 0; s < nv; s++)
+            {
+                const double *x = X + static_cast<std::ptrdiff_t>(s0 + s)*n_cols;
+                for (int r = 0; r < C; r++) { out[s][r] = 0.0; }
+                for (int j = 0; j < chunk_len[ch]; j++)
+                {
+                    #pragma omp simd
+                    for (int r = 0; r < C; r++) { out[s][r] += v[j*C + r]*x[c[j*C + r]]; }
+                }
+            }
+#endif
+            for (int r = 0; r < C; r++)
+            {
+                const int row = perm[ch*C + r];
+                if (row < 0) { continue; }
+                for (int s = 0; s < nv; s++) { Y[static_cast<std::ptrdiff_t>(s0 + s)*n_rows + row] = out[s][r]; }
+            }
+        }
+    }
+}
+
+Eigen::VectorXd SellMatrix::Diagonal() const
+{
+    Eigen::VectorXd d = Eigen::VectorXd::Zero(n_rows);
+    const int n_chunks = static_cast<int>(chunk_len.size());
+    #pragma omp parallel for
+    for (int ch = 0; ch < n_chunks; ch++)
+    {
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row < 0) { continue; }
+            for (int j = 0; j < chunk_len[ch]; j++)
+            {
+                const int slot = chunk_ptr[ch] + j*C + r;
+                if (src[slot] >= 0 && col[slot] == row) { d(row) += val[slot]; }
+            }
+        }
+    }
+    return d;
+}
+
+SparseMatrix SellMatrix::ToEigen() const
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(nnz);
+    for (int ch = 0; ch < static_cast<int>(chunk_len.size()); ch++)
+    {
+        for (int r = 0; r < C; r++)
+        {
+            const int row = perm[ch*C + r];
+            if (row < 0) { continue; }
+            for (int j = 0; j < chunk_len[ch]; j++)
+            {
+                const int slot = chunk_ptr[ch] + j*C + r;
+                if (src[slot] >= 0) { triplets.emplace_back(row, col[slot], val[slot]); }
+            }
+        }
+    }
+    SparseMatrix A(n_rows, n_cols);
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    return A;
+}
+
+void BlockMatrix::Assign(const SparseMatrix &A, const int &b)
+{
+    Assert(A.rows() % b == 0 && A.cols() % b == 0, "%d x %d matrix is not made of %d x %d blocks",
+           static_cast<int>(A.rows()), static_cast<int>(A.cols()), b, b);
+    this->b = b;
+    n_block_rows = static_cast<int>(A.rows()) / b;
+    n_block_cols = static_cast<int>(A.cols()) / b;
+
+    // block pattern: the block columns touched by each block row
+    std::vector<std::vector<int>> cols(n_block_rows);
+    for (int c = 0; c < A.outerSize(); c++)
+    {
+        for (SparseMatrix::InnerIterator it(A, c); it; ++it) { cols[it.row() / b].push_back(c / b); }
+    }
+    row_ptr.assign(n_block_rows + 1, 0);
+    for (int i = 0; i < n_block_rows; i++)
+    {
+        std::sort(cols[i].begin(), cols[i].end());
+        cols[i].erase(std::unique(cols[i].begin(), cols[i].end()), cols[i].end());
+        row_ptr[i + 1] = row_ptr[i] + static_cast<int>(cols[i].size());
+    }
+    block_col.resize(row_ptr[n_block_rows]);
+    for (int i = 0; i < n_block_rows; i++) { std::copy(cols[i].begin(), cols[i].end(), block_col.begin() + row_ptr[i]); }
+
+    val.assign(block_col.size()*b*b, 0.0);
+    for (int c = 0; c < A.outerSize(); c++)
+    {
+        for (SparseMatrix::InnerIterator it(A, c); it; ++it)
+        {
+            const int i = static_cast<int>(it.row()) / b;
+            const int j = c / b;
+            const int blk = static_cast<int>(std::lower_bound(block_col.begin() + row_ptr[i], block_col.begin() + row_ptr[i + 1], j) - block_col.begin());
+            val[(static_cast<std::size_t>(blk)*b + (c % b))*b + it.row() % b] = it.value();
+        }
+    }
+}
+
+void BlockMatrix::Multiply(const double *x, double *y) const
+{
+    const int bb = b*b;
+#ifdef __AVX__
+    if (b == 4)
+    {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n_block_rows; i++)
+        {
+            __m256d acc = _mm256_setzero_pd();
+            for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+            {
+                const double *v = &val[static_cast<std::size_t>(k)*bb];
+                const double *xj = x + block_col[k]*4;
+                acc = MultiplyAdd(_mm256_loadu_pd(v), _mm256_broadcast_sd(xj), acc);
+                acc = MultiplyAdd(_mm256_loadu_pd(v + 4), _mm256_broadcast_sd(xj + 1), acc);
+                acc = MultiplyAdd(_mm256_loadu_pd(v + 8), _mm256_broadcast_sd(xj + 2), acc);
+                acc = MultiplyAdd(_mm256_loadu_pd(v + 12), _mm256_broadcast_sd(xj + 3), acc);
+            }
+            _mm256_storeu_pd(y + i*4, acc);
+        }
+        return;
+    }
+#endif
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n_block_rows; i++)
+    {
+        double *yi = y + static_cast<std::ptrdiff_t>(i)*b;
+        for (int r = 0; r < b; r++) { yi[r] = 0.0; }
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+        {
+            const double *v = &val[static_cast<std::size_t>(k)*bb];
+            const double *xj = x + static_cast<std::ptrdiff_t>(block_col[k])*b;
+            for (int c = 0; c < b; c++)
+            {
+                #pragma omp simd
+                for (int r = 0; r < b; r++) { yi[r] += v[c*b + r]*xj[c]; }
+            }
+        }
+    }
+}
+
+void BlockMatrix::Multiply(const double *X, double *Y, const int &k) const
+{
+    const int bb = b*b;
+    const std::ptrdiff_t ldx = cols();
+    const std::ptrdiff_t ldy = rows();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n_block_rows; i++)
+    {
+        // up to four vectors per sweep over the block row, so the blocks and their columns are read once per four
+        for (int s0 = 0; s0 < k; s0 += 4)
+        {
+            const int nv = std::min(4, k - s0);
+#ifdef __AVX__
+            if (b == 4)
+            {
+                __m256d acc[4] = { _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd() };
+                for (int blk = row_ptr[i]; blk < row_ptr[i + 1]; blk++)
+                {
+                    const double *v = &val[static_cast<std::size_t>(blk)*bb];
+                    const __m256d v0 = _mm256_loadu_pd(v), v1 = _mm256_loadu_pd(v + 4);
+                    const __m256d v2 = _mm256_loadu_pd(v + 8), v3 = _mm256_loadu_pd(v + 12);
+                    for (int s = 0; s < nv; s++)
+                    {
+                        const double *xj = X + (s0 + s)*ldx + block_col[blk]*4;
+                        acc[s] = MultiplyAdd(v0, _mm256_broadcast_sd(xj), acc[s]);
+                        acc[s] = MultiplyAdd(v1, _mm256_broadcast_sd(xj + 1), acc[s]);
+                        acc[s] = MultiplyAdd(v2, _mm256_broadcast_sd(xj + 2), acc[s]);
+                        acc[s] = MultiplyAdd(v3, _mm256_broadcast_sd(xj + 3), acc[s]);
+                    }
+                }
+                for (int s = 0; s < nv; s++) { _mm256_storeu_pd(Y + (s0 + s)*ldy + i*4, acc[s]); }
+                continue;
+            }
+#endif
+            for (int s = 0; s < nv; s++)
+            {
+                double *yi = Y + (s0 + s)*ldy + static_cast<std::ptrdiff_t>(i)*b;
+                for (int r = 0; r < b; r++) { yi[r] = 0.0; }
+            }
+            for (int blk = row_ptr[i]; blk < row_ptr[i + 1]; blk++)
+            {
+                const double *v = &val[static_cast<std::size_t>(blk)*bb];
+                for (int s = 0; s < nv; s++)
+                {
+                    const double *xj = X + (s0 + s)*ldx + static_cast<std::ptrdiff_t>(block_col[blk])*b;
+                    double *yi = Y + (s0 + s)*ldy + static_cast<std::ptrdiff_t>(i)*b;
+                    for (int c = 0; c < b; c++)
+                    {
+                        #pragma omp simd
+                        for (int r = 0; r < b; r++) { yi[r] += v[c*b + r]*xj[c]; }
+                    }
+                }
+            }
+        }
+    }
+}
+
+SparseMatrix BlockMatrix::ToEigen() const
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(val.size());
+    for (int i = 0; i < n_block_rows; i++)
+    {
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+        {
+            for (int c = 0; c < b; c++)
+            {
+                for (int r = 0; r < b; r++)
+                {
+                    triplets.emplace_back(i*b + r, block_col[k]*b + c, val[(static_cast<std::size_t>(k)*b + c)*b + r]);
+                }
+            }
+        }
+    }
+    SparseMatrix A(rows(), cols());
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    return A;
+}
+
+void SymmetricMatrix::Assign(const SparseMatrix &A)
+{
+    Assert(A.rows() == A.cols(), "symmetric matrix of %d x %d", static_cast<int>(A.rows()), static_cast<int>(A.cols()));
+    n = static_cast<int>(A.rows());
+    const int *a_outer = A.outerIndexPtr();
+    const int *a_inner = A.innerIndexPtr();
+
+    // the upper triangle of every column, rows are sorted so it is the head of the column
+    outer.assign(n + 1, 0);
+    for (int c = 0; c < n; c++)
+    {
+        const int *end = std::upper_bound(a_inner + a_outer[c], a_inner + a_outer[c + 1], c);
+        outer[c + 1] = outer[c] + static_cast<int>(end - (a_inner + a_outer[c]));
+    }
+    const bool upper = outer[n] == A.nonZeros();
+    inner.resize(outer[n]);
+    src.resize(upper ? 0 : outer[n]);
+    #pragma omp parallel for
+    for (int c = 0; c < n; c++)
+    {
+        for (int p = outer[c]; p < outer[c + 1]; p++)
+        {
+            inner[p] = a_inner[a_outer[c] + p - outer[c]];
+            if (!upper) { src[p] = a_outer[c] + p - outer[c]; }
+        }
+    }
+    val.resize(outer[n]);
+    UpdateValues(A);
+
+    // greedy coloring of the column blocks, a block conflicts with every block writing one of its rows
+    const int n_blocks = (n + block_size - 1) / block_size;
+    std::vector<std::vector<int>> colors_at(n);
+    std::vector<int> block_color(n_blocks);
+    std::vector<int> forbidden;
+    int n_colors = 0;
+    for (int b = 0; b < n_blocks; b++)
+    {
+        const int first = outer[b*block_size];
+        const int last = outer[std::min((b + 1)*block_size, n)];
+        for (int p = first; p < last; p++)
+        {
+            for (const int &color : colors_at[inner[p]]) { forbidden[color] = b; }
+        }
+        int color = 0;
+        while (color < n_colors && forbidden[color] == b) { color++; }
+        if (color == n_colors)
+        {
+            n_colors++;
+            forbidden.push_back(-1);
+        }
+        block_color[b] = color;
+        for (int p = first; p < last; p++)
+        {
+            std::vector<int> &at = colors_at[inner[p]];
+            if (std::find(at.begin(), at.end(), color) == at.end()) { at.push_back(color); }
+        }
+    }
+    color_ptr.assign(n_colors + 1, 0);
+    for (int b = 0; b < n_blocks; b++) { color_ptr[block_color[b] + 1]++; }
+    for (int c = 0; c < n_colors; c++) { color_ptr[c + 1] += color_ptr[c]; }
+    blocks.resize(n_blocks);
+    std::vector<int> fill(color_ptr.begin(), color_ptr.end() - 1);
+    for (int b = 0; b < n_blocks; b++) { blocks[fill[block_color[b]]++] = b; }
+}
+
+void SymmetricMatrix::UpdateValues(const SparseMatrix &A)
+{
+    Assert(A.rows() == n && (src.empty() ? A.nonZeros() == nonZeros() : A.nonZeros() > nonZeros()),
+           "matrix does not have the pattern of the symmetric matrix");
+    const double *a = A.valuePtr();
+    const bool single = !val_single.empty();
+    val_single.resize(single ? val.size() : 0);
+    #pragma omp parallel for
+    for (int p = 0; p < nonZeros(); p++)
+    {
+        val[p] = src.empty() ? a[p] : a[src[p]];
+        if (single) { val_single[p] = static_cast<float>(val[p]); }
+    }
+}
+
+void SymmetricMatrix::EnableSingle()
+{
+    val_single.resize(val.size());
+    #pragma omp parallel for
+    for (int p = 0; p < nonZeros(); p++) { val_single[p] = static_cast<float>(val[p]); }
+}
+
+template<typename Scalar>
+void SymmetricMatrix::Product(const Scalar *v, const Scalar *X, Scalar *Y, const int &k) const
+{
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static)
+        for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(n)*k; i++) { Y[i] = 0; }
+        for (int color = 0; color < NumColors(); color++)
+        {
+            #pragma omp for schedule(static)
+            for (int kb = color_ptr[color]; kb < color_ptr[color + 1]; kb++)
+            {
+                const int first = blocks[kb]*block_size;
+                const int last = std::min(first + block_size, n);
+                for (int s = 0; s < k; s++)
+                {
+                    const Scalar *x = X + static_cast<std::ptrdiff_t>(s)*n;
+                    Scalar *y = Y + static_cast<std::ptrdiff_t>(s)*n;
+                    for (int c = first; c < last; c++)
+                    {
+                        // row c from the column by symmetry, and the mirror of every off-diagonal entry.  rows
+                        // are sorted, so the diagonal is the last entry and the loop over the others has no branch
+                        int end = outer[c + 1];
+                        const Scalar xc = x[c];
+                        Scalar sum = 0;
+                        if (end > outer[c] && inner[end - 1] == c) { sum = v[--end]*xc; }
+                        for (int p = outer[c]; p < end; p++)
+                        {
+                            const int r = inner[p];
+                            sum += v[p]*x[r];
+                            y[r] += v[p]*xc;
+                        }
+                        y[c] += sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SymmetricMatrix::Multiply(const double *x, double *y) const
+{
+    Product(val.data(), x, y, 1);
+}
+
+void SymmetricMatrix::Multiply(const float *x, float *y) const
+{
+    Assert(SingleEnabled(), "single precision product without the single precision copy of the values");
+    Product(val_single.data(), x, y, 1);
+}
+
+void SymmetricMatrix::Multiply(const double *X, double *Y, const int &k) const
+{
+    Product(val.data(), X, Y, k);
+}
+
+Eigen::VectorXd SymmetricMatrix::Diagonal() const
+{
+    Eigen::VectorXd d = Eigen::VectorXd::Zero(n);
+    #pragma omp parallel for
+    for (int c = 0; c < n; c++)
+    {
+        // rows are sorted, so the diagonal is the last entry of the column
+        if (outer[c + 1] > outer[c] && inner[outer[c + 1] - 1] == c) { d(c) = val[outer[c + 1] - 1]; }
+    }
+    return d;
+}
+
+SparseMatrix SymmetricMatrix::ToEigen() const
+{
+    const SparseMatrix U = Eigen::Map<const SparseMatrix>(n, n, nonZeros(), outer.data(), inner.data(), val.data());
+    return U.selfadjointView<Eigen::Upper>();
+}
@@ -0,0 +1,220 @@
+#ifndef SPARSE_INCL
+#define SPARSE_INCL
+
+#include "memory.h"
+
+#include <eigen/Eigen/Core>
+#include <eigen/Eigen/Sparse>
+
+#include <vector>
+
+typedef Eigen::SparseMatrix<double, Eigen::ColMajor> SparseMatrix;
+
+/**
+ * @brief scalar sparse matrix in SELL-C-sigma format for vectorized products.  rows are sorted by
+ * length within windows of sigma rows and packed in chunks of C rows, C being the number of doubles in
+ * an avx register.  each chunk is padded to its longest row and stored column by column, so a product
+ * step loads C values and C column indices contiguously and updates C rows with one fma.  products with
+ * several vectors (e.g. all species at once) read the indices and values once for every vector.  a single
+ * precision copy of the values can be kept for products in float, which move two thirds of the bytes and
+ * fill an avx register with two columns of a chunk.
+ */
+class SellMatrix
+{
+    public:
+        static constexpr int C = 4; /** @brief rows per chunk */
+
+        SellMatrix() = default;
+
+        /**
+         * @brief convert from an eigen matrix
+         * @param A matrix to convert
+         * @param sigma sorting window in rows, a multiple of C.  1 keeps the original row order
+         */
+        explicit SellMatrix(const SparseMatrix &A, const int &sigma = 128) { Assign(A, sigma); }
+
+        /** @brief convert from an eigen matrix.  @see SellMatrix(const SparseMatrix&, const int&) */
+        void Assign(const SparseMatrix &A, const int &sigma = 128);
+
+        /**
+         * @brief copy the values of a matrix with the pattern of the one last assigned, without
+         * re-sorting or re-packing
+         * @param A matrix with the same pattern
+         */
+        void UpdateValues(const SparseMatrix &A);
+
+        /** @brief y = A x */
+        void Multiply(const double *x, double *y) const;
+
+        /** @brief y = A x in single precision, with the copy made by EnableSingle */
+        void Multiply(const float *x, float *y) const;
+
+        /**
+         * @brief Y = A X for k vectors stored one after the other
+         * @param X k input vectors of length cols(), leading dimension cols()
+         * @param Y k output vectors of length rows(), leading dimension rows()
+         * @param k number of vectors
+         */
+        void Multiply(const double *X, double *Y, const int &k) const;
+
+        /** @brief keep a single precision copy of the values, updated with them from now on */
+        void EnableSingle();
+
+        /** @brief true if the single precision copy is kept */
+        inline bool SingleEnabled() const { return val_single.size() == val.size() && !val.empty(); }
+
+        /** @brief diagonal of the matrix */
+        Eigen::VectorXd Diagonal() const;
+
+        /** @brief convert back to an eigen matrix, e.g. for a direct solver */
+        SparseMatrix ToEigen() const;
+
+        inline int rows() const { return n_rows; }
+        inline int cols() const { return n_cols; }
+        inline int nonZeros() const { return nnz; }
+
+        /** @brief stored entries, including padding, over nonzeros */
+        inline double Fill() const { return nnz > 0 ? static_cast<double>(val.size()) / nnz : 1.0; }
+
+        /** @brief bytes held by the matrix */
+        inline std::size_t MemoryBytes() const
+        {
+            return Bytes(chunk_ptr) + Bytes(chunk_len) + Bytes(perm) + Bytes(col) + Bytes(val) + Bytes(val_single) + Bytes(src);
+        }
+
+    private:
+        int n_rows = 0;             /** @brief number of rows */
+        int n_cols = 0;             /** @brief number of columns */
+        int nnz = 0;                /** @brief number of nonzeros, without padding */
+        std::vector<int> chunk_ptr; /** @brief first slot of each chunk */
+        std::vector<int> chunk_len; /** @brief length of the longest row of each chunk */
+        std::vector<int> perm;      /** @brief original row stored at each sorted position, -1 for padding rows */
+        std::vector<int> col;       /** @brief column of each slot.  padding slots use column 0 with value 0 */
+        std::vector<double> val;    /** @brief value of each slot */
+        std::vector<float> val_single; /** @brief single precision copy of val, empty unless enabled */
+        std::vector<int> src;       /** @brief position of each slot in the eigen value array, -1 for padding */
+};
+
+/**
+ * @brief block compressed sparse row matrix for systems where every node carries b coupled unknowns,
+ * numbered node-major (unknown s of node i is row i*b + s).  a block column index is stored once for the
+ * b x b block instead of once per entry, which cuts the index traffic of a product by b^2.  blocks are
+ * column-major, so the product of a block with a vector is b column updates; with b = 4 a column is one
+ * avx register.
+ */
+class BlockMatrix
+{
+    public:
+        BlockMatrix() = default;
+
+        /**
+         * @brief convert from an eigen matrix.  a block is stored if any of its entries is in the pattern
+         * @param A matrix to convert, rows and cols a multiple of b
+         * @param b block size
+         */
+        BlockMatrix(const SparseMatrix &A, const int &b) { Assign(A, b); }
+
+        /** @brief convert from an eigen matrix.  @see BlockMatrix(const SparseMatrix&, const int&) */
+        void Assign(const SparseMatrix &A, const int &b);
+
+        /** @brief y = A x */
+        void Multiply(const double *x, double *y) const;
+
+        /** @brief Y = A X for k vectors stored one after the other, each block read once for up to four of them */
+        void Multiply(const double *X, double *Y, const int &k) const;
+
+        /** @brief convert back to an eigen matrix with every entry of the stored blocks */
+        SparseMatrix ToEigen() const;
+
+        inline int rows() const { return n_block_rows*b; }
+        inline int cols() const { return n_block_cols*b; }
+        inline int BlockSize() const { return b; }
+        inline int NumBlocks() const { return static_cast<int>(block_col.size()); }
+
+    private:
+        int b = 1;                      /** @brief block size */
+        int n_block_rows = 0;           /** @brief number of block rows */
+        int n_block_cols = 0;           /** @brief number of block columns */
+        std::vector<int> row_ptr;       /** @brief first block of each block row */
+        std::vector<int> block_col;     /** @brief block column of each block */
+        std::vector<double> val;        /** @brief b*b values per block, column-major within the block */
+};
+
+/**
+ * @brief symmetric sparse matrix stored as its upper triangle, column-major like SparseMatrix.  a product
+ * reads every stored entry once and applies it to both a_rc x_c and its mirror a_cr x_r, so it moves about
+ * half the bytes of a product with the full matrix.  the mirrored updates of different columns collide,
+ * so consecutive columns are grouped into blocks and the blocks colored such that no two blocks of a color
+ * write the same entry of y.  the blocks of a color run in parallel, the colors one after the other.
+ */
+class SymmetricMatrix
+{
+    public:
+        static constexpr int block_size = 32; /** @brief consecutive columns of a block */
+
+        SymmetricMatrix() = default;
+
+        /** @brief convert from an eigen matrix.  @see Assign */
+        explicit SymmetricMatrix(const SparseMatrix &A) { Assign(A); }
+
+        /**
+         * @brief convert from an eigen matrix and color the column blocks
+         * @param A symmetric matrix, either its upper triangle only or full, of which the upper triangle is kept
+         */
+        void Assign(const SparseMatrix &A);
+
+        /** @brief copy the values of a matrix with the pattern of the one last assigned */
+        void UpdateValues(const SparseMatrix &A);
+
+        /** @brief y = A x */
+        void Multiply(const double *x, double *y) const;
+
+        /** @brief y = A x in single precision, with the copy made by EnableSingle */
+        void Multiply(const float *x, float *y) const;
+
+        /** @brief Y = A X for k vectors stored one after the other, each entry read once for all of them */
+        void Multiply(const double *X, double *Y, const int &k) const;
+
+        /** @brief keep a single precision copy of the values, updated with them from now on */
+        void EnableSingle();
+
+        /** @brief true if the single precision copy is kept */
+        inline bool SingleEnabled() const { return val_single.size() == val.size() && !val.empty(); }
+
+        /** @brief diagonal of the matrix */
+        Eigen::VectorXd Diagonal() const;
+
+        /** @brief convert back to an eigen matrix with both triangles */
+        SparseMatrix ToEigen() const;
+
+        inline int rows() const { return n; }
+        inline int cols() const { return n; }
+
+        /** @brief stored entries, the upper triangle with the diagonal */
+        inline int nonZeros() const { return static_cast<int>(val.size()); }
+
+        inline int NumColors() const { return static_cast<int>(color_ptr.size()) - 1; }
+
+        /** @brief bytes held by the matrix */
+        inline std::size_t MemoryBytes() const
+        {
+            return Bytes(outer) + Bytes(inner) + Bytes(val) + Bytes(val_single) + Bytes(src) + Bytes(color_ptr) + Bytes(blocks);
+        }
+
+    private:
+        /** @brief Y = A X for k vectors with the values v in one precision */
+        template<typename Scalar>
+        void Product(const Scalar *v, const Scalar *X, Scalar *Y, const int &k) const;
+
+    private:
+        int n = 0;                      /** @brief number of rows and columns */
+        std::vector<int> outer;         /** @brief first entry of each column */
+        std::vector<int> inner;         /** @brief row of each entry, at most the column */
+        std::vector<double> val;        /** @brief value of each entry */
+        std::vector<float> val_single;  /** @brief single precision copy of val, empty unless enabled */
+        std::vector<int> src;           /** @brief position of each entry in the value array of a full eigen matrix, empty for an upper one */
+        std::vector<int> color_ptr;     /** @brief first block of each color in blocks */
+        std::vector<int> blocks;        /** @brief column blocks ordered by color */
+};
+
+#endif // SPARSE_INCL
@@ -12,7 +12,7 @@
 /**
  * @brief supported element types. used for initialize elements while reading in
  * mesh data and creating a mesh object.
- * @see Mesh::InitElements, Mesh::AllocateElements, Mesh::CreateElement
+ * @see Mesh::InitElements, Mesh::ReadMesh
  */
 typedef enum class ElementType : short
 {
@@ -32,9 +32,10 @@ class Node; // forward declaration
 
 /**
  * @brief pure virtual class to make switching between elements easier. all element types inherit
- * from this class, so the functions are implemented per-element.  this also assumes that the
- * elements are homogeneous throughout the mesh.  will need to be changed it multiple element types
- * are used in a mesh.
+ * from this class, so the functions are implemented per-element.  the concrete element types are
+ * final and the mesh stores each type in its own block, so kernel loops over a block call these
+ * methods without virtual dispatch.
+ * @see Mesh::ForEachBlock
  */
 class Element
 {
@@ -154,7 +155,9 @@ class Node3D : public Node
     public:
         Node3D()
         : Node()
-        {}
+        {
+            coords = Eigen::Vector3d::Zero();
+        }
     public:
         void NodeType() override { std::cout << "Node3D\n"; }
     public:
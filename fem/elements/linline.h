@@ -2,12 +2,18 @@
 #define LIN_LINE_INCL
 
 #include "element.h"
+#include "refbasis.h"
 
-class LinLine : public Element
+/**
+ * @brief 2 node linear line element.
+ * shape functions and parent gradients come from the tabulated RefBasis, so building the element
+ * matrices only involves the geometric mapping.  nodes are stored with 3D coordinates so the element
+ * can also be used as a boundary facet of a higher dimensional mesh.
+ */
+class LinLine final : public Element
 {
     public:
-        int elem_id;
-        std::string type_str = "LinLine";
+        typedef RefBasis<ElementType::LinLine> Basis;
     public:
         LinLine();
 
@@ -29,7 +35,7 @@ class LinLine : public Element
         /** @brief compute the gradient of the shape function in the parent domain */
         void ComputeShapeGradient(const int &ip) override;
 
-        /** @brief compute the jacobian matrix */
+        /** @brief compute the jacobian and the shape function gradients in the physical domain */
         void ComputeJ(const int &ip) override;
 
         /** @brief get the determinant of the jacobian */
@@ -43,21 +49,18 @@ class LinLine : public Element
          * @param idx index of the node to access
          * @return Node& 
          */
-        Node& Nodes(const int &idx) override;
+        Node3D& Nodes(const int &idx) override;
 
     private:
-        int n_nodes;        // number of nodes
-        int n_ip;           // number of integration points
-        Node1D nodes[2];    // element node list
-        double xi_ip[2];    // integration points
-        double wip[2];
-        Eigen::Vector2d Nvec;
-        Eigen::Vector2d GradNvec;
-        double _j;          // jacobian is just a number in 1D
-
-        Eigen::Vector2d _u;
-        Eigen::Matrix2d _k;
-        Eigen::Matrix2d _m;
+        static constexpr int n_nodes = Basis::n_nodes;  // number of nodes
+        static constexpr int n_ip = Basis::n_ip;        // number of integration points
+        Node3D nodes[n_nodes];                          // element node list
+        Eigen::Matrix<double, n_nodes, 1> Nvec;
+        Basis::GradNMatrix GradNvec;                    // gradient wrt parent coordinates
+        Eigen::Matrix<double, n_nodes, 3> GradNx;       // gradient wrt physical coordinates
+        Eigen::Matrix<double, n_nodes, n_nodes> _k;
+        Eigen::Matrix<double, n_nodes, n_nodes> _m;
+        double _j;                                      // determinant of the jacobian
 };
 
-#endif // LIN_LINE_INCL
\ No newline at end of file
+#endif // LIN_LINE_INCL
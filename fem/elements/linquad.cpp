@@ -0,0 +1,70 @@
+#include "linquad.h"
+
+#include <iostream>
+
+LinQuad::LinQuad()
+{
+    type_str = "LinQuad";
+}
+
+void LinQuad::BuildElemK()
+{
+    _k.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeJ(ip);
+        _k.noalias() += GradNx*GradNx.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+void LinQuad::BuildElemM()
+{
+    _m.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeShapeFunction(ip);
+        ComputeJ(ip);
+        _m.noalias() += Nvec*Nvec.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+double& LinQuad::k(const int &i, const int &j)
+{
+    return _k(i,j);
+}
+
+double& LinQuad::m(const int &i, const int &j)
+{
+    return _m(i,j);
+}
+
+void LinQuad::ComputeShapeFunction(const int &ip)
+{
+    Nvec = Basis::N(ip);
+}
+
+void LinQuad::ComputeShapeGradient(const int &ip)
+{
+    GradNvec = Basis::dN(ip);
+}
+
+void LinQuad::ComputeJ(const int &ip)
+{
+    ComputeShapeGradient(ip);
+    _j = Basis::MapGradient(nodes, ip, GradNx);
+}
+
+double& LinQuad::j()
+{
+    return _j;
+}
+
+void LinQuad::GetIP()
+{
+    std::cout << n_ip << "\n";
+}
+
+Node3D& LinQuad::Nodes(const int &idx)
+{
+    return nodes[idx];
+}
@@ -2,12 +2,18 @@
 #define LIN_TET_INCL
 
 #include "element.h"
+#include "refbasis.h"
 
-class LinTet : public Element
+/**
+ * @brief 4 node linear tetrahedral element.
+ * shape functions and parent gradients come from the tabulated RefBasis, so building the element
+ * matrices only involves the geometric mapping.  nodes are stored with 3D coordinates so the element
+ * can also be used as a boundary facet of a higher dimensional mesh.
+ */
+class LinTet final : public Element
 {
     public:
-        int elem_id;
-        std::string type_str = "LinTet";
+        typedef RefBasis<ElementType::LinTet> Basis;
     public:
         LinTet();
 
@@ -29,7 +35,7 @@ class LinTet : public Element
         /** @brief compute the gradient of the shape function in the parent domain */
         void ComputeShapeGradient(const int &ip) override;
 
-        /** @brief compute the jacobian matrix */
+        /** @brief compute the jacobian and the shape function gradients in the physical domain */
         void ComputeJ(const int &ip) override;
 
         /** @brief get the determinant of the jacobian */
@@ -43,21 +49,18 @@ class LinTet : public Element
          * @param idx index of the node to access
          * @return Node& 
          */
-        inline Node& Nodes(const int &idx) override;
+        Node3D& Nodes(const int &idx) override;
 
     private:
-        int n_nodes;
-        int n_ip;
-        Node3D nodes[4];
-        double xi_ip[4]; // integration points
-        double eta_ip[4]; // integration points
-        double zeta_ip[4]; // integration points
-        double wip[4];
-        Eigen::Vector4d Nvec;
-        Eigen::Matrix<double, 4, 3> GradNvec;
-        Eigen::Matrix<double, 4, 4> _k;
-        Eigen::Matrix<double, 4, 4> _m;
-        double _j; // determinant of the jacobian
+        static constexpr int n_nodes = Basis::n_nodes;  // number of nodes
+        static constexpr int n_ip = Basis::n_ip;        // number of integration points
+        Node3D nodes[n_nodes];                          // element node list
+        Eigen::Matrix<double, n_nodes, 1> Nvec;
+        Basis::GradNMatrix GradNvec;                    // gradient wrt parent coordinates
+        Eigen::Matrix<double, n_nodes, 3> GradNx;       // gradient wrt physical coordinates
+        Eigen::Matrix<double, n_nodes, n_nodes> _k;
+        Eigen::Matrix<double, n_nodes, n_nodes> _m;
+        double _j;                                      // determinant of the jacobian
 };
 
-#endif // LIN_Tet_INCL
\ No newline at end of file
+#endif // LIN_TET_INCL
@@ -2,16 +2,22 @@
 #define LIN_TRI_INCL
 
 #include "element.h"
+#include "refbasis.h"
 
-class LinTri : public Element
+/**
+ * @brief 3 node linear triangle element.
+ * shape functions and parent gradients come from the tabulated RefBasis, so building the element
+ * matrices only involves the geometric mapping.  nodes are stored with 3D coordinates so the element
+ * can also be used as a boundary facet of a higher dimensional mesh.
+ */
+class LinTri final : public Element
 {
     public:
-        int elem_id;   
-        std::string type_str = "LinTri";   
+        typedef RefBasis<ElementType::LinTri> Basis;
     public:
         LinTri();
 
-        /** @brief construct the element stiffness/tangent matrix */
+        /** @brief construct the element stiffness matrix */
         void BuildElemK() override;
 
         /** @brief construct the element mass matrix */
@@ -29,7 +35,7 @@ class LinTri : public Element
         /** @brief compute the gradient of the shape function in the parent domain */
         void ComputeShapeGradient(const int &ip) override;
 
-        /** @brief compute the jacobian matrix */
+        /** @brief compute the jacobian and the shape function gradients in the physical domain */
         void ComputeJ(const int &ip) override;
 
         /** @brief get the determinant of the jacobian */
@@ -43,20 +49,18 @@ class LinTri : public Element
          * @param idx index of the node to access
          * @return Node& 
          */
-       Node2D& Nodes(const int &idx) override;
+        Node3D& Nodes(const int &idx) override;
 
     private:
-        int n_nodes = 3;
-        int n_ip = 3;
-        Node2D nodes[3];
-        double xi_ip[3]; // integration points
-        double eta_ip[3];
-        double wip[3];
-        Eigen::Vector3d Nvec;
-        Eigen::Matrix<double, 3, 2> GradNvec;
-        Eigen::Matrix3d _k;
-        Eigen::Matrix3d _m;
-        double _j;      
+        static constexpr int n_nodes = Basis::n_nodes;  // number of nodes
+        static constexpr int n_ip = Basis::n_ip;        // number of integration points
+        Node3D nodes[n_nodes];                          // element node list
+        Eigen::Matrix<double, n_nodes, 1> Nvec;
+        Basis::GradNMatrix GradNvec;                    // gradient wrt parent coordinates
+        Eigen::Matrix<double, n_nodes, 3> GradNx;       // gradient wrt physical coordinates
+        Eigen::Matrix<double, n_nodes, n_nodes> _k;
+        Eigen::Matrix<double, n_nodes, n_nodes> _m;
+        double _j;                                      // determinant of the jacobian
 };
 
-#endif // LIN_TRI_INCL
\ No newline at end of file
+#endif // LIN_TRI_INCL
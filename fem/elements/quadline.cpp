@@ -0,0 +1,70 @@
+#include "quadline.h"
+
+#include <iostream>
+
+QuadLine::QuadLine()
+{
+    type_str = "QuadLine";
+}
+
+void QuadLine::BuildElemK()
+{
+    _k.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeJ(ip);
+        _k.noalias() += GradNx*GradNx.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+void QuadLine::BuildElemM()
+{
+    _m.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeShapeFunction(ip);
+        ComputeJ(ip);
+        _m.noalias() += Nvec*Nvec.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+double& QuadLine::k(const int &i, const int &j)
+{
+    return _k(i,j);
+}
+
+double& QuadLine::m(const int &i, const int &j)
+{
+    return _m(i,j);
+}
+
+void QuadLine::ComputeShapeFunction(const int &ip)
+{
+    Nvec = Basis::N(ip);
+}
+
+void QuadLine::ComputeShapeGradient(const int &ip)
+{
+    GradNvec = Basis::dN(ip);
+}
+
+void QuadLine::ComputeJ(const int &ip)
+{
+    ComputeShapeGradient(ip);
+    _j = Basis::MapGradient(nodes, ip, GradNx);
+}
+
+double& QuadLine::j()
+{
+    return _j;
+}
+
+void QuadLine::GetIP()
+{
+    std::cout << n_ip << "\n";
+}
+
+Node3D& QuadLine::Nodes(const int &idx)
+{
+    return nodes[idx];
+}
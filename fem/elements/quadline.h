@@ -0,0 +1,66 @@
+#ifndef QUAD_LINE_INCL
+#define QUAD_LINE_INCL
+
+#include "element.h"
+#include "refbasis.h"
+
+/**
+ * @brief 3 node quadratic line element.  local nodes are the two end points followed by the midpoint.
+ * shape functions and parent gradients come from the tabulated RefBasis, so building the element
+ * matrices only involves the geometric mapping.  nodes are stored with 3D coordinates so the element
+ * can also be used as a boundary facet of a higher dimensional mesh.
+ */
+class QuadLine final : public Element
+{
+    public:
+        typedef RefBasis<ElementType::QuadLine> Basis;
+    public:
+        QuadLine();
+
+        /** @brief construct the element stiffness matrix */
+        void BuildElemK() override;
+
+        /** @brief construct the element mass matrix */
+        void BuildElemM() override;
+
+        /** @brief get the element stiffness matrix */
+        double& k(const int &i, const int &j) override;
+
+        /** @brief get the element mass matrix */
+        double& m(const int &i, const int &j) override;
+
+        /** @brief compute the shape function for in the parent domain */
+        void ComputeShapeFunction(const int &ip) override;
+
+        /** @brief compute the gradient of the shape function in the parent domain */
+        void ComputeShapeGradient(const int &ip) override;
+
+        /** @brief compute the jacobian and the shape function gradients in the physical domain */
+        void ComputeJ(const int &ip) override;
+
+        /** @brief get the determinant of the jacobian */
+        double& j() override;
+
+        void GetIP() override;
+
+        /**
+         * @brief accessor function to get and assign nodes to an element.  this is needed since
+         * element nodes are stored statically in memory, rather than dynamically.
+         * @param idx index of the node to access
+         * @return Node& 
+         */
+        Node3D& Nodes(const int &idx) override;
+
+    private:
+        static constexpr int n_nodes = Basis::n_nodes;  // number of nodes
+        static constexpr int n_ip = Basis::n_ip;        // number of integration points
+        Node3D nodes[n_nodes];                          // element node list
+        Eigen::Matrix<double, n_nodes, 1> Nvec;
+        Basis::GradNMatrix GradNvec;                    // gradient wrt parent coordinates
+        Eigen::Matrix<double, n_nodes, 3> GradNx;       // gradient wrt physical coordinates
+        Eigen::Matrix<double, n_nodes, n_nodes> _k;
+        Eigen::Matrix<double, n_nodes, n_nodes> _m;
+        double _j;                                      // determinant of the jacobian
+};
+
+#endif // QUAD_LINE_INCL
@@ -0,0 +1,70 @@
+#include "quadquad.h"
+
+#include <iostream>
+
+QuadQuad::QuadQuad()
+{
+    type_str = "QuadQuad";
+}
+
+void QuadQuad::BuildElemK()
+{
+    _k.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeJ(ip);
+        _k.noalias() += GradNx*GradNx.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+void QuadQuad::BuildElemM()
+{
+    _m.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeShapeFunction(ip);
+        ComputeJ(ip);
+        _m.noalias() += Nvec*Nvec.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+double& QuadQuad::k(const int &i, const int &j)
+{
+    return _k(i,j);
+}
+
+double& QuadQuad::m(const int &i, const int &j)
+{
+    return _m(i,j);
+}
+
+void QuadQuad::ComputeShapeFunction(const int &ip)
+{
+    Nvec = Basis::N(ip);
+}
+
+void QuadQuad::ComputeShapeGradient(const int &ip)
+{
+    GradNvec = Basis::dN(ip);
+}
+
+void QuadQuad::ComputeJ(const int &ip)
+{
+    ComputeShapeGradient(ip);
+    _j = Basis::MapGradient(nodes, ip, GradNx);
+}
+
+double& QuadQuad::j()
+{
+    return _j;
+}
+
+void QuadQuad::GetIP()
+{
+    std::cout << n_ip << "\n";
+}
+
+Node3D& QuadQuad::Nodes(const int &idx)
+{
+    return nodes[idx];
+}
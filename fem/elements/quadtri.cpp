@@ -0,0 +1,70 @@
+#include "quadtri.h"
+
+#include <iostream>
+
+QuadTri::QuadTri()
+{
+    type_str = "QuadTri";
+}
+
+void QuadTri::BuildElemK()
+{
+    _k.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeJ(ip);
+        _k.noalias() += GradNx*GradNx.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+void QuadTri::BuildElemM()
+{
+    _m.setZero();
+    for (int ip = 0; ip < n_ip; ip++)
+    {
+        ComputeShapeFunction(ip);
+        ComputeJ(ip);
+        _m.noalias() += Nvec*Nvec.transpose()*(_j*Basis::w(ip));
+    }
+}
+
+double& QuadTri::k(const int &i, const int &j)
+{
+    return _k(i,j);
+}
+
+double& QuadTri::m(const int &i, const int &j)
+{
+    return _m(i,j);
+}
+
+void QuadTri::ComputeShapeFunction(const int &ip)
+{
+    Nvec = Basis::N(ip);
+}
+
+void QuadTri::ComputeShapeGradient(const int &ip)
+{
+    GradNvec = Basis::dN(ip);
+}
+
+void QuadTri::ComputeJ(const int &ip)
+{
+    ComputeShapeGradient(ip);
+    _j = Basis::MapGradient(nodes, ip, GradNx);
+}
+
+double& QuadTri::j()
+{
+    return _j;
+}
+
+void QuadTri::GetIP()
+{
+    std::cout << n_ip << "\n";
+}
+
+Node3D& QuadTri::Nodes(const int &idx)
+{
+    return nodes[idx];
+}
@@ -0,0 +1,309 @@
+#ifndef REF_BASIS_INCL
+#define REF_BASIS_INCL
+
+#include "element.h"
+
+#include <cmath>
+
+/**
+ * @brief shape function values, parent domain gradients and quadrature weights tabulated at the
+ * integration points of one element type.  the table is filled in at compile time, so the only
+ * per-element work left at run time is the geometric mapping (jacobian and its inverse).
+ * @tparam NN number of nodes per element
+ * @tparam NIP number of integration points
+ * @tparam DIM dimension of the parent domain
+ */
+template<int NN, int NIP, int DIM>
+struct BasisTable
+{
+    double wip[NIP];            /** @brief integration weights */
+    double N[NIP][NN];          /** @brief shape functions at each integration point */
+    double dN[NIP][NN][DIM];    /** @brief parent domain shape gradients at each integration point */
+};
+
+/**
+ * @brief parent domain shape functions and quadrature rule of an element type.  each specialization
+ * provides n_nodes, n_ip, dim, the integration points xi_ip and weights wip, and a constexpr Eval
+ * that evaluates the shape functions and their gradients at a point of the parent domain.
+ * @see RefBasis
+ */
+template<ElementType T> struct Shape;
+
+/**
+ * @brief linear line on [-1,1].  2 point gauss rule.
+ */
+template<>
+struct Shape<ElementType::LinLine>
+{
+    static constexpr int n_nodes = 2;
+    static constexpr int n_ip = 2;
+    static constexpr int dim = 1;
+    static constexpr double g = 0.5773502691896257; // 1/sqrt(3)
+    static constexpr double xi_ip[n_ip][dim] = { {-g}, {g} };
+    static constexpr double wip[n_ip] = { 1.0, 1.0 };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        N[0] = 0.5*(1.0 - xi[0]);   dN[0][0] = -0.5;
+        N[1] = 0.5*(1.0 + xi[0]);   dN[1][0] = 0.5;
+    }
+};
+
+/**
+ * @brief quadratic line on [-1,1].  local nodes are the two end points followed by the midpoint.
+ * 3 point gauss rule.
+ */
+template<>
+struct Shape<ElementType::QuadLine>
+{
+    static constexpr int n_nodes = 3;
+    static constexpr int n_ip = 3;
+    static constexpr int dim = 1;
+    static constexpr double xi_ip[n_ip][dim] = { {-0.7745966692414834}, {0.0}, {0.7745966692414834} };
+    static constexpr double wip[n_ip] = { 5.0 / 9.0, 8.0 / 9.0, 5.0 / 9.0 };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        const double x = xi[0];
+        N[0] = 0.5*x*(x - 1.0);     dN[0][0] = x - 0.5;
+        N[1] = 0.5*x*(x + 1.0);     dN[1][0] = x + 0.5;
+        N[2] = 1.0 - x*x;           dN[2][0] = -2.0*x;
+    }
+};
+
+/**
+ * @brief linear triangle on the unit triangle (0,0), (1,0), (0,1).  3 point edge midpoint rule.
+ */
+template<>
+struct Shape<ElementType::LinTri>
+{
+    static constexpr int n_nodes = 3;
+    static constexpr int n_ip = 3;
+    static constexpr int dim = 2;
+    static constexpr double xi_ip[n_ip][dim] = { {0.5, 0.5}, {0.5, 0.0}, {0.0, 0.5} };
+    static constexpr double wip[n_ip] = { 1.0 / 6.0, 1.0 / 6.0, 1.0 / 6.0 };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        N[0] = 1.0 - xi[0] - xi[1];     dN[0][0] = -1.0;    dN[0][1] = -1.0;
+        N[1] = xi[0];                   dN[1][0] =  1.0;    dN[1][1] =  0.0;
+        N[2] = xi[1];                   dN[2][0] =  0.0;    dN[2][1] =  1.0;
+    }
+};
+
+/**
+ * @brief bilinear quadrilateral on [-1,1]^2.  local nodes follow the comsol (tensor product) ordering
+ * (-1,-1), (1,-1), (-1,1), (1,1).  2x2 gauss rule.
+ */
+template<>
+struct Shape<ElementType::LinQuad>
+{
+    static constexpr int n_nodes = 4;
+    static constexpr int n_ip = 4;
+    static constexpr int dim = 2;
+    static constexpr double g = 0.5773502691896257; // 1/sqrt(3)
+    static constexpr double xi_ip[n_ip][dim] = { {-g, -g}, {g, -g}, {-g, g}, {g, g} };
+    static constexpr double wip[n_ip] = { 1.0, 1.0, 1.0, 1.0 };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        // 1D linear lagrange polynomials at -1 and 1 and their derivatives
+        const double l[2][2] = { {0.5*(1.0 - xi[0]), 0.5*(1.0 + xi[0])}, {0.5*(1.0 - xi[1]), 0.5*(1.0 + xi[1])} };
+        const double dl[2] = { -0.5, 0.5 };
+        for (int j = 0; j < 2; j++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                N[2*j + i] = l[0][i]*l[1][j];
+                dN[2*j + i][0] = dl[i]*l[1][j];
+                dN[2*j + i][1] = l[0][i]*dl[j];
+            }
+        }
+    }
+};
+
+/**
+ * @brief quadratic triangle on the unit triangle.  local nodes 0-2 are the vertices (0,0), (1,0),
+ * (0,1) and nodes 3-5 are the midpoints of edges 0-1, 0-2 and 1-2.  6 point degree 4 rule.
+ */
+template<>
+struct Shape<ElementType::QuadTri>
+{
+    static constexpr int n_nodes = 6;
+    static constexpr int n_ip = 6;
+    static constexpr int dim = 2;
+    static constexpr double a = 0.445948490915965;
+    static constexpr double b = 0.091576213509771;
+    static constexpr double xi_ip[n_ip][dim] = {
+                                                    {a, a}, {1.0 - 2.0*a, a}, {a, 1.0 - 2.0*a},
+                                                    {b, b}, {1.0 - 2.0*b, b}, {b, 1.0 - 2.0*b}
+                                               };
+    static constexpr double wa = 0.5*0.223381589678011;
+    static constexpr double wb = 0.5*0.109951743655322;
+    static constexpr double wip[n_ip] = { wa, wa, wa, wb, wb, wb };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        // area coordinates and their derivatives wrt (xi, eta)
+        const double L[3] = { 1.0 - xi[0] - xi[1], xi[0], xi[1] };
+        const double dL[3][2] = { {-1.0, -1.0}, {1.0, 0.0}, {0.0, 1.0} };
+        const int edge[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+        for (int i = 0; i < 3; i++)
+        {
+            N[i] = L[i]*(2.0*L[i] - 1.0);
+            for (int d = 0; d < dim; d++) { dN[i][d] = (4.0*L[i] - 1.0)*dL[i][d]; }
+        }
+        for (int e = 0; e < 3; e++)
+        {
+            const int p = edge[e][0];
+            const int q = edge[e][1];
+            N[3 + e] = 4.0*L[p]*L[q];
+            for (int d = 0; d < dim; d++) { dN[3 + e][d] = 4.0*(dL[p][d]*L[q] + L[p]*dL[q][d]); }
+        }
+    }
+};
+
+/**
+ * @brief biquadratic (9 node lagrange) quadrilateral on [-1,1]^2.  local nodes are ordered
+ * lexicographically over the 3x3 grid {-1,0,1}^2, xi running fastest.  3x3 gauss rule.
+ */
+template<>
+struct Shape<ElementType::QuadQuad>
+{
+    static constexpr int n_nodes = 9;
+    static constexpr int n_ip = 9;
+    static constexpr int dim = 2;
+    static constexpr double g = 0.7745966692414834; // sqrt(3/5)
+    static constexpr double xi_ip[n_ip][dim] = {
+                                                    {-g, -g}, {0.0, -g}, {g, -g},
+                                                    {-g, 0.0}, {0.0, 0.0}, {g, 0.0},
+                                                    {-g, g}, {0.0, g}, {g, g}
+                                               };
+    static constexpr double w0 = 5.0 / 9.0;
+    static constexpr double w1 = 8.0 / 9.0;
+    static constexpr double wip[n_ip] = {
+                                            w0*w0, w1*w0, w0*w0,
+                                            w0*w1, w1*w1, w0*w1,
+                                            w0*w0, w1*w0, w0*w0
+                                        };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        // 1D quadratic lagrange polynomials at -1, 0, 1 and their derivatives
+        double l[2][3] = {};
+        double dl[2][3] = {};
+        for (int d = 0; d < dim; d++)
+        {
+            const double x = xi[d];
+            l[d][0] = 0.5*x*(x - 1.0);  dl[d][0] = x - 0.5;
+            l[d][1] = 1.0 - x*x;        dl[d][1] = -2.0*x;
+            l[d][2] = 0.5*x*(x + 1.0);  dl[d][2] = x + 0.5;
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                N[3*j + i] = l[0][i]*l[1][j];
+                dN[3*j + i][0] = dl[0][i]*l[1][j];
+                dN[3*j + i][1] = l[0][i]*dl[1][j];
+            }
+        }
+    }
+};
+
+/**
+ * @brief linear tetrahedron on the unit tetrahedron.  4 point degree 2 rule.
+ */
+template<>
+struct Shape<ElementType::LinTet>
+{
+    static constexpr int n_nodes = 4;
+    static constexpr int n_ip = 4;
+    static constexpr int dim = 3;
+    static constexpr double a = 0.1381966011250105; // (5 - sqrt(5)) / 20
+    static constexpr double b = 0.5854101966249685; // (5 + 3 sqrt(5)) / 20
+    static constexpr double xi_ip[n_ip][dim] = { {a, a, a}, {a, a, b}, {a, b, a}, {b, a, a} };
+    static constexpr double wip[n_ip] = { 1.0 / 24.0, 1.0 / 24.0, 1.0 / 24.0, 1.0 / 24.0 };
+
+    static constexpr void Eval(const double (&xi)[dim], double (&N)[n_nodes], double (&dN)[n_nodes][dim])
+    {
+        N[0] = 1.0 - xi[0] - xi[1] - xi[2];
+        N[1] = xi[0];
+        N[2] = xi[1];
+        N[3] = xi[2];
+        for (int a = 0; a < n_nodes; a++)
+        {
+            for (int d = 0; d < dim; d++) { dN[a][d] = (a == 0) ? -1.0 : (a == d + 1 ? 1.0 : 0.0); }
+        }
+    }
+};
+
+/**
+ * @brief evaluate the shape functions of an element type at all of its integration points
+ * @tparam T element type
+ * @return BasisTable filled with weights, shape functions and parent domain gradients
+ */
+template<ElementType T>
+constexpr auto Tabulate()
+{
+    typedef Shape<T> S;
+    BasisTable<S::n_nodes, S::n_ip, S::dim> table{};
+    for (int ip = 0; ip < S::n_ip; ip++)
+    {
+        table.wip[ip] = S::wip[ip];
+        S::Eval(S::xi_ip[ip], table.N[ip], table.dN[ip]);
+    }
+    return table;
+}
+
+/**
+ * @brief compile-time tabulated reference basis of an element type.  the accessors return eigen maps
+ * over the static table, so no shape function is ever evaluated while building element matrices.
+ * @tparam T element type
+ */
+template<ElementType T>
+struct RefBasis
+{
+    static constexpr ElementType type = T;              /** @brief element type of the basis */
+    static constexpr int n_nodes = Shape<T>::n_nodes;   /** @brief number of nodes per element */
+    static constexpr int n_ip = Shape<T>::n_ip;         /** @brief number of integration points */
+    static constexpr int dim = Shape<T>::dim;           /** @brief dimension of the parent domain */
+    static constexpr BasisTable<n_nodes, n_ip, dim> table = Tabulate<T>();
+
+    typedef Eigen::Matrix<double, n_nodes, 1> NVector;
+    typedef Eigen::Matrix<double, n_nodes, dim, (dim == 1 ? Eigen::ColMajor : Eigen::RowMajor)> GradNMatrix;
+
+    /** @brief shape functions at integration point ip */
+    static inline Eigen::Map<const NVector> N(const int &ip) { return Eigen::Map<const NVector>(table.N[ip]); }
+
+    /** @brief parent domain shape gradients at integration point ip. row a holds dN_a/dxi */
+    static inline Eigen::Map<const GradNMatrix> dN(const int &ip) { return Eigen::Map<const GradNMatrix>(&table.dN[ip][0][0]); }
+
+    /** @brief integration weight of integration point ip */
+    static inline double w(const int &ip) { return table.wip[ip]; }
+
+    /**
+     * @brief map the parent gradients at integration point ip to the physical domain.  nodes carry 3D
+     * coordinates so that lines and triangles can also be boundary facets of 2D and 3D meshes. the
+     * jacobian is then 3 x dim and its pseudo-inverse (J^T J)^{-1} J^T is used.
+     * @param nodes element node list
+     * @param ip integration point
+     * @param GradNx shape function gradients wrt the physical coordinates. row a holds dN_a/dx
+     * @return the jacobian measure sqrt(det(J^T J)), i.e. |det J| when J is square
+     */
+    template<typename NodeList>
+    static inline double MapGradient(const NodeList &nodes, const int &ip, Eigen::Matrix<double, n_nodes, 3> &GradNx)
+    {
+        // J_{ij} = dx_{i}/dxi_{j} = sum_{a} x_{a,i} dN_{a}/dxi_{j}
+        Eigen::Matrix<double, 3, dim> J = Eigen::Matrix<double, 3, dim>::Zero();
+        for (int a = 0; a < n_nodes; a++)
+        {
+            J.noalias() += nodes[a].coords*dN(ip).row(a);
+        }
+        const Eigen::Matrix<double, dim, dim> JtJ = J.transpose()*J;
+        GradNx.noalias() = dN(ip)*(JtJ.inverse()*J.transpose());
+        return std::sqrt(JtJ.determinant());
+    }
+};
+
+#endif // REF_BASIS_INCL
@@ -1,4 +1,8 @@
 #include "base/model.h"
 #include "elements/linline.h"
+#include "elements/quadline.h"
 #include "elements/lintri.h"
+#include "elements/linquad.h"
+#include "elements/quadtri.h"
+#include "elements/quadquad.h"
 #include "elements/lintet.h"
\ No newline at end of file
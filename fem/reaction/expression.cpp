@@ -0,0 +1,259 @@
+#include "expression.h"
+#include "logger/logger.h"
+
+#include <cctype>
+#include <cmath>
+
+void ExprGraph::SetParameter(const std::string &name, const double &value)
+{
+    params[name] = value;
+}
+
+int ExprGraph::Make(const OpCode &op, const int &a, const int &b, const double &value)
+{
+    // fold constants
+    const bool ca = a >= 0 && op != OpCode::Var && nodes[a].op == OpCode::Const;
+    const bool cb = b >= 0 && nodes[b].op == OpCode::Const;
+    const double va = ca ? nodes[a].value : 0.0;
+    const double vb = cb ? nodes[b].value : 0.0;
+    switch (op)
+    {
+        case OpCode::Add:
+            if (ca && cb) { return Constant(va + vb); }
+            if (IsConstant(a, 0.0)) { return b; }
+            if (IsConstant(b, 0.0)) { return a; }
+            break;
+        case OpCode::Sub:
+            if (ca && cb) { return Constant(va - vb); }
+            if (IsConstant(b, 0.0)) { return a; }
+            if (IsConstant(a, 0.0)) { return Make(OpCode::Neg, b); }
+            if (a == b) { return Constant(0.0); }
+            break;
+        case OpCode::Mul:
+            if (ca && cb) { return Constant(va*vb); }
+            if (IsConstant(a, 0.0) || IsConstant(b, 0.0)) { return Constant(0.0); }
+            if (IsConstant(a, 1.0)) { return b; }
+            if (IsConstant(b, 1.0)) { return a; }
+            break;
+        case OpCode::Div:
+            Assert(!IsConstant(b, 0.0), "division by zero in reaction expression");
+            if (ca && cb) { return Constant(va / vb); }
+            if (IsConstant(a, 0.0)) { return Constant(0.0); }
+            if (IsConstant(b, 1.0)) { return a; }
+            break;
+        case OpCode::Pow:
+            if (ca && cb) { return Constant(std::pow(va, vb)); }
+            if (IsConstant(b, 0.0)) { return Constant(1.0); }
+            if (IsConstant(b, 1.0)) { return a; }
+            break;
+        case OpCode::Neg:
+            if (ca) { return Constant(-va); }
+            if (nodes[a].op == OpCode::Neg) { return nodes[a].a; }
+            break;
+        case OpCode::Exp:
+            if (ca) { return Constant(std::exp(va)); }
+            break;
+        case OpCode::Log:
+            if (ca) { return Constant(std::log(va)); }
+            break;
+        case OpCode::Sqrt:
+            if (ca) { return Constant(std::sqrt(va)); }
+            break;
+        default:
+            break;
+    }
+
+    // commutative operators are stored with their children in a canonical order
+    int first = a;
+    int second = b;
+    if ((op == OpCode::Add || op == OpCode::Mul) && second < first) { std::swap(first, second); }
+
+    const auto key = std::make_tuple(op, first, second, op == OpCode::Const ? value : 0.0);
+    auto it = lookup.find(key);
+    if (it != lookup.end()) { return it->second; }
+    nodes.push_back(ExprNode{op, first, second, op == OpCode::Const ? value : 0.0});
+    const int idx = Size() - 1;
+    lookup[key] = idx;
+    return idx;
+}
+
+int ExprGraph::Diff(const int &node, const int &var)
+{
+    auto it = diff_memo.find(std::make_pair(node, var));
+    if (it != diff_memo.end()) { return it->second; }
+
+    const ExprNode n = nodes[node]; // copy, the pool grows below
+    int d = -1;
+    switch (n.op)
+    {
+        case OpCode::Const:
+            d = Constant(0.0);
+            break;
+        case OpCode::Var:
+            d = Constant(n.a == var ? 1.0 : 0.0);
+            break;
+        case OpCode::Add:
+            d = Make(OpCode::Add, Diff(n.a, var), Diff(n.b, var));
+            break;
+        case OpCode::Sub:
+            d = Make(OpCode::Sub, Diff(n.a, var), Diff(n.b, var));
+            break;
+        case OpCode::Mul: // a'b + ab'
+            d = Make(OpCode::Add, Make(OpCode::Mul, Diff(n.a, var), n.b), Make(OpCode::Mul, n.a, Diff(n.b, var)));
+            break;
+        case OpCode::Div: // a'/b - a b'/b^2
+            d = Make(OpCode::Sub,
+                     Make(OpCode::Div, Diff(n.a, var), n.b),
+                     Make(OpCode::Div, Make(OpCode::Mul, n.a, Diff(n.b, var)), Make(OpCode::Mul, n.b, n.b)));
+            break;
+        case OpCode::Pow:
+            if (nodes[n.b].op == OpCode::Const) // c a^(c-1) a'
+            {
+                const double c = nodes[n.b].value;
+                d = Make(OpCode::Mul, Make(OpCode::Mul, Constant(c), Make(OpCode::Pow, n.a, Constant(c - 1.0))), Diff(n.a, var));
+            }
+            else // a^b (b' log a + b a'/a)
+            {
+                d = Make(OpCode::Mul, node,
+                         Make(OpCode::Add,
+                              Make(OpCode::Mul, Diff(n.b, var), Make(OpCode::Log, n.a)),
+                              Make(OpCode::Div, Make(OpCode::Mul, n.b, Diff(n.a, var)), n.a)));
+            }
+            break;
+        case OpCode::Neg:
+            d = Make(OpCode::Neg, Diff(n.a, var));
+            break;
+        case OpCode::Exp:
+            d = Make(OpCode::Mul, node, Diff(n.a, var));
+            break;
+        case OpCode::Log:
+            d = Make(OpCode::Div, Diff(n.a, var), n.a);
+            break;
+        case OpCode::Sqrt:
+            d = Make(OpCode::Div, Diff(n.a, var), Make(OpCode::Mul, Constant(2.0), node));
+            break;
+        default:
+            FATAL_MSG("unknown expression node");
+            break;
+    }
+    diff_memo[std::make_pair(node, var)] = d;
+    return d;
+}
+
+int ExprGraph::Parse(const std::string &expr)
+{
+    std::size_t pos = 0;
+    int root = ParseSum(expr, pos);
+    SkipSpace(expr, pos);
+    Assert(pos == expr.size(), "unexpected '%c' in reaction expression %s", expr[pos], expr.c_str());
+    return root;
+}
+
+void ExprGraph::SkipSpace(const std::string &s, std::size_t &pos)
+{
+    while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) { pos++; }
+}
+
+int ExprGraph::ParseSum(const std::string &s, std::size_t &pos)
+{
+    int lhs = ParseProduct(s, pos);
+    for (SkipSpace(s, pos); pos < s.size() && (s[pos] == '+' || s[pos] == '-'); SkipSpace(s, pos))
+    {
+        const OpCode op = (s[pos++] == '+') ? OpCode::Add : OpCode::Sub;
+        lhs = Make(op, lhs, ParseProduct(s, pos));
+    }
+    return lhs;
+}
+
+int ExprGraph::ParseProduct(const std::string &s, std::size_t &pos)
+{
+    int lhs = ParseUnary(s, pos);
+    for (SkipSpace(s, pos); pos < s.size() && (s[pos] == '*' || s[pos] == '/'); SkipSpace(s, pos))
+    {
+        const OpCode op = (s[pos++] == '*') ? OpCode::Mul : OpCode::Div;
+        lhs = Make(op, lhs, ParseUnary(s, pos));
+    }
+    return lhs;
+}
+
+int ExprGraph::ParseUnary(const std::string &s, std::size_t &pos)
+{
+    SkipSpace(s, pos);
+    if (pos < s.size() && s[pos] == '-')
+    {
+        pos++;
+        return Make(OpCode::Neg, ParseUnary(s, pos));
+    }
+    if (pos < s.size() && s[pos] == '+')
+    {
+        pos++;
+        return ParseUnary(s, pos);
+    }
+    return ParsePower(s, pos);
+}
+
+int ExprGraph::ParsePower(const std::string &s, std::size_t &pos)
+{
+    int base = ParsePrimary(s, pos);
+    SkipSpace(s, pos);
+    if (pos < s.size() && s[pos] == '^')
+    {
+        pos++;
+        return Make(OpCode::Pow, base, ParseUnary(s, pos)); // right associative
+    }
+    return base;
+}
+
+int ExprGraph::ParsePrimary(const std::string &s, std::size_t &pos)
+{
+    SkipSpace(s, pos);
+    Assert(pos < s.size(), "unexpected end of reaction expression %s", s.c_str());
+
+    if (s[pos] == '(')
+    {
+        pos++;
+        int inner = ParseSum(s, pos);
+        SkipSpace(s, pos);
+        Assert(pos < s.size() && s[pos] == ')', "missing ')' in reaction expression %s", s.c_str());
+        pos++;
+        return inner;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(s[pos])) || s[pos] == '.')
+    {
+        std::size_t len = 0;
+        double value = std::stod(s.substr(pos), &len);
+        pos += len;
+        return Constant(value);
+    }
+
+    std::size_t start = pos;
+    while (pos < s.size() && (std::isalnum(static_cast<unsigned char>(s[pos])) || s[pos] == '_')) { pos++; }
+    const std::string name = s.substr(start, pos - start);
+    Assert(!name.empty(), "unexpected '%c' in reaction expression %s", s[start], s.c_str());
+
+    SkipSpace(s, pos);
+    if (pos < s.size() && s[pos] == '(') // function call
+    {
+        pos++;
+        int arg = ParseSum(s, pos);
+        SkipSpace(s, pos);
+        Assert(pos < s.size() && s[pos] == ')', "missing ')' in reaction expression %s", s.c_str());
+        pos++;
+        if (name == "exp") { return Make(OpCode::Exp, arg); }
+        if (name == "log") { return Make(OpCode::Log, arg); }
+        if (name == "sqrt") { return Make(OpCode::Sqrt, arg); }
+        FATAL("unknown function %s in reaction expression", name.c_str());
+        return Constant(0.0);
+    }
+
+    // species concentration u<index>
+    if (name.size() > 1 && name[0] == 'u' && name.find_first_not_of("0123456789", 1) == std::string::npos)
+    {
+        return Make(OpCode::Var, std::stoi(name.substr(1)));
+    }
+
+    auto it = params.find(name);
+    Assert(it != params.end(), "unknown parameter %s in reaction expression", name.c_str());
+    return Constant(it->second);
+}
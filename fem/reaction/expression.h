@@ -0,0 +1,90 @@
+#ifndef EXPRESSION_INCL
+#define EXPRESSION_INCL
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/** @brief operations of an expression node and of the compiled reaction program */
+typedef enum class OpCode : unsigned char
+{
+    Const, Var,                     // leaves: a constant, or the concentration of species a
+    Add, Sub, Mul, Div, Pow,        // binary operators
+    Neg, Exp, Log, Sqrt             // unary operators
+} OpCode;
+
+/** @brief node of an expression graph.  children always have a smaller index than their parent */
+struct ExprNode
+{
+    OpCode op;      /** @brief operation */
+    int a;          /** @brief first child, or the species index of a Var */
+    int b;          /** @brief second child of binary operators, -1 otherwise */
+    double value;   /** @brief value of a Const */
+};
+
+/**
+ * @brief expression DAG for reaction terms.  nodes are hash-consed, so identical subexpressions of
+ * different reactions and of their derivatives are stored (and later evaluated) once.  constants are
+ * folded and trivial identities (x + 0, x*1, x*0, ...) simplified as nodes are created.
+ */
+class ExprGraph
+{
+    public:
+        ExprGraph() = default;
+
+        /**
+         * @brief set the value of a named parameter that may appear in expressions
+         * @param name parameter name, e.g. k1
+         * @param value parameter value
+         */
+        void SetParameter(const std::string &name, const double &value);
+
+        /**
+         * @brief parse an expression in the species concentrations u0, u1, ... and the parameters.
+         * supports + - * / ^, unary minus, parentheses and the functions exp, log and sqrt.
+         * @param expr expression string, e.g. "k1*u0*u1 - k2*u2"
+         * @return index of the root node
+         */
+        int Parse(const std::string &expr);
+
+        /**
+         * @brief symbolic derivative of a node with respect to the concentration of a species
+         * @param node node to differentiate
+         * @param var species index
+         * @return index of the derivative node
+         */
+        int Diff(const int &node, const int &var);
+
+        /** @brief create (or find) a node, simplifying it where possible */
+        int Make(const OpCode &op, const int &a, const int &b = -1, const double &value = 0.0);
+
+        /** @brief create (or find) a constant node */
+        inline int Constant(const double &value) { return Make(OpCode::Const, -1, -1, value); }
+
+        /** @brief true if the node is the constant value */
+        inline bool IsConstant(const int &node, const double &value) const
+        {
+            return nodes[node].op == OpCode::Const && nodes[node].value == value;
+        }
+
+        inline const ExprNode& Node(const int &idx) const { return nodes[idx]; }
+        inline int Size() const { return static_cast<int>(nodes.size()); }
+
+    private:
+        // recursive descent parser.  pos is the read position in the expression being parsed
+        int ParseSum(const std::string &s, std::size_t &pos);
+        int ParseProduct(const std::string &s, std::size_t &pos);
+        int ParseUnary(const std::string &s, std::size_t &pos);
+        int ParsePower(const std::string &s, std::size_t &pos);
+        int ParsePrimary(const std::string &s, std::size_t &pos);
+        void SkipSpace(const std::string &s, std::size_t &pos);
+
+    private:
+        std::vector<ExprNode> nodes;                                /** @brief node pool in topological order */
+        std::map<std::tuple<OpCode, int, int, double>, int> lookup; /** @brief hash-consing table */
+        std::map<std::pair<int, int>, int> diff_memo;               /** @brief (node, var) -> derivative */
+        std::map<std::string, double> params;                       /** @brief named parameters */
+};
+
+#endif // EXPRESSION_INCL
@@ -0,0 +1,146 @@
+#include "integrator.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+
+ReactionIntegrator::ReactionIntegrator(const double &tol, const int &max_iters, const int &max_halvings)
+: tol{tol}, max_iters{max_iters}, max_halvings{max_halvings}, pivot_tol{1e-12}, iterations{0}, split_blocks{0}
+{
+
+}
+
+void ReactionIntegrator::Step(const ReactionSystem &reactions, const double *u, const int &n_nodes, const double &dt, double *v)
+{
+    switch (reactions.NumSpecies())
+    {
+        case 1: StepBlocks<1>(reactions, u, n_nodes, dt, v); break;
+        case 2: StepBlocks<2>(reactions, u, n_nodes, dt, v); break;
+        case 3: StepBlocks<3>(reactions, u, n_nodes, dt, v); break;
+        case 4: StepBlocks<4>(reactions, u, n_nodes, dt, v); break;
+        case 5: StepBlocks<5>(reactions, u, n_nodes, dt, v); break;
+        case 6: StepBlocks<6>(reactions, u, n_nodes, dt, v); break;
+        default: StepBlocks<Eigen::Dynamic>(reactions, u, n_nodes, dt, v); break;
+    }
+    static_assert(max_fixed_species == 6, "the dispatch above covers the fixed size kernels");
+}
+
+template<int S>
+void ReactionIntegrator::StepBlocks(const ReactionSystem &reactions, const double *u, const int &n_nodes, const double &dt, double *v)
+{
+    const int n = reactions.NumSpecies();
+    int max_it = 0;
+    int n_split = 0;
+    int n_failed = 0;
+    #pragma omp parallel reduction(max:max_it) reduction(+:n_split, n_failed)
+    {
+        std::vector<ReactionSystem::Lanes> regs = reactions.Registers();
+        Species<S> U(BLOCK, n), V(BLOCK, n), W(BLOCK, n);
+
+        #pragma omp for schedule(static)
+        for (int first = 0; first < n_nodes; first += BLOCK)
+        {
+            // a partial last block repeats its last node in the unused lanes, so every lane is a valid state
+            const int w = std::min(BLOCK, n_nodes - first);
+            for (int s = 0; s < n; s++)
+            {
+                U.col(s).head(w) = Eigen::Map<const Eigen::ArrayXd>(u + static_cast<std::size_t>(s)*n_nodes + first, w);
+                U.col(s).tail(BLOCK - w).setConstant(U(w - 1, s));
+            }
+
+            // 1, 2, 4, ... substeps until every one of them converges.  V only takes converged iterates, so a
+            // block failing with the finest split keeps the values after its converged substeps
+            bool converged = false;
+            for (int halving = 0; halving <= max_halvings && !converged; halving++)
+            {
+                const int n_sub = 1 << halving;
+                V = U;
+                converged = true;
+                for (int k = 0; k < n_sub && converged; k++)
+                {
+                    const int it = Newton<S>(reactions, regs, V, dt / n_sub, W);
+                    converged = it >= 0;
+                    max_it = std::max(max_it, it);
+                    if (converged) { V = W; }
+                }
+                if (halving == 1) { n_split++; }
+            }
+            if (!converged) { n_failed += w; }
+
+            for (int s = 0; s < n; s++)
+            {
+                Eigen::Map<Eigen::ArrayXd>(v + static_cast<std::size_t>(s)*n_nodes + first, w) = V.col(s).head(w);
+            }
+        }
+    }
+    iterations = max_it;
+    split_blocks = n_split;
+    if (n_failed > 0)
+    {
+        WARN("implicit reaction step did not converge at %d nodes with %d substeps, they keep their converged substeps",
+             n_failed, 1 << max_halvings);
+    }
+}
+
+template<int S>
+int ReactionIntegrator::Newton(const ReactionSystem &reactions, std::vector<ReactionSystem::Lanes> &regs, const Species<S> &U,
+                               const double &dt, Species<S> &V) const
+{
+    constexpr int SS = (S == Eigen::Dynamic) ? Eigen::Dynamic : S*S;
+    const int n = static_cast<int>(U.cols());
+    const auto &pattern = reactions.JacobianPattern();
+    Species<S> R(BLOCK, n), F(BLOCK, n);
+    Eigen::Array<double, BLOCK, Eigen::Dynamic> J(BLOCK, pattern.size());
+    Eigen::Array<double, BLOCK, SS> A(BLOCK, n*n);
+
+    V = U;
+    for (int it = 1; it <= max_iters; it++)
+    {
+        reactions.EvaluateBlock(regs, V.data(), BLOCK, BLOCK, R.data(), J.data());
+        F = V - U - dt*R;
+        // jacobian of the residual, I - dt dR/du
+        A.setZero();
+        for (int r = 0; r < n; r++) { A.col(r*n + r).setOnes(); }
+        for (std::size_t k = 0; k < pattern.size(); k++)
+        {
+            const auto [r, s] = pattern[k];
+            A.col(r*n + s) -= dt*J.col(k);
+        }
+        if (!Factorize<S>(A, n)) { return -1; }
+        SolveFactorized<S>(A, n, F);
+        V -= F;
+        if (!V.allFinite()) { return -1; }
+        if ((F.abs() <= tol*(1.0 + V.abs())).all()) { return it; }
+    }
+    return -1;
+}
+
+template<int S, typename Matrix>
+bool ReactionIntegrator::Factorize(Matrix &A, const int &n) const
+{
+    // doolittle, every operation is on the lanes of one entry
+    for (int k = 0; k < n; k++)
+    {
+        if ((A.col(k*n + k).abs() < pivot_tol).any()) { return false; }
+        const ReactionSystem::Lanes inv = A.col(k*n + k).inverse();
+        for (int i = k + 1; i < n; i++)
+        {
+            A.col(i*n + k) *= inv;
+            for (int j = k + 1; j < n; j++) { A.col(i*n + j) -= A.col(i*n + k)*A.col(k*n + j); }
+        }
+    }
+    return true;
+}
+
+template<int S, typename Matrix>
+void ReactionIntegrator::SolveFactorized(const Matrix &A, const int &n, Species<S> &F) const
+{
+    for (int i = 1; i < n; i++)
+    {
+        for (int j = 0; j < i; j++) { F.col(i) -= A.col(i*n + j)*F.col(j); }
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        for (int j = i + 1; j < n; j++) { F.col(i) -= A.col(i*n + j)*F.col(j); }
+        F.col(i) /= A.col(i*n + i);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef INTEGRATOR_INCL
+#define INTEGRATOR_INCL
+
+#include "reaction.h"
+
+#include <eigen/Eigen/Core>
+
+#include <vector>
+
+/**
+ * @brief pointwise implicit integration of stiff reactions, du/dt = R(u) at every node on its own.  a
+ * backward euler step v = u + dt R(v) is solved by newton's method on the S x S systems (I - dt J(v)) d = F
+ * of the nodes.  nodes are processed in blocks of ReactionSystem::BLOCK with one node per lane: the
+ * residual, the jacobian entries and every entry of the LU factors are lane arrays, so the factorization
+ * and the triangular solves of a block are vector arithmetic over its nodes.  the kernels are templates on
+ * the species count with eigen fixed size arrays up to max_fixed_species.  the LU is not pivoted, I - dt J
+ * tends to the identity for small steps, so a block with a small pivot or a failed newton iteration is
+ * retried with its step split into substeps.  a block still failing with the finest split is advanced by
+ * its converged substeps only, a diverged iterate is never written.
+ */
+class ReactionIntegrator
+{
+    public:
+        static constexpr int BLOCK = ReactionSystem::BLOCK;  /** @brief nodes per block, one per lane */
+        static constexpr int max_fixed_species = 6;         /** @brief largest species count with fixed size kernels */
+
+        /**
+         * @param tol newton tolerance on the update relative to 1 + |v|
+         * @param max_iters maximum newton iterations of a step
+         * @param max_halvings maximum number of times the step of a block is split in two
+         */
+        ReactionIntegrator(const double &tol = 1e-10, const int &max_iters = 30, const int &max_halvings = 8);
+
+        /**
+         * @brief one backward euler step of the reactions at every node
+         * @param reactions compiled reaction system
+         * @param u species values at the start of the step in SoA layout, n_nodes values per species
+         * @param n_nodes number of nodes
+         * @param dt step size
+         * @param v species values at the end of the step, same layout as u and not aliasing it
+         */
+        void Step(const ReactionSystem &reactions, const double *u, const int &n_nodes, const double &dt, double *v);
+
+        /** @brief largest number of newton iterations of a step of a block in the last Step */
+        inline int Iterations() const { return iterations; }
+
+        /** @brief blocks of the last Step that were split into substeps */
+        inline int SplitBlocks() const { return split_blocks; }
+
+    private:
+        /** @brief species values of a block, one column per species */
+        template<int S>
+        using Species = Eigen::Array<double, BLOCK, S>;
+
+        /** @brief Step with the kernels for S species, Eigen::Dynamic for any count */
+        template<int S>
+        void StepBlocks(const ReactionSystem &reactions, const double *u, const int &n_nodes, const double &dt, double *v);
+
+        /**
+         * @brief newton iteration of one backward euler step of a block
+         * @return number of iterations, -1 if it failed
+         */
+        template<int S>
+        int Newton(const ReactionSystem &reactions, std::vector<ReactionSystem::Lanes> &regs, const Species<S> &U,
+                   const double &dt, Species<S> &V) const;
+
+        /**
+         * @brief LU factorization in place of the n x n matrices of a block, entry (r, s) in column r*n + s
+         * @return false if a pivot is too small
+         */
+        template<int S, typename Matrix>
+        bool Factorize(Matrix &A, const int &n) const;
+
+        /** @brief overwrite F with the solution of the factorized systems */
+        template<int S, typename Matrix>
+        void SolveFactorized(const Matrix &A, const int &n, Species<S> &F) const;
+
+    private:
+        double tol;         /** @brief newton tolerance */
+        int max_iters;      /** @brief maximum newton iterations of a step */
+        int max_halvings;   /** @brief maximum splittings of the step of a block */
+        double pivot_tol;   /** @brief smallest pivot magnitude accepted by the LU */
+        int iterations;     /** @brief largest newton iteration count of the last Step */
+        int split_blocks;   /** @brief blocks split into substeps in the last Step */
+};
+
+#endif // INTEGRATOR_INCL
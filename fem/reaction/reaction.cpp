@@ -0,0 +1,143 @@
+#include "reaction.h"
+#include "logger/logger.h"
+
+#include <algorithm>
+
+void ReactionSystem::SetParameter(const std::string &name, const double &value)
+{
+    graph.SetParameter(name, value);
+}
+
+void ReactionSystem::SetReaction(const int &species, const std::string &expr)
+{
+    exprs.emplace_back(species, expr);
+}
+
+void ReactionSystem::Compile(const int &n_species)
+{
+    this->n_species = n_species;
+
+    // reaction roots and the structurally nonzero derivatives
+    std::vector<int> roots(n_species, -1);
+    for (const auto &[species, expr] : exprs)
+    {
+        Assert(species < n_species, "reaction given for species %d of %d", species, n_species);
+        roots[species] = graph.Parse(expr);
+    }
+    jac_pattern.clear();
+    std::vector<int> jac_roots;
+    for (int r = 0; r < n_species; r++)
+    {
+        if (roots[r] < 0) { continue; }
+        for (int s = 0; s < n_species; s++)
+        {
+            int d = graph.Diff(roots[r], s);
+            if (graph.IsConstant(d, 0.0)) { continue; }
+            jac_pattern.emplace_back(r, s);
+            jac_roots.push_back(d);
+        }
+    }
+
+    // mark the nodes reachable from the outputs. children have smaller indices than their parents,
+    // so a reverse sweep finds them and a forward sweep over the marked nodes is a valid schedule
+    std::vector<char> live(graph.Size(), 0);
+    for (int root : roots) { if (root >= 0) { live[root] = 1; } }
+    for (int root : jac_roots) { live[root] = 1; }
+    for (int n = graph.Size() - 1; n >= 0; n--)
+    {
+        if (!live[n]) { continue; }
+        const ExprNode &node = graph.Node(n);
+        if (node.op == OpCode::Const || node.op == OpCode::Var) { continue; }
+        live[node.a] = 1;
+        if (node.b >= 0) { live[node.b] = 1; }
+    }
+
+    std::vector<int> reg(graph.Size(), -1);
+    program.clear();
+    consts.clear();
+    n_regs = 0;
+    for (int n = 0; n < graph.Size(); n++)
+    {
+        if (!live[n]) { continue; }
+        const ExprNode &node = graph.Node(n);
+        reg[n] = n_regs++;
+        if (node.op == OpCode::Const)
+        {
+            consts.emplace_back(reg[n], node.value);
+        }
+        else if (node.op == OpCode::Var)
+        {
+            Assert(node.a < n_species, "u%d used in a reaction, but there are %d species", node.a, n_species);
+            program.push_back(Instr{node.op, reg[n], node.a, -1});
+        }
+        else
+        {
+            program.push_back(Instr{node.op, reg[n], reg[node.a], node.b >= 0 ? reg[node.b] : -1});
+        }
+    }
+    r_reg.assign(n_species, -1);
+    for (int s = 0; s < n_species; s++) { if (roots[s] >= 0) { r_reg[s] = reg[roots[s]]; } }
+    j_reg.resize(jac_roots.size());
+    for (std::size_t k = 0; k < jac_roots.size(); k++) { j_reg[k] = reg[jac_roots[k]]; }
+
+    INFO("compiled %d reactions: %d instructions, %d registers, %d jacobian entries",
+         static_cast<int>(exprs.size()), static_cast<int>(program.size()), n_regs, static_cast<int>(jac_pattern.size()));
+}
+
+std::vector<ReactionSystem::Lanes> ReactionSystem::Registers() const
+{
+    std::vector<Lanes> regs(n_regs);
+    for (const auto &[r, value] : consts) { regs[r].setConstant(value); }
+    return regs;
+}
+
+void ReactionSystem::Evaluate(const double *u, const int &n_nodes, double *R, double *J) const
+{
+    #pragma omp parallel
+    {
+        std::vector<Lanes> regs = Registers();
+
+        #pragma omp for schedule(static)
+        for (int first = 0; first < n_nodes; first += BLOCK)
+        {
+            EvaluateBlock(regs, u + first, n_nodes, std::min(BLOCK, n_nodes - first), R + first, J ? J + first : nullptr);
+        }
+    }
+}
+
+void ReactionSystem::EvaluateBlock(std::vector<Lanes> &regs, const double *u, const std::size_t &stride, const int &w,
+                                   double *R, double *J) const
+{
+    for (const Instr &in : program)
+    {
+        Lanes &d = regs[in.dst];
+        switch (in.op)
+        {
+            case OpCode::Var:
+                if (w < BLOCK) { d.setOnes(); } // keep the unused lanes finite
+                d.head(w) = Eigen::Map<const Eigen::ArrayXd>(u + in.a*stride, w);
+                break;
+            case OpCode::Add:   d = regs[in.a] + regs[in.b];            break;
+            case OpCode::Sub:   d = regs[in.a] - regs[in.b];            break;
+            case OpCode::Mul:   d = regs[in.a]*regs[in.b];              break;
+            case OpCode::Div:   d = regs[in.a] / regs[in.b];            break;
+            case OpCode::Pow:   d = regs[in.a].pow(regs[in.b]);         break;
+            case OpCode::Neg:   d = -regs[in.a];                        break;
+            case OpCode::Exp:   d = regs[in.a].exp();                   break;
+            case OpCode::Log:   d = regs[in.a].log();                   break;
+            case OpCode::Sqrt:  d = regs[in.a].sqrt();                  break;
+            default:                                                    break;
+        }
+    }
+    for (int s = 0; s < n_species; s++)
+    {
+        Eigen::Map<Eigen::ArrayXd> out(R + s*stride, w);
+        if (r_reg[s] < 0) { out.setZero(); }
+        else { out = regs[r_reg[s]].head(w); }
+    }
+    if (J == nullptr) { return; }
+    for (std::size_t k = 0; k < j_reg.size(); k++)
+    {
+        Eigen::Map<Eigen::ArrayXd>(J + k*stride, w) = regs[j_reg[k]].head(w);
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef REACTION_INCL
+#define REACTION_INCL
+
+#include "expression.h"
+
+#include <eigen/Eigen/Core>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief reaction terms R_s(u) read from the condition file and compiled to a register program.
+ * the reactions and their analytic jacobian entries dR_r/du_s (found by symbolic differentiation)
+ * share one expression DAG and are lowered together, so common subexpressions are evaluated once.
+ * the program is run over blocks of nodes: every register holds the values of BLOCK consecutive
+ * nodes, so the instruction dispatch is paid once per block and the arithmetic is on contiguous
+ * fixed size arrays that the compiler vectorizes (avx with the build flags).  species values are
+ * read and written in SoA layout, i.e. species s of node i at [s*n_nodes + i], which is the layout
+ * of the model solution vector.
+ */
+class ReactionSystem
+{
+    public:
+        static constexpr int BLOCK = 32;                /** @brief nodes evaluated per register */
+        typedef Eigen::Array<double, BLOCK, 1> Lanes;   /** @brief one register */
+
+    public:
+        ReactionSystem() = default;
+
+        /** @brief set a named parameter, e.g. "k1", used by the reaction expressions */
+        void SetParameter(const std::string &name, const double &value);
+
+        /**
+         * @brief set the reaction term of a species
+         * @param species species index
+         * @param expr expression in u0, u1, ... and the parameters
+         */
+        void SetReaction(const int &species, const std::string &expr);
+
+        /**
+         * @brief parse the reactions, differentiate them and lower everything to the register program
+         * @param n_species number of species
+         */
+        void Compile(const int &n_species);
+
+        /**
+         * @brief evaluate the reaction terms and optionally their jacobian at a range of nodes
+         * @param u species values in SoA layout, n_nodes values per species
+         * @param n_nodes number of nodes
+         * @param R reaction terms in SoA layout, n_nodes values per species
+         * @param J jacobian entries in SoA layout, n_nodes values per entry of JacobianPattern. may be null
+         */
+        void Evaluate(const double *u, const int &n_nodes, double *R, double *J = nullptr) const;
+
+        /** @brief registers of the program for one thread, with the constants set */
+        std::vector<Lanes> Registers() const;
+
+        /**
+         * @brief evaluate the reaction terms and optionally their jacobian at up to BLOCK nodes, e.g. the
+         * iterates of a pointwise newton solve
+         * @param regs registers from Registers
+         * @param u species values, species s of node i at u[s*stride + i]
+         * @param stride distance between the values of consecutive species
+         * @param w number of nodes, at most BLOCK
+         * @param R reaction terms in the layout of u
+         * @param J jacobian entries, entry k of JacobianPattern of node i at J[k*stride + i]. may be null
+         */
+        void EvaluateBlock(std::vector<Lanes> &regs, const double *u, const std::size_t &stride, const int &w,
+                           double *R, double *J = nullptr) const;
+
+        /** @brief (reaction, species) of each structurally nonzero jacobian entry */
+        inline const std::vector<std::pair<int, int>>& JacobianPattern() const { return jac_pattern; }
+
+        /** @brief true if no species has a reaction term */
+        inline bool Empty() const { return exprs.empty(); }
+
+        /** @brief number of species the system was compiled for */
+        inline int NumSpecies() const { return n_species; }
+
+    private:
+        /** @brief one instruction: dst = op(a, b).  Var reads species a, Const registers are set once */
+        struct Instr
+        {
+            OpCode op;
+            int dst;
+            int a;
+            int b;
+        };
+
+    private:
+        int n_species = 0;                              /** @brief number of species */
+        ExprGraph graph;                                /** @brief expression DAG of reactions and derivatives */
+        std::vector<std::pair<int, std::string>> exprs; /** @brief (species, expression) as read */
+        std::vector<std::pair<int, int>> jac_pattern;   /** @brief nonzero jacobian entries */
+        std::vector<Instr> program;                     /** @brief instructions run per block */
+        std::vector<std::pair<int, double>> consts;     /** @brief (register, value) set before the block loop */
+        std::vector<int> r_reg;                         /** @brief register of each reaction term, -1 for none */
+        std::vector<int> j_reg;                         /** @brief register of each jacobian entry */
+        int n_regs = 0;                                 /** @brief number of registers */
+};
+
+#endif // REACTION_INCL
@@ -0,0 +1,130 @@
+#include <fem/fem.h>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <random>
+
+/** @brief true if a and b have the same size and the same bits */
+bool BitExact(const Eigen::VectorXd &a, const Eigen::VectorXd &b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()*sizeof(double)) == 0;
+}
+
+/**
+ * @brief solution of a step: smooth in time, so every order of prediction is used, with nans of several
+ * payloads, signed zeros, infinities and denormals among the values
+ */
+Eigen::VectorXd Snapshot(const int &step, const int &n_nodes, const int &n_species, std::mt19937_64 &rng)
+{
+    Eigen::VectorXd u(n_nodes*n_species);
+    for (int s = 0; s < n_species; s++)
+    {
+        for (int i = 0; i < n_nodes; i++) { u(s*n_nodes + i) = (s + 1)*std::sin(0.05*step + 0.1*i) + 1e-3*step*step; }
+    }
+    const double nan_payload = [] { double v; const std::uint64_t b = 0x7ff80000deadbeef; std::memcpy(&v, &b, 8); return v; }();
+    const double specials[] = {std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN(), nan_payload,
+                               0.0, -0.0, std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::denorm_min(),
+                               std::numeric_limits<double>::min() / 3.0, std::numeric_limits<double>::infinity(),
+                               -std::numeric_limits<double>::infinity()};
+    // fixed places keep their kind of value from step to step, random ones change it
+    for (int k = 0; k < 10; k++) { u(3*k) = specials[k]; }
+    std::uniform_int_distribution<int> pick(0, 9);
+    std::uniform_int_distribution<Eigen::Index> place(0, u.size() - 1);
+    for (int k = 0; k < 8; k++) { u(place(rng)) = specials[pick(rng)]; }
+    std::uniform_int_distribution<std::uint64_t> mantissa(1, (std::uint64_t(1) << 52) - 1);
+    for (int k = 0; k < 4; k++)
+    {
+        const std::uint64_t b = mantissa(rng);
+        std::memcpy(u.data() + place(rng), &b, 8);
+    }
+    return u;
+}
+
+/** @brief number of frames of the reader that do not read back bit exact, visited in the order given */
+int Compare(HistoryReader &reader, const std::vector<Eigen::VectorXd> &written, const std::vector<int> &order)
+{
+    int n_wrong = 0;
+    Eigen::VectorXd u;
+    for (const int &i : order)
+    {
+        reader.Read(i, u);
+        n_wrong += !BitExact(u, written[i]);
+    }
+    return n_wrong;
+}
+
+int main()
+{
+    const std::string file_name("history.bin");
+    const int keyframe_interval = 5;
+    const int n_species = 2;
+    std::mt19937_64 rng(7);
+
+    // 40 steps, every second one stored, with the mesh refined at step 24: the number of nodes changes
+    std::vector<Eigen::VectorXd> written;
+    std::vector<int> steps;
+    {
+        HistoryWriter writer;
+        writer.Open(file_name, keyframe_interval);
+        for (int step = 0; step < 40; step += 2)
+        {
+            const int n_nodes = step < 24 ? 300 : 437;
+            written.push_back(Snapshot(step, n_nodes, n_species, rng));
+            steps.push_back(step);
+            writer.Append(step, 0.1*step, written.back(), n_nodes, n_species);
+        }
+        writer.Close();
+    }
+    const int n_frames = static_cast<int>(written.size());
+
+    HistoryReader reader;
+    int n_failed = 0;
+    auto check = [&n_failed](const bool &ok, const std::string &what)
+    {
+        n_failed += !ok;
+        std::cout << what << ": " << (ok ? "passed" : "FAILED") << "\n";
+    };
+    check(reader.Open(file_name) && reader.NumFrames() == n_frames, "closed file opened with all frames");
+    bool headers = true;
+    int n_keyframes = 0;
+    for (int i = 0; i < reader.NumFrames(); i++)
+    {
+        headers = headers && reader.Frame(i).step == steps[i] && reader.Find(steps[i]) == i;
+        headers = headers && reader.Frame(i).n_nodes*reader.Frame(i).n_species == written[i].size();
+        n_keyframes += reader.Frame(i).order == 0;
+    }
+    check(headers && reader.Find(1) == -1 && reader.Find(100) == -1, "frame headers and step lookup");
+    check(n_keyframes > n_frames / keyframe_interval && reader.Frame(12).order == 0, "keyframes, and one where the mesh changes");
+
+    std::vector<int> forward(n_frames);
+    for (int i = 0; i < n_frames; i++) { forward[i] = i; }
+    std::vector<int> backward(forward.rbegin(), forward.rend());
+    std::vector<int> shuffled(forward);
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    // the same frame twice, back to a keyframe, across a keyframe and the length change, and the last frame
+    const std::vector<int> jumps{9, 9, 4, 5, 3, 11, 12, 13, 0, n_frames - 1, 10, 16};
+    check(Compare(reader, written, forward) == 0, "frames read in order");
+    check(Compare(reader, written, backward) == 0, "frames read in reverse");
+    check(Compare(reader, written, shuffled) == 0, "frames read in random order");
+    check(Compare(reader, written, jumps) == 0, "frames read across keyframes");
+
+    // a writer that never closed its file leaves the frames without the index, the last one possibly cut
+    std::uint64_t end_of_frames = sizeof(std::uint64_t);
+    for (int i = 0; i < n_frames; i++) { end_of_frames += sizeof(HistoryFrame) + reader.Frame(i).n_bytes; }
+    const std::string unclosed("history_unclosed.bin");
+    std::filesystem::copy_file(file_name, unclosed, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(unclosed, end_of_frames);
+    HistoryReader unclosed_reader;
+    check(unclosed_reader.Open(unclosed) && unclosed_reader.NumFrames() == n_frames
+          && Compare(unclosed_reader, written, shuffled) == 0, "file that was not closed");
+    std::filesystem::resize_file(unclosed, end_of_frames - 5);
+    check(unclosed_reader.Open(unclosed) && unclosed_reader.NumFrames() == n_frames - 1
+          && Compare(unclosed_reader, written, std::vector<int>(backward.begin() + 1, backward.end())) == 0,
+          "file that was not closed, its last frame cut");
+
+    std::filesystem::remove(file_name);
+    std::filesystem::remove(unclosed);
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#include <fem/fem.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+/** @brief value j of the solution published at a step, exact in double, so a torn copy mixes values of two steps */
+inline double Value(const int &step, const int &j)
+{
+    return 1e6*step + j;
+}
+
+/** @brief true if every field of a snapshot belongs to the same publication */
+bool Consistent(const MonitorSnapshot &snapshot, const int &n_species)
+{
+    const int step = snapshot.step;
+    bool same = snapshot.count == static_cast<std::uint64_t>(step) + 1 && snapshot.time == 0.5*step;
+    same = same && snapshot.n_species == n_species && snapshot.u.size() == static_cast<Eigen::Index>(snapshot.n_nodes)*n_species;
+    for (Eigen::Index j = 0; same && j < snapshot.u.size(); j++) { same = snapshot.u(j) == Value(step, static_cast<int>(j)); }
+    return same;
+}
+
+int main()
+{
+    const std::string file_name("monitor.bin");
+    const int n_species = 2;
+    // the solution grows twice while the reader runs, so the slots grow and move under it
+    const int sizes[] = {500, 3000, 20000};
+    const int n_sizes = 3;
+    const int min_publications = 2000;
+    const int min_accepted = 200;
+
+    MonitorPublisher publisher;
+    publisher.Open(file_name, 4);
+    MonitorReader reader;
+    if (!reader.Open(file_name))
+    {
+        std::cout << "could not open the monitor file for reading\n";
+        return 1;
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<int> accepted_size[n_sizes] = {0, 0, 0};
+    std::uint64_t n_accepted = 0, n_failed_reads = 0, n_inconsistent = 0, n_backwards = 0;
+    std::thread read_thread([&]
+    {
+        MonitorSnapshot snapshot;
+        std::uint64_t last_count = 0;
+        while (!done.load(std::memory_order_acquire))
+        {
+            if (!reader.Read(snapshot, 10))
+            {
+                n_failed_reads++;
+                continue;
+            }
+            n_accepted++;
+            n_inconsistent += !Consistent(snapshot, n_species);
+            n_backwards += snapshot.count < last_count;
+            last_count = snapshot.count;
+            for (int k = 0; k < n_sizes; k++) { accepted_size[k] += snapshot.n_nodes == sizes[k]; }
+        }
+    });
+
+    // every size is published until the reader has accepted enough snapshots of it
+    int step = 0;
+    for (int k = 0; k < n_sizes; k++)
+    {
+        Eigen::VectorXd u(sizes[k]*n_species);
+        for (int n = 0; n < min_publications || accepted_size[k].load() < min_accepted; n++, step++)
+        {
+            for (Eigen::Index j = 0; j < u.size(); j++) { u(j) = Value(step, static_cast<int>(j)); }
+            publisher.Publish(step, 0.5*step, u, sizes[k], n_species);
+        }
+    }
+    done.store(true, std::memory_order_release);
+    read_thread.join();
+
+    const bool passed = n_inconsistent == 0 && n_backwards == 0 && reader.Count() == static_cast<std::uint64_t>(step);
+    std::cout << step << " solutions published in " << n_sizes << " sizes, " << n_accepted << " snapshots accepted ("
+              << accepted_size[0] << ", " << accepted_size[1] << ", " << accepted_size[2] << " per size), " << n_failed_reads
+              << " reads given up, " << n_inconsistent << " inconsistent, " << n_backwards << " older than the one before: "
+              << (passed ? "passed" : "FAILED") << "\n";
+    reader.Close();
+    publisher.Close();
+    std::remove(file_name.c_str());
+    return passed ? 0 : 1;
+}
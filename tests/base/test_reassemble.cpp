@@ -0,0 +1,119 @@
+#include <fem/fem.h>
+
+#include <sstream>
+
+/** @brief stiffness weighted by the coefficient of every element, summed element by element from the cached element matrices */
+SparseMatrix Weighted(Mesh &mesh, const std::vector<double> &coef)
+{
+    auto &tris = mesh.Block<LinTri>();
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int e = 0; e < tris.Size(); e++)
+    {
+        for (int i = 0; i < tris.NPE(); i++)
+        {
+            for (int j = 0; j < tris.NPE(); j++)
+            {
+                entries.emplace_back(tris.elems[e].Nodes(i).node_id, tris.elems[e].Nodes(j).node_id, coef[e]*tris.elems[e].k(i,j));
+            }
+        }
+    }
+    SparseMatrix A(mesh.NumNodes(), mesh.NumNodes());
+    A.setFromTriplets(entries.begin(), entries.end());
+    return A;
+}
+
+/** @brief D(u_e) of every element, u_e the mean of u over its nodes */
+std::vector<double> Coefficients(Mesh &mesh, const Diffusivity &D, const Eigen::VectorXd &u)
+{
+    auto &tris = mesh.Block<LinTri>();
+    std::vector<double> coef(tris.Size());
+    for (int e = 0; e < tris.Size(); e++)
+    {
+        double u_e = 0.0;
+        for (int i = 0; i < tris.NPE(); i++) { u_e += u(tris.elems[e].Nodes(i).node_id); }
+        coef[e] = D(u_e / tris.NPE());
+    }
+    return coef;
+}
+
+/** @brief largest entry of Ks - Kref relative to the largest of Kref */
+double MaxDiff(const SparseMatrix &Ks, const SparseMatrix &Kref)
+{
+    const SparseMatrix diff = Ks - Kref;
+    return Eigen::Map<const Eigen::VectorXd>(diff.valuePtr(), diff.nonZeros()).cwiseAbs().maxCoeff()
+         / Eigen::Map<const Eigen::VectorXd>(Kref.valuePtr(), Kref.nonZeros()).cwiseAbs().maxCoeff();
+}
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    for (int r = 0; r < 2; r++) { mesh.RefineUniform(); }
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+
+    const int n = mesh.NumNodes();
+    const int n_elems = mesh.Block<LinTri>().Size();
+    const Diffusivity D{2.0, 0.8};
+    Eigen::VectorXd u(n);
+    for (int i = 0; i < n; i++) { u(i) = 1.0 + 0.5*std::sin(0.05*mesh.Nodes(i).Coords(0))*std::cos(0.03*mesh.Nodes(i).Coords(1)); }
+    int n_failed = 0;
+    auto check = [&n_failed](const bool &ok, const std::string &what)
+    {
+        n_failed += !ok;
+        std::cout << what << ": " << (ok ? "passed" : "FAILED") << "\n";
+    };
+    auto sci = [](const double &v) { std::ostringstream oss; oss << v; return oss.str(); };
+
+    // from scratch every element is dirty
+    SparseMatrix Ks;
+    std::vector<double> coef;
+    int n_dirty = assembler.Reassemble(mesh, D, u, Ks, coef, 0.0);
+    double diff = MaxDiff(Ks, Weighted(mesh, Coefficients(mesh, D, u)));
+    check(n_dirty == n_elems && diff <= 1e-14, "full assembly, " + std::to_string(n_dirty) + " dirty elements, difference " + sci(diff));
+
+    // u raised on the right of the circle: the elements with a node there are dirty, the others keep their contribution
+    std::vector<char> moved(n, 0);
+    for (int i = 0; i < n; i++)
+    {
+        if (mesh.Nodes(i).Coords(0) > 30.0)
+        {
+            u(i) += 0.3 + 0.1*std::cos(0.1*mesh.Nodes(i).Coords(1));
+            moved[i] = 1;
+        }
+    }
+    auto &tris = mesh.Block<LinTri>();
+    int n_touched = 0;
+    for (int e = 0; e < n_elems; e++)
+    {
+        bool touched = false;
+        for (int i = 0; i < tris.NPE(); i++) { touched = touched || moved[tris.elems[e].Nodes(i).node_id]; }
+        n_touched += touched;
+    }
+    n_dirty = assembler.Reassemble(mesh, D, u, Ks, coef, 0.0);
+    diff = MaxDiff(Ks, Weighted(mesh, Coefficients(mesh, D, u)));
+    check(n_dirty == n_touched && n_dirty < n_elems && diff <= 1e-14,
+          "perturbed part, " + std::to_string(n_dirty) + " of " + std::to_string(n_touched) + " touched elements dirty, difference "
+          + sci(diff));
+
+    // with a tolerance the small changes are left out: Ks holds the coefficients kept, each within the tolerance of D(u_e)
+    const double tol = 1e-3;
+    for (int i = 0; i < n; i++) { u(i) += (mesh.Nodes(i).Coords(1) > 0.0 ? 1e-2 : 1e-5)*(1.0 + 0.1*std::sin(0.2*mesh.Nodes(i).Coords(0))); }
+    const std::vector<double> before = coef;
+    const std::vector<double> exact = Coefficients(mesh, D, u);
+    int n_expected = 0;
+    for (int e = 0; e < n_elems; e++) { n_expected += std::abs(exact[e] - before[e]) > tol*std::abs(before[e]); }
+    n_dirty = assembler.Reassemble(mesh, D, u, Ks, coef, tol);
+    bool within = true;
+    for (int e = 0; e < n_elems; e++) { within = within && std::abs(coef[e] - exact[e]) <= tol*std::abs(coef[e]); }
+    diff = MaxDiff(Ks, Weighted(mesh, coef));
+    check(n_dirty == n_expected && n_dirty > 0 && n_dirty < n_elems && within && diff <= 1e-14,
+          "tolerance " + sci(tol) + ", " + std::to_string(n_dirty) + " of " + std::to_string(n_expected)
+          + " expected elements dirty, difference " + sci(diff));
+    return n_failed > 0 ? 1 : 0;
+}
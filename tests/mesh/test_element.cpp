@@ -1,7 +1,34 @@
 #include <fem/fem.h>
 
+#include <cmath>
 #include <iostream>
 
+/**
+ * @brief checks that the rows of the element stiffness sum to zero, as constants are in its null space, and
+ * that the entries of the element mass sum to the measure of the element
+ * @return true if both hold
+ */
+template<typename T>
+bool Check(T &elem, const int &n, const double &measure, const std::string &name)
+{
+    double k_row = 0.0;
+    double m_sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        double k_sum = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            k_sum += elem.k(i,j);
+            m_sum += elem.m(i,j);
+        }
+        k_row = std::max(k_row, std::abs(k_sum));
+    }
+    const bool passed = k_row <= 1e-12 && std::abs(m_sum - measure) <= 1e-12;
+    std::cout << name << ": largest row sum of k " << k_row << ", sum of m " << m_sum << " for measure " << measure << ": "
+              << (passed ? "passed" : "FAILED") << "\n";
+    return passed;
+}
+
 int main()
 {
 
@@ -70,5 +97,54 @@ int main()
         std::cout << "\n";
     }
 
-    return 0;
-}
\ No newline at end of file
+    // unit line, triangle and square of each element type
+    int n_failed = !Check(ll, 2, 1.0, "Linear Line element");
+    n_failed += !Check(lt, 3, 0.5, "Linear Triangle element");
+
+    QuadLine ql;
+    // end points followed by the midpoint
+    ql.Nodes(0).Coords(0) = 0.0;
+    ql.Nodes(1).Coords(0) = 1.0;
+    ql.Nodes(2).Coords(0) = 0.5;
+    ql.BuildElemK();
+    ql.BuildElemM();
+    n_failed += !Check(ql, 3, 1.0, "Quadratic Line element");
+
+    QuadTri qt;
+    // same triangle as above with nodes 3-5 at the edge midpoints
+    qt.Nodes(0).Coords(0) = 0.0; qt.Nodes(0).Coords(1) = 0.0;
+    qt.Nodes(1).Coords(0) = 1.0; qt.Nodes(1).Coords(1) = 0.0;
+    qt.Nodes(2).Coords(0) = 0.0; qt.Nodes(2).Coords(1) = 1.0;
+    qt.Nodes(3).Coords(0) = 0.5; qt.Nodes(3).Coords(1) = 0.0;
+    qt.Nodes(4).Coords(0) = 0.0; qt.Nodes(4).Coords(1) = 0.5;
+    qt.Nodes(5).Coords(0) = 0.5; qt.Nodes(5).Coords(1) = 0.5;
+    qt.BuildElemK();
+    qt.BuildElemM();
+    n_failed += !Check(qt, 6, 0.5, "Quadratic Triangle element");
+
+    LinQuad lq;
+    //  2 _____ 3
+    //   |     |
+    //   |_____|
+    //  0       1
+    lq.Nodes(0).Coords(0) = 0.0; lq.Nodes(0).Coords(1) = 0.0;
+    lq.Nodes(1).Coords(0) = 1.0; lq.Nodes(1).Coords(1) = 0.0;
+    lq.Nodes(2).Coords(0) = 0.0; lq.Nodes(2).Coords(1) = 1.0;
+    lq.Nodes(3).Coords(0) = 1.0; lq.Nodes(3).Coords(1) = 1.0;
+    lq.BuildElemK();
+    lq.BuildElemM();
+    n_failed += !Check(lq, 4, 1.0, "Bilinear Quadrilateral element");
+
+    QuadQuad qq;
+    // the 3x3 grid over the unit square, x running fastest
+    for (int i = 0; i < 9; i++)
+    {
+        qq.Nodes(i).Coords(0) = 0.5*(i % 3);
+        qq.Nodes(i).Coords(1) = 0.5*(i / 3);
+    }
+    qq.BuildElemK();
+    qq.BuildElemM();
+    n_failed += !Check(qq, 9, 1.0, "Biquadratic Quadrilateral element");
+
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+#include <fem/fem.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+
+/** @brief binary gmsh 4.1 output in either byte order and with a size_t of 4 or 8 bytes */
+struct GmshWriter
+{
+    std::ofstream out;
+    bool swap;
+    int size_bytes;
+
+    template<typename T>
+    void Put(const T &value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if (swap) { std::reverse(bytes, bytes + sizeof(T)); }
+        out.write(bytes, sizeof(T));
+    }
+    void PutInt(const int &value) { Put(static_cast<std::int32_t>(value)); }
+    void PutSize(const std::int64_t &value)
+    {
+        if (size_bytes == 8) { Put(static_cast<std::uint64_t>(value)); }
+        else { Put(static_cast<std::uint32_t>(value)); }
+    }
+};
+
+/**
+ * @brief write the comsol mesh as a gmsh file.  vertices are point entities without physical groups, every
+ * boundary index a curve in the physical group index + 10, every domain index a surface without physical
+ * groups.  node tags are 3 n + 7, in two node blocks of which the second has parametric coordinates
+ */
+void WriteGmsh(Mesh &mesh, const std::string &file_name, const bool &swap, const int &size_bytes)
+{
+    GmshWriter w{std::ofstream(file_name, std::ios::binary), swap, size_bytes};
+    auto tag = [](const int &n) { return 3*static_cast<std::int64_t>(n) + 7; };
+    auto &edges = mesh.Block<LinLine>();
+    auto &tris = mesh.Block<LinTri>();
+    std::map<int, std::vector<int>> curves, surfaces;
+    for (int e = 0; e < edges.Size(); e++) { curves[edges.geom_idx[e]].push_back(e); }
+    for (int e = 0; e < tris.Size(); e++) { surfaces[tris.geom_idx[e]].push_back(e); }
+    const int n_vtx = static_cast<int>(mesh.Vertices().size());
+
+    w.out << "$MeshFormat\n4.1 1 " << size_bytes << "\n";
+    w.PutInt(1);
+    w.out << "\n$EndMeshFormat\n$Comments\nwritten by test_gmsh\n$EndComments\n";
+    w.out << "$PhysicalNames\n" << curves.size() << "\n";
+    for (const auto &[g, elems] : curves) { w.out << "1 " << g + 10 << " \"boundary " << g << "\"\n"; }
+    w.out << "$EndPhysicalNames\n$Entities\n";
+    w.PutSize(n_vtx);
+    w.PutSize(curves.size());
+    w.PutSize(surfaces.size());
+    w.PutSize(0);
+    for (int k = 0; k < n_vtx; k++)
+    {
+        w.PutInt(k + 1);
+        for (int j = 0; j < 3; j++) { w.Put(j < 2 ? mesh.Nodes(mesh.Vertices()[k]).Coords(j) : 0.0); }
+        w.PutSize(0);
+    }
+    for (const auto &[g, elems] : curves)
+    {
+        w.PutInt(g + 1);
+        for (int j = 0; j < 6; j++) { w.Put(0.0); }
+        w.PutSize(1);
+        w.PutInt(g + 10);
+        w.PutSize(0);
+    }
+    for (const auto &[g, elems] : surfaces)
+    {
+        w.PutInt(g + 1);
+        for (int j = 0; j < 6; j++) { w.Put(0.0); }
+        w.PutSize(0);
+        w.PutSize(0);
+    }
+
+    const int n = mesh.NumNodes();
+    const int half = n / 2;
+    w.out << "\n$EndEntities\n$Nodes\n";
+    w.PutSize(2);
+    w.PutSize(n);
+    w.PutSize(tag(0));
+    w.PutSize(tag(n - 1));
+    for (const auto &[first, last, parametric] : {std::make_tuple(0, half, 0), std::make_tuple(half, n, 1)})
+    {
+        w.PutInt(parametric ? 1 : 2);
+        w.PutInt(1);
+        w.PutInt(parametric);
+        w.PutSize(last - first);
+        for (int k = first; k < last; k++) { w.PutSize(tag(k)); }
+        for (int k = first; k < last; k++)
+        {
+            w.Put(mesh.Nodes(k).Coords(0));
+            w.Put(mesh.Nodes(k).Coords(1));
+            w.Put(0.0);
+            if (parametric) { w.Put(0.5); }
+        }
+    }
+
+    w.out << "\n$EndNodes\n$Elements\n";
+    w.PutSize(n_vtx + curves.size() + surfaces.size());
+    w.PutSize(n_vtx + edges.Size() + tris.Size());
+    w.PutSize(1);
+    w.PutSize(n_vtx + edges.Size() + tris.Size());
+    std::int64_t elem_tag = 1;
+    for (int k = 0; k < n_vtx; k++)
+    {
+        w.PutInt(0);
+        w.PutInt(k + 1);
+        w.PutInt(15);
+        w.PutSize(1);
+        w.PutSize(elem_tag++);
+        w.PutSize(tag(mesh.Vertices()[k]));
+    }
+    auto put_block = [&](auto &block, const int &dim, const int &gmsh_type, const int &g, const std::vector<int> &elems)
+    {
+        w.PutInt(dim);
+        w.PutInt(g + 1);
+        w.PutInt(gmsh_type);
+        w.PutSize(elems.size());
+        for (const int &e : elems)
+        {
+            w.PutSize(elem_tag++);
+            for (int i = 0; i < block.NPE(); i++) { w.PutSize(tag(block.elems[e].Nodes(i).node_id)); }
+        }
+    };
+    for (const auto &[g, elems] : curves) { put_block(edges, 1, 1, g, elems); }
+    for (const auto &[g, elems] : surfaces) { put_block(tris, 2, 2, g, elems); }
+    w.out << "\n$EndElements\n";
+}
+
+/** @brief true if the gmsh mesh has the nodes, elements and entity indices of the comsol one */
+bool Same(Mesh &comsol, Mesh &gmsh)
+{
+    bool same = comsol.NumNodes() == gmsh.NumNodes() && comsol.NumElems() == gmsh.NumElems() && comsol.Dim() == gmsh.Dim();
+    for (int n = 0; same && n < comsol.NumNodes(); n++)
+    {
+        same = comsol.Nodes(n).Coords(0) == gmsh.Nodes(n).Coords(0) && comsol.Nodes(n).Coords(1) == gmsh.Nodes(n).Coords(1);
+    }
+    // elements are grouped by entity in the gmsh file, so they are compared as sets
+    auto elements = [](auto &block, const int &offset)
+    {
+        std::multiset<std::vector<int>> elems;
+        for (int e = 0; e < block.Size(); e++)
+        {
+            std::vector<int> elem{block.geom_idx[e] + offset};
+            for (int i = 0; i < block.NPE(); i++) { elem.push_back(block.elems[e].Nodes(i).node_id); }
+            elems.insert(elem);
+        }
+        return elems;
+    };
+    same = same && elements(comsol.Block<LinTri>(), 1) == elements(gmsh.Block<LinTri>(), 0);
+    same = same && elements(comsol.Block<LinLine>(), 10) == elements(gmsh.Block<LinLine>(), 0);
+    same = same && comsol.Vertices() == gmsh.Vertices();
+    for (std::size_t k = 0; same && k < gmsh.VertexGeomIdx().size(); k++) { same = gmsh.VertexGeomIdx()[k] == static_cast<int>(k) + 1; }
+    return same;
+}
+
+int main()
+{
+    std::string elem_type("LinTri");
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    Mesh comsol;
+    comsol.InitElements(elem_type);
+    comsol.ReadMesh(mesh_file);
+    for (int r = 0; r < 3; r++) { comsol.RefineUniform(); }
+
+    int n_failed = 0;
+    for (const auto &[swap, size_bytes] : {std::make_pair(false, 8), std::make_pair(true, 8), std::make_pair(false, 4), std::make_pair(true, 4)})
+    {
+        const std::string gmsh_file = "circle_" + std::to_string(swap) + "_" + std::to_string(size_bytes) + ".msh";
+        WriteGmsh(comsol, gmsh_file, swap, size_bytes);
+        Mesh gmsh;
+        gmsh.InitElements(elem_type);
+        auto start = std::chrono::steady_clock::now();
+        gmsh.ReadMesh(gmsh_file);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const bool same = Same(comsol, gmsh);
+        n_failed += !same;
+        std::cout << "byte swapped " << swap << ", size_t of " << size_bytes << " bytes: " << gmsh.NumNodes() << " nodes read in "
+                  << ms << " ms, " << (same ? "same as the comsol mesh" : "DIFFERENT from the comsol mesh") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
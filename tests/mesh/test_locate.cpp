@@ -0,0 +1,60 @@
+#include <fem/fem.h>
+
+#include <random>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+
+    Locator locator;
+    locator.Build(mesh);
+
+    // random points over the box around the circle
+    const int n_points = 10000;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-90.0, 90.0);
+    Eigen::MatrixXd points(2, n_points);
+    for (int p = 0; p < n_points; p++) { points(0, p) = dist(gen); points(1, p) = dist(gen); }
+    std::vector<PointLocation> locations = locator.Locate(mesh, points);
+
+    // compare with a linear scan over the elements, using the barycentric coordinates of each triangle
+    auto &block = mesh.Block<LinTri>();
+    int n_inside = 0;
+    int n_mismatch = 0;
+    for (int p = 0; p < n_points; p++)
+    {
+        int found = -1;
+        for (int e = 0; e < block.Size() && found < 0; e++)
+        {
+            Eigen::Matrix2d J;
+            const Eigen::Vector3d &x0 = block.elems[e].Nodes(0).coords;
+            J.col(0) = (block.elems[e].Nodes(1).coords - x0).head<2>();
+            J.col(1) = (block.elems[e].Nodes(2).coords - x0).head<2>();
+            const Eigen::Vector2d xi = J.inverse()*(points.col(p) - x0.head<2>());
+            if (xi.minCoeff() >= -1e-10 && xi.sum() <= 1.0 + 1e-10) { found = e; }
+        }
+        n_inside += (found >= 0);
+        n_mismatch += ((found >= 0) != (locations[p].elem >= 0));
+    }
+    std::cout << "points inside: " << n_inside << ", located differently from linear scan: " << n_mismatch << "\n";
+    int n_failed = (n_inside == 0 || n_mismatch > 0);
+
+    // linear functions are interpolated exactly
+    Eigen::VectorXd u(mesh.NumNodes());
+    for (int n = 0; n < mesh.NumNodes(); n++) { u(n) = 2.0*mesh.Nodes(n).Coords(0) - 3.0*mesh.Nodes(n).Coords(1) + 1.0; }
+    InterpolationMatrix P = locator.Interpolation(mesh, locations);
+    Eigen::VectorXd values = P*u;
+    double max_err = 0.0;
+    for (int p = 0; p < n_points; p++)
+    {
+        if (locations[p].elem < 0) { continue; }
+        max_err = std::max(max_err, std::abs(values(p) - (2.0*points(0, p) - 3.0*points(1, p) + 1.0)));
+    }
+    std::cout << "max interpolation error of a linear function: " << max_err << "\n";
+    n_failed += !(max_err <= 1e-10);
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include <fem/fem.h>
+
+#include <cmath>
+
+/**
+ * @brief prints the size of the mesh, the measure of the domain and the boundary, and whether the updated pattern
+ * matches a rebuilt one
+ * @return true if the pattern matches and the measures are those of the initial mesh
+ */
+bool Check(Mesh &mesh, Assembler &assembler, const double &area, const double &perimeter)
+{
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    Assembler rebuilt;
+    rebuilt.Init(mesh);
+    const SparseMatrix &P = assembler.Pattern();
+    const SparseMatrix &Q = rebuilt.Pattern();
+    bool same = P.nonZeros() == Q.nonZeros();
+    for (int i = 0; same && i < P.nonZeros(); i++) { same = P.innerIndexPtr()[i] == Q.innerIndexPtr()[i]; }
+    for (int i = 0; same && i <= P.outerSize(); i++) { same = P.outerIndexPtr()[i] == Q.outerIndexPtr()[i]; }
+    const bool passed = same && std::abs(M.sum() - area) <= 1e-10*area && std::abs(Mb.sum() - perimeter) <= 1e-10*perimeter;
+    std::cout << "nodes: " << mesh.NumNodes() << ", elements: " << mesh.NumElems()
+              << ", area: " << M.sum() << ", perimeter: " << Mb.sum()
+              << ", pattern matches rebuild: " << same << ": " << (passed ? "passed" : "FAILED") << "\n";
+    return passed;
+}
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+
+    Refiner refiner;
+    refiner.Init(mesh);
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    const double area = M.sum();
+    const double perimeter = Mb.sum();
+    const int n_initial = mesh.NumElems();
+    int n_failed = !Check(mesh, assembler, area, perimeter);
+
+    // refine the elements with a node in the right half of the circle
+    for (int level = 0; level < 3; level++)
+    {
+        auto &block = mesh.Block<LinTri>();
+        std::vector<char> marked(block.Size(), 0);
+        for (int e = 0; e < block.Size(); e++)
+        {
+            for (int i = 0; i < 3; i++) { marked[e] = marked[e] || block.elems[e].Nodes(i).Coords(0) > 0.0; }
+        }
+        assembler.Update(mesh, refiner.Refine(mesh, marked));
+        n_failed += !Check(mesh, assembler, area, perimeter);
+    }
+
+    // coarsen everything back to the initial mesh
+    for (int level = 0; level < 8; level++)
+    {
+        std::vector<char> marked(mesh.NumElems(), 1);
+        MeshChange change = refiner.Coarsen(mesh, marked);
+        if (change.Empty()) { break; }
+        assembler.Update(mesh, change);
+        n_failed += !Check(mesh, assembler, area, perimeter);
+    }
+    const bool restored = mesh.NumElems() == n_initial;
+    n_failed += !restored;
+    std::cout << "coarsened back to the " << n_initial << " initial elements: " << (restored ? "passed" : "FAILED") << "\n";
+    return n_failed > 0 ? 1 : 0;
+}
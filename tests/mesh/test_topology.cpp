@@ -0,0 +1,83 @@
+#include <fem/fem.h>
+
+#include <chrono>
+#include <set>
+
+/**
+ * @brief compares the cached topology of the mesh with a brute force construction from the element nodes
+ * @return true if they match
+ */
+bool Check(Mesh &mesh)
+{
+    auto start = std::chrono::steady_clock::now();
+    const Adjacency &node_elems = mesh.NodeElements();
+    const Adjacency &elem_neighbours = mesh.ElementNeighbours();
+    const Adjacency &node_neighbours = mesh.NodeNeighbours();
+    auto end = std::chrono::steady_clock::now();
+
+    auto &block = mesh.Block<LinTri>();
+    const int n = mesh.NumNodes();
+    std::vector<std::set<int>> elems(n), nodes(n);
+    for (int e = 0; e < block.Size(); e++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            elems[block.elems[e].Nodes(i).node_id].insert(e);
+            for (int j = 0; j < 3; j++) { nodes[block.elems[e].Nodes(i).node_id].insert(block.elems[e].Nodes(j).node_id); }
+        }
+    }
+    bool same = node_elems.Size() == n && node_neighbours.Size() == n && elem_neighbours.Size() == block.Size();
+    for (int v = 0; same && v < n; v++)
+    {
+        same = std::equal(node_elems.Begin(v), node_elems.End(v), elems[v].begin(), elems[v].end())
+            && std::equal(node_neighbours.Begin(v), node_neighbours.End(v), nodes[v].begin(), nodes[v].end());
+    }
+
+    // triangles are neighbours across an edge, so every interior edge is seen from both sides
+    int n_interior = 0;
+    for (int e = 0; same && e < block.Size(); e++)
+    {
+        std::set<int> across;
+        for (int i = 0; i < 3; i++)
+        {
+            const int a = block.elems[e].Nodes(i).node_id;
+            const int b = block.elems[e].Nodes((i + 1) % 3).node_id;
+            for (int f : elems[a])
+            {
+                if (f != e && elems[b].count(f)) { across.insert(f); }
+            }
+        }
+        same = std::equal(elem_neighbours.Begin(e), elem_neighbours.End(e), across.begin(), across.end());
+        n_interior += elem_neighbours.Degree(e);
+    }
+    std::cout << "nodes: " << n << ", elements: " << block.Size() << ", interior edges: " << n_interior / 2
+              << ", node neighbours: " << node_neighbours.index.size() << ", matches brute force: " << same << ", built in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms: " << (same ? "passed" : "FAILED") << "\n";
+    return same;
+}
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    int n_failed = !Check(mesh);
+
+    // the topology follows the mesh through adaptive refinement, coarsening and uniform refinement
+    Refiner refiner;
+    refiner.Init(mesh);
+    for (int round = 0; round < 3; round++)
+    {
+        std::vector<char> marked(mesh.Block<LinTri>().Size(), 0);
+        for (std::size_t e = 0; e < marked.size(); e += 3) { marked[e] = 1; }
+        refiner.Refine(mesh, marked);
+        n_failed += !Check(mesh);
+    }
+    refiner.Coarsen(mesh, std::vector<char>(mesh.Block<LinTri>().Size(), 1));
+    n_failed += !Check(mesh);
+    mesh.RefineUniform();
+    n_failed += !Check(mesh);
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+#include <fem/fem.h>
+
+#include <cmath>
+#include <fstream>
+
+/** @brief condition file of two diffusing species on the circle, adapted every 5 steps of Run */
+void WriteCondition()
+{
+    std::ofstream out("condition");
+    out << "number of dimensions = 2\ntime step = 0.05\nnumber of species = 2\n"
+        << "diffusivity 0 = 5.0\ndiffusivity 1 = 0.5\nelement type = LinTri\nmesh file = ../../../meshes/circle.mphtxt\n"
+        << "dirichlet 0 = 1.0\ndirichlet 3 = 0.5\nrefine fraction = 0.3\ncoarsen fraction = 0.05\nmax refinement level = 3\n"
+        << "adapt interval = 5\n";
+}
+
+/** @brief linear field of species 1 at a node, gentle enough not to hold back the coarsening */
+double Linear(Mesh &mesh, const int &i)
+{
+    return 1.0 + 1e-4*mesh.Nodes(i).Coords(0) - 2e-4*mesh.Nodes(i).Coords(1);
+}
+
+/** @brief a front of width 5 along coordinate axis = 0 in species 0, and the linear field in species 1 */
+Eigen::VectorXd Fields(Mesh &mesh, const int &axis)
+{
+    const int n = mesh.NumNodes();
+    Eigen::VectorXd v(2*n);
+    for (int i = 0; i < n; i++)
+    {
+        v(i) = std::tanh(mesh.Nodes(i).Coords(axis) / 5.0);
+        v(n + i) = Linear(mesh, i);
+    }
+    return v;
+}
+
+/** @brief largest difference of species 1 to the linear field */
+double LinearError(Model &model)
+{
+    Mesh &mesh = model.GetMesh();
+    const int n = mesh.NumNodes();
+    double err = 0.0;
+    for (int i = 0; i < n; i++) { err = std::max(err, std::abs(model.Solution()(n + i) - Linear(mesh, i))); }
+    return err;
+}
+
+/** @brief nodes within 10 of the front along x = 0 and away from the one along y = 0 */
+int FrontNodes(Mesh &mesh)
+{
+    int count = 0;
+    for (int i = 0; i < mesh.NumNodes(); i++)
+    {
+        count += std::abs(mesh.Nodes(i).Coords(0)) < 10.0 && std::abs(mesh.Nodes(i).Coords(1)) > 20.0;
+    }
+    return count;
+}
+
+int main()
+{
+    WriteCondition();
+    int n_failed = 0;
+
+    // the front along x = 0 is refined, and the added nodes interpolate the linear field exactly
+    Model model;
+    Mesh &mesh = model.GetMesh();
+    const int n_initial = mesh.NumNodes();
+    const int front_initial = FrontNodes(mesh);
+    for (int k = 0; k < 3; k++)
+    {
+        model.SetSolution(Fields(mesh, 0));
+        model.Adapt();
+    }
+    double err = LinearError(model);
+    const int front_refined = FrontNodes(mesh);
+    bool passed = mesh.NumNodes() > n_initial && front_refined > 2*front_initial && err <= 1e-12;
+    n_failed += !passed;
+    std::cout << "front refined: " << n_initial << " to " << mesh.NumNodes() << " nodes, " << front_initial << " to "
+              << front_refined << " along the front, linear field error " << err << ": " << (passed ? "passed" : "FAILED") << "\n";
+
+    // the front moves to y = 0, the elements it left are coarsened back
+    for (int k = 0; k < 3; k++)
+    {
+        model.SetSolution(Fields(mesh, 1));
+        model.Adapt();
+    }
+    err = LinearError(model);
+    const int front_coarsened = FrontNodes(mesh);
+    passed = front_coarsened < front_refined && front_coarsened <= 2*front_initial && err <= 1e-12;
+    n_failed += !passed;
+    std::cout << "front moved: " << front_refined << " to " << front_coarsened << " nodes along the old front, linear field error "
+              << err << ": " << (passed ? "passed" : "FAILED") << "\n";
+
+    // Run adapts after every adapt interval steps, as Solve followed by Adapt
+    const int n_steps = 12;
+    Model sequential;
+    sequential.SetSolution(Fields(sequential.GetMesh(), 0));
+    for (int n = 1; n <= n_steps; n++)
+    {
+        sequential.Solve();
+        if (n % 5 == 0) { sequential.Adapt(); }
+    }
+    Model run;
+    run.SetSolution(Fields(run.GetMesh(), 0));
+    run.Run(n_steps);
+    const Eigen::VectorXd &reference = sequential.Solution();
+    const bool same_mesh = run.Solution().size() == reference.size();
+    const double max_diff = same_mesh ? (run.Solution() - reference).cwiseAbs().maxCoeff() : 0.0;
+    passed = same_mesh && reference.size() > 2*n_initial && max_diff <= 1e-12;
+    n_failed += !passed;
+    std::cout << "Run with an adapt interval: " << reference.size() / 2 << " nodes, max difference to Solve and Adapt "
+              << max_diff << ": " << (passed ? "passed" : "FAILED") << "\n";
+    return n_failed > 0 ? 1 : 0;
+}
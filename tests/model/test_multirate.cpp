@@ -0,0 +1,66 @@
+#include <fem/fem.h>
+
+#include <fstream>
+
+/**
+ * @brief condition file of two species on the circle.  species 0 has a solution dependent diffusivity and decays by
+ * itself, species 1 is produced by it, so species 0 does not depend on how species 1 is stepped
+ */
+void WriteCondition(const double &dt, const std::string &extra)
+{
+    std::ofstream out("condition");
+    out.precision(17);
+    out << "number of dimensions = 2\ntime step = " << dt << "\nnumber of species = 2\n"
+        << "diffusivity 0 = 5.0 0.5\ndiffusivity 1 = 0.2\nelement type = LinTri\nmesh file = ../../../meshes/circle.mphtxt\n"
+        << "dirichlet 0 = 1.0\ndirichlet 3 = 0.5\nparameter k = 0.3\nreaction 0 = -k*u0*u0\nreaction 1 = k*u0*u0 - 0.1*u1\n" << extra;
+}
+
+/** @brief largest difference of two solutions relative to the largest value of the first, over the nodes of the species given */
+double MaxDiff(const Eigen::VectorXd &a, const Eigen::VectorXd &b, const int &first, const int &n)
+{
+    return (a.segment(first, n) - b.segment(first, n)).cwiseAbs().maxCoeff() / a.segment(first, n).cwiseAbs().maxCoeff();
+}
+
+int main()
+{
+    const double dt = 0.2;
+    const int n_steps = 20;
+    const int k = 4;
+    int n_failed = 0;
+
+    // one substep for every species is the scheme of Solve
+    {
+        WriteCondition(dt, "");
+        Model single;
+        Model multi;
+        for (int n = 0; n < n_steps; n++)
+        {
+            single.Solve();
+            multi.SolveMultirate();
+        }
+        const int size = static_cast<int>(single.Solution().size());
+        const double diff = MaxDiff(single.Solution(), multi.Solution(), 0, size);
+        const bool passed = diff <= 1e-12;
+        n_failed += !passed;
+        std::cout << "one substep for every species, max difference to Solve " << diff << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+
+    // species 0 with k substeps takes the steps of dt / k
+    {
+        WriteCondition(dt, "substeps 0 = " + std::to_string(k) + "\n");
+        Model multi;
+        for (int n = 0; n < n_steps; n++) { multi.Solve(); }
+        WriteCondition(dt / k, "");
+        Model fine;
+        for (int n = 0; n < k*n_steps; n++) { fine.Solve(); }
+        const int n_nodes = static_cast<int>(fine.Solution().size()) / 2;
+        const double diff = MaxDiff(fine.Solution(), multi.Solution(), 0, n_nodes);
+        // species 1 took steps of dt, so it differs from the fine run by the time step error
+        const double diff_slow = MaxDiff(fine.Solution(), multi.Solution(), n_nodes, n_nodes);
+        const bool passed = diff <= 1e-12 && diff_slow > 1e-6;
+        n_failed += !passed;
+        std::cout << k << " substeps for species 0, max difference to steps of dt / " << k << " " << diff
+                  << ", of species 1 with one substep " << diff_slow << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
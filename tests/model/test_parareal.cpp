@@ -0,0 +1,48 @@
+#include <fem/fem.h>
+
+#include <fstream>
+
+/**
+ * @brief condition file of two reacting species on the refined circle, one with a solution dependent diffusivity.
+ * the fine propagator re-assembles its stiffness in full at the start of a slice where Solve keeps element
+ * coefficients within the reassembly tolerance, so the tolerance is 0 for the two to take the same steps
+ */
+void WriteCondition(const std::string &extra)
+{
+    std::ofstream out("condition");
+    out << "number of dimensions = 2\ntime step = 0.05\nnumber of species = 2\n"
+        << "diffusivity 0 = 5.0\ndiffusivity 1 = 0.5 1.0\nelement type = LinTri\nmesh file = ../../../meshes/circle.mphtxt\n"
+        << "uniform refinements = 1\nreassembly tolerance = 0\ndirichlet 0 = 1.0\ndirichlet 3 = 0.5\nparameter k = 0.2\n"
+        << "reaction 0 = -k*u0*u1\nreaction 1 = k*u0*u1 - 0.1*k*u1\n" << extra;
+}
+
+int main()
+{
+    const int n_first = 3;
+    const int n_steps = 40;
+    const int n_slices = 4;
+    int n_failed = 0;
+
+    // the sequential reference, n_first steps to start from a state that is not the initial one, then n_steps
+    WriteCondition("");
+    Model sequential;
+    for (int n = 0; n < n_first + n_steps; n++) { sequential.Solve(); }
+    const Eigen::VectorXd &reference = sequential.Solution();
+
+    // parareal with as many iterations as slices is the sequential scheme up to round-off
+    WriteCondition("parareal slices = " + std::to_string(n_slices) + "\nparareal coarsening = 5\nparareal iterations = "
+                   + std::to_string(n_slices) + "\nparareal tolerance = 0\n");
+    Model model;
+    for (int n = 0; n < n_first; n++) { model.Solve(); }
+    const int iterations = model.Parareal(n_steps);
+    const double max_diff = (model.Solution() - reference).cwiseAbs().maxCoeff();
+    const bool exact = max_diff <= 1e-12*reference.cwiseAbs().maxCoeff();
+
+    // the diagnostics are numbered as the steps of Solve and Run
+    bool numbered = model.Step() == n_first + n_steps && static_cast<int>(model.Diagnostics().size()) == n_slices;
+    for (int j = 0; numbered && j < n_slices; j++) { numbered = model.Diagnostics()[j].step == n_first + (j + 1)*n_steps / n_slices; }
+    n_failed += !exact + !numbered;
+    std::cout << "parareal: " << iterations << " iterations, max difference to " << n_steps << " steps of Solve " << max_diff
+              << (exact ? "" : " ABOVE ROUND-OFF") << ", diagnostics " << (numbered ? "numbered from the current step" : "NUMBERED WRONG") << "\n";
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+#include <fem/fem.h>
+
+#include <fstream>
+
+/** @brief condition file of two reacting species on the refined circle, one with a solution dependent diffusivity */
+void WriteCondition()
+{
+    std::ofstream out("condition");
+    out << "number of dimensions = 2\ntime step = 0.05\nnumber of species = 2\n"
+        << "diffusivity 0 = 5.0\ndiffusivity 1 = 0.5 1.0\nelement type = LinTri\nmesh file = ../../../meshes/circle.mphtxt\n"
+        << "uniform refinements = 1\ndirichlet 0 = 1.0\ndirichlet 3 = 0.5\nparameter k = 0.2\n"
+        << "reaction 0 = -k*u0*u1\nreaction 1 = k*u0*u1 - 0.1*k*u1\noutput interval = 5\n";
+}
+
+int main()
+{
+    const int n_steps = 30;
+    WriteCondition();
+    int n_failed = 0;
+
+    // more threads than stages in flight, so the loops nested in the stages run in parallel too
+    for (const int &threads : {1, 8})
+    {
+        omp_set_num_threads(threads);
+        Model sequential;
+        for (int n = 0; n < n_steps; n++) { sequential.Solve(); }
+        Model run;
+        run.Run(n_steps);
+
+        const Eigen::VectorXd &reference = sequential.Solution();
+        const double max_diff = (run.Solution() - reference).cwiseAbs().maxCoeff() / reference.cwiseAbs().maxCoeff();
+        bool numbered = run.Step() == n_steps && static_cast<int>(run.Diagnostics().size()) == n_steps / 5 + 1;
+        for (std::size_t k = 0; numbered && k < run.Diagnostics().size(); k++) { numbered = run.Diagnostics()[k].step == 5*static_cast<int>(k); }
+        const bool passed = max_diff <= 1e-12 && numbered;
+        n_failed += !passed;
+        std::cout << threads << " threads: max difference of Run to " << n_steps << " steps of Solve " << max_diff << ", diagnostics "
+                  << (numbered ? "of the output steps" : "NUMBERED WRONG") << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
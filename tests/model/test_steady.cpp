@@ -0,0 +1,100 @@
+#include <fem/fem.h>
+
+#include <fstream>
+
+/** @brief condition file of one species on the circle, zero everywhere to start with */
+void WriteCondition(const std::string &extra)
+{
+    std::ofstream out("condition");
+    out << "number of dimensions = 2\ntime step = 0.1\nnumber of species = 1\nelement type = LinTri\n"
+        << "mesh file = ../../../meshes/circle.mphtxt\n" << extra;
+}
+
+/** @brief steady residual M R(u) - D K u of one species with a constant diffusivity, zero on the dirichlet nodes */
+Eigen::VectorXd Residual(const SparseMatrix &K, const SparseMatrix &M, Constraints &constraints, const double &D,
+                         const Eigen::VectorXd &R, const Eigen::VectorXd &u)
+{
+    Eigen::VectorXd F = M*R - D*(K*u);
+    for (const int &dof : constraints.Dofs()) { F(dof) = 0.0; }
+    return F;
+}
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    const int n = mesh.NumNodes();
+    int n_failed = 0;
+
+    // linear diffusion with dirichlet data on two boundaries: the steady state is the solution of D K u = 0 with
+    // the constraints, which the pseudo-transient iteration reaches once the step is large, in a few iterations
+    {
+        const double D = 2.0;
+        WriteCondition("diffusivity 0 = 2.0\ndirichlet 0 = 1.0\ndirichlet 2 = -0.5\n");
+        Model model;
+        const int iterations = model.SolveSteady();
+
+        Constraints constraints;
+        constraints.AddCondition(0, 1.0);
+        constraints.AddCondition(2, -0.5);
+        constraints.Init(mesh, assembler.Pattern());
+        SparseMatrix A = D*K;
+        constraints.ApplyMatrix(A);
+        Eigen::VectorXd b = Eigen::VectorXd::Zero(n);
+        constraints.ApplyRHS(b);
+        Solver direct;
+        direct.Factorize(A);
+        Eigen::VectorXd exact;
+        direct.Solve(b, exact);
+
+        // the residual of the first iterate, zero with the dirichlet values set, is the reference of the tolerance
+        Eigen::VectorXd u_0 = Eigen::VectorXd::Zero(n);
+        for (std::size_t k = 0; k < constraints.Dofs().size(); k++) { u_0(constraints.Dofs()[k]) = constraints.Values()(k); }
+        const Eigen::VectorXd none = Eigen::VectorXd::Zero(n);
+        const double residual = Residual(K, M, constraints, D, none, model.Solution()).norm() / Residual(K, M, constraints, D, none, u_0).norm();
+        const double error = (model.Solution() - exact).cwiseAbs().maxCoeff();
+        const bool passed = residual <= 1e-8 && error <= 1e-6 && iterations <= 20 && model.SteadyRejections() == 0;
+        n_failed += !passed;
+        std::cout << "linear diffusion: " << iterations << " iterations, relative residual " << residual << ", max error " << error
+                  << ", " << model.SteadyRejections() << " rejected steps: " << (passed ? "passed" : "FAILED") << "\n";
+    }
+
+    // a source balanced by a cubic decay, zero on the boundary.  a first pseudo time step far too large diffuses
+    // the source alone to values where the decay raises the residual by orders of magnitude, so steps are
+    // undone and retried with smaller ones before the iteration gets going
+    {
+        const double D = 0.5;
+        const double s = 1.0;
+        const double k = 0.1;
+        WriteCondition("diffusivity 0 = 0.5\ndirichlet 0 = 0.0\ndirichlet 1 = 0.0\ndirichlet 2 = 0.0\ndirichlet 3 = 0.0\n"
+                       "reaction 0 = 1.0 - 0.1*u0*u0*u0\nsteady initial step = 1e6\nsteady iterations = 200\n");
+        Model model;
+        const int iterations = model.SolveSteady();
+
+        Constraints constraints;
+        for (int g = 0; g < 4; g++) { constraints.AddCondition(g, 0.0); }
+        constraints.Init(mesh, assembler.Pattern());
+        const Eigen::VectorXd &u = model.Solution();
+        const Eigen::VectorXd R = (s - k*u.array().cube()).matrix();
+        const double residual = Residual(K, M, constraints, D, R, u).norm()
+                              / Residual(K, M, constraints, D, Eigen::VectorXd::Constant(n, s), Eigen::VectorXd::Zero(n)).norm();
+
+        // a steady state is left alone by the time steps
+        const Eigen::VectorXd steady = u;
+        for (int step = 0; step < 3; step++) { model.Solve(); }
+        const double change = (model.Solution() - steady).norm() / steady.norm();
+        const bool passed = residual <= 1e-8 && iterations < 200 && model.SteadyRejections() > 0 && change <= 1e-7;
+        n_failed += !passed;
+        std::cout << "source and cubic decay: " << iterations << " iterations, relative residual " << residual << ", "
+                  << model.SteadyRejections() << " rejected steps, change by time steps " << change << ": "
+                  << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+#include <fem/fem.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+int main()
+{
+    // robertson kinetics, rates spanning nine orders of magnitude
+    ReactionSystem rs;
+    rs.SetParameter("k1", 0.04);
+    rs.SetParameter("k2", 1e4);
+    rs.SetParameter("k3", 3e7);
+    rs.SetReaction(0, "-k1*u0 + k2*u1*u2");
+    rs.SetReaction(1, "k1*u0 - k2*u1*u2 - k3*u1*u1");
+    rs.SetReaction(2, "k3*u1*u1");
+    rs.Compile(3);
+
+    // odd node count to exercise the partial last block
+    const int n = 100003;
+    Eigen::VectorXd u(3*n), v(3*n), R(3*n);
+    for (int i = 0; i < n; i++)
+    {
+        u(i)       = 1.0 - 1e-6*(i % 1000);
+        u(n + i)   = 1e-6*(i % 1000);
+        u(2*n + i) = 0.0;
+    }
+    ReactionIntegrator integrator;
+    int n_failed = 0;
+    for (double dt : {1e-3, 1.0, 100.0})
+    {
+        auto start = std::chrono::steady_clock::now();
+        integrator.Step(rs, u.data(), n, dt, v.data());
+        auto end = std::chrono::steady_clock::now();
+        rs.Evaluate(v.data(), n, R.data());
+        const double residual = (v - u - dt*R).cwiseAbs().maxCoeff();
+        double mass = 0.0;
+        for (int i = 0; i < n; i++) { mass = std::max(mass, std::abs(v(i) + v(n + i) + v(2*n + i) - u(i) - u(n + i))); }
+        const bool passed = residual <= 1e-12 && mass <= 1e-12;
+        n_failed += !passed;
+        std::cout << "robertson dt " << dt << ": newton iterations " << integrator.Iterations() << ", split blocks "
+                  << integrator.SplitBlocks() << ", residual " << residual << ", mass error " << mass << ", "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms: " << (passed ? "passed" : "FAILED") << "\n";
+    }
+
+    // the same steps node by node with a dynamic size newton loop, for the throughput of the batched kernels
+    const double dt = 1.0;
+    auto start = std::chrono::steady_clock::now();
+    Eigen::VectorXd w(3*n);
+    Eigen::VectorXd J(rs.JacobianPattern().size());
+    for (int i = 0; i < n; i++)
+    {
+        Eigen::Vector3d u_i(u(i), u(n + i), u(2*n + i)), v_i = u_i, r_i;
+        for (int it = 0; it < 30; it++)
+        {
+            rs.Evaluate(v_i.data(), 1, r_i.data(), J.data());
+            Eigen::MatrixXd A = Eigen::MatrixXd::Identity(3, 3);
+            for (std::size_t k = 0; k < rs.JacobianPattern().size(); k++)
+            {
+                A(rs.JacobianPattern()[k].first, rs.JacobianPattern()[k].second) -= dt*J(k);
+            }
+            const Eigen::VectorXd d = A.partialPivLu().solve(v_i - u_i - dt*r_i);
+            v_i -= d;
+            if (d.cwiseAbs().maxCoeff() <= 1e-10*(1.0 + v_i.cwiseAbs().maxCoeff())) { break; }
+        }
+        w(i) = v_i(0);
+        w(n + i) = v_i(1);
+        w(2*n + i) = v_i(2);
+    }
+    auto end = std::chrono::steady_clock::now();
+    integrator.Step(rs, u.data(), n, dt, v.data());
+    const double node_diff = (v - w).cwiseAbs().maxCoeff();
+    n_failed += !(node_diff <= 1e-12);
+    std::cout << "node by node: " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms, difference " << node_diff << ": " << (node_diff <= 1e-12 ? "passed" : "FAILED") << "\n";
+
+    // single species with a closed form step, v = u - dt k v^2
+    ReactionSystem logistic;
+    logistic.SetReaction(0, "-50*u0*u0");
+    logistic.Compile(1);
+    Eigen::VectorXd u1 = Eigen::VectorXd::LinSpaced(1000, 0.0, 10.0), v1(1000);
+    integrator.Step(logistic, u1.data(), 1000, 0.1, v1.data());
+    const Eigen::VectorXd exact = ((1.0 + 4.0*0.1*50.0*u1.array()).sqrt() - 1.0) / (2.0*0.1*50.0);
+    const double decay_err = (v1 - exact).cwiseAbs().maxCoeff();
+    n_failed += !(decay_err <= 1e-12);
+    std::cout << "quadratic decay error: " << decay_err << ": " << (decay_err <= 1e-12 ? "passed" : "FAILED") << "\n";
+
+    // a stiff linear chain of seven species runs the dynamic size kernels, against a dense solve
+    ReactionSystem chain;
+    chain.SetReaction(0, "-u0");
+    for (int s = 1; s < 7; s++)
+    {
+        const std::string prev = std::to_string(std::pow(10.0, s - 1)) + "*u" + std::to_string(s - 1);
+        const std::string self = std::to_string(std::pow(10.0, s)) + "*u" + std::to_string(s);
+        chain.SetReaction(s, prev + " - " + self);
+    }
+    chain.Compile(7);
+    const int m = 50;
+    Eigen::VectorXd u7 = Eigen::VectorXd::Random(7*m).cwiseAbs(), v7(7*m);
+    integrator.Step(chain, u7.data(), m, 0.5, v7.data());
+    Eigen::MatrixXd A = Eigen::MatrixXd::Identity(7, 7);
+    for (int s = 0; s < 7; s++)
+    {
+        A(s, s) += 0.5*std::pow(10.0, s);
+        if (s > 0) { A(s, s - 1) -= 0.5*std::pow(10.0, s - 1); }
+    }
+    double chain_err = 0.0;
+    for (int i = 0; i < m; i++)
+    {
+        Eigen::VectorXd x(7), y(7);
+        for (int s = 0; s < 7; s++) { x(s) = u7(s*m + i); y(s) = v7(s*m + i); }
+        chain_err = std::max(chain_err, (A.lu().solve(x) - y).cwiseAbs().maxCoeff());
+    }
+    n_failed += !(chain_err <= 1e-12);
+    std::cout << "linear chain error: " << chain_err << ": " << (chain_err <= 1e-12 ? "passed" : "FAILED") << "\n";
+
+    // v = u + dt v^3 has no solution for u > 2 / sqrt(27 dt), blocks with such nodes fail with every split
+    ReactionSystem blowup;
+    blowup.SetReaction(0, "u0*u0*u0");
+    blowup.Compile(1);
+    ReactionIntegrator coarse(1e-10, 30, 2);
+    Eigen::VectorXd u_b = Eigen::VectorXd::LinSpaced(64, 0.0, 10.0), v_b(64);
+    coarse.Step(blowup, u_b.data(), 64, 1.0, v_b.data());
+    n_failed += !v_b.allFinite();
+    std::cout << "failed blocks stay finite: " << (v_b.allFinite() ? "passed" : "FAILED") << "\n";
+
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#include <fem/fem.h>
+
+#include <iostream>
+#include <cmath>
+
+int main()
+{
+    // u0 + u1 <-> u2 with a saturating source of u0
+    ReactionSystem rs;
+    rs.SetParameter("k1", 2.0);
+    rs.SetParameter("k2", 0.5);
+    rs.SetReaction(0, "-k1*u0*u1 + k2*u2 + exp(-u0)");
+    rs.SetReaction(1, "-k1*u0*u1 + k2*u2");
+    rs.SetReaction(2, "k1*u0*u1 - k2*u2");
+    rs.Compile(3);
+
+    // species values in SoA layout.  odd node count to exercise the partial last block
+    const int n = 37;
+    Eigen::VectorXd u(3*n);
+    for (int i = 0; i < n; i++)
+    {
+        u(i)       = 0.1 + 0.01*i;
+        u(n + i)   = 1.0 - 0.02*i;
+        u(2*n + i) = 0.5;
+    }
+    Eigen::VectorXd R(3*n);
+    Eigen::VectorXd J(rs.JacobianPattern().size()*n);
+    rs.Evaluate(u.data(), n, R.data(), J.data());
+
+    // compare against the hand written reactions and a finite difference jacobian
+    double r_err = 0.0;
+    double j_err = 0.0;
+    const double h = 1e-6;
+    Eigen::VectorXd Rh(3*n);
+    for (std::size_t k = 0; k < rs.JacobianPattern().size(); k++)
+    {
+        const auto [r, s] = rs.JacobianPattern()[k];
+        Eigen::VectorXd uh = u;
+        uh.segment(s*n, n).array() += h;
+        rs.Evaluate(uh.data(), n, Rh.data());
+        for (int i = 0; i < n; i++)
+        {
+            double fd = (Rh(r*n + i) - R(r*n + i)) / h;
+            j_err = std::max(j_err, std::abs(fd - J(k*n + i)));
+        }
+    }
+    for (int i = 0; i < n; i++)
+    {
+        double rate = -2.0*u(i)*u(n + i) + 0.5*u(2*n + i);
+        r_err = std::max(r_err, std::abs(R(i) - rate - std::exp(-u(i))));
+        r_err = std::max(r_err, std::abs(R(n + i) - rate));
+        r_err = std::max(r_err, std::abs(R(2*n + i) + rate));
+    }
+
+    // the finite differences are first order in h
+    const bool r_passed = r_err <= 1e-14;
+    const bool j_passed = rs.JacobianPattern().size() == 9 && j_err <= 10.0*h;
+    std::cout << "jacobian entries: " << rs.JacobianPattern().size() << "\n";
+    std::cout << "max reaction error: " << r_err << ": " << (r_passed ? "passed" : "FAILED") << "\n";
+    std::cout << "max jacobian error (finite difference): " << j_err << ": " << (j_passed ? "passed" : "FAILED") << "\n";
+
+    return (r_passed && j_passed) ? 0 : 1;
+}
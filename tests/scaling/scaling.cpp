@@ -0,0 +1,254 @@
+#include <fem/fem.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * strong and weak scaling of the Model pipeline on generated square meshes, with a regression gate.
+ *
+ *   scaling [--threads 1,2,4] [--size 160] [--weak-size 80] [--steps 5] [--repeats 3] [--solver CG]
+ *           [--baseline file] [--tolerance 0.25] [--min-ms 2] [--update]
+ *
+ * every phase (setup: read the condition and mesh, pattern and assembly; assemble: GlobalAssembly;
+ * solve: the time steps; write: one solution file) is timed for every thread count, the best of the
+ * repeats.  strong scaling keeps size x size cells, weak scaling grows the mesh with the threads from
+ * weak-size x weak-size cells for one thread.  the times are compared with the baseline file, and the
+ * run fails if a phase is slower than the baseline by more than the tolerance (and min-ms).  --update
+ * writes the baseline from this run instead, it is the only way the baseline is written, the build runs
+ * it as the scaling_update target.  without a baseline the run exits with skip_code, which ctest reports
+ * as skipped unless the build requires a baseline.
+ */
+
+static const char* phases[] = {"setup", "assemble", "solve", "write"};
+static constexpr int n_phases = 4;
+static constexpr int skip_code = 77; /** @brief exit code of a run without a baseline to compare with */
+
+/** @brief times of the phases of one run, in ms */
+struct Timing
+{
+    int threads = 1;
+    int n_nodes = 0;
+    double ms[n_phases] = {0.0, 0.0, 0.0, 0.0};
+};
+
+/** @brief write a LinTri mesh of the unit square, n x n cells cut in two, in comsol format.  the sides are boundary entities 0 to 3 */
+void WriteSquare(const std::string &file_name, const int &n)
+{
+    std::ofstream out(file_name);
+    const int n_nodes = (n + 1)*(n + 1);
+    auto id = [n](const int &i, const int &j) { return j*(n + 1) + i; };
+    out << "2 # sdim\n" << n_nodes << " # number of mesh vertices\n0 # lowest mesh vertex index\n\n# Mesh vertex coordinates\n";
+    out.precision(17);
+    for (int j = 0; j <= n; j++)
+    {
+        for (int i = 0; i <= n; i++) { out << static_cast<double>(i) / n << " " << static_cast<double>(j) / n << "\n"; }
+    }
+
+    out << "\n3 vtx # type name\n\n1 # number of vertices per element\n4 # number of elements\n# Elements\n";
+    out << id(0, 0) << "\n" << id(n, 0) << "\n" << id(n, n) << "\n" << id(0, n) << "\n";
+    out << "\n4 # number of geometric entity indices\n# Geometric entity indices\n0\n1\n2\n3\n";
+
+    out << "\n3 edg # type name\n\n2 # number of vertices per element\n" << 4*n << " # number of elements\n# Elements\n";
+    for (int k = 0; k < n; k++) { out << id(k, 0) << " " << id(k + 1, 0) << "\n"; }
+    for (int k = 0; k < n; k++) { out << id(n, k) << " " << id(n, k + 1) << "\n"; }
+    for (int k = 0; k < n; k++) { out << id(k + 1, n) << " " << id(k, n) << "\n"; }
+    for (int k = 0; k < n; k++) { out << id(0, k + 1) << " " << id(0, k) << "\n"; }
+    out << "\n" << 4*n << " # number of geometric entity indices\n# Geometric entity indices\n";
+    for (int side = 0; side < 4; side++)
+    {
+        for (int k = 0; k < n; k++) { out << side << "\n"; }
+    }
+
+    out << "\n3 tri # type name\n\n3 # number of vertices per element\n" << 2*n*n << " # number of elements\n# Elements\n";
+    for (int j = 0; j < n; j++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            out << id(i, j) << " " << id(i + 1, j) << " " << id(i + 1, j + 1) << "\n";
+            out << id(i, j) << " " << id(i + 1, j + 1) << " " << id(i, j + 1) << "\n";
+        }
+    }
+    out << "\n" << 2*n*n << " # number of geometric entity indices\n# Geometric entity indices\n";
+    for (int e = 0; e < 2*n*n; e++) { out << "1\n"; }
+}
+
+/** @brief run the pipeline on an n x n square with a number of threads, best of the repeats */
+Timing Measure(const int &n, const int &threads, const int &steps, const int &repeats, const std::string &solver)
+{
+    const std::string dir = "scaling_" + std::to_string(n);
+    mkdir(dir.c_str(), 0755);
+    mkdir((dir + "/out").c_str(), 0755);
+    WriteSquare(dir + "/square.mphtxt", n);
+    {
+        std::ofstream condition(dir + "/condition");
+        condition << "number of dimensions = 2\ntime step = 1e-3\nnumber of species = 2\n"
+                  << "diffusivity 0 = 1.0\ndiffusivity 1 = 0.1 1.0\nelement type = LinTri\nmesh file = square.mphtxt\n"
+                  << "linear solver = " << solver << "\ndirichlet 0 = 1.0\ndirichlet 2 = 0.0\n"
+                  << "parameter k = 2.0\nreaction 0 = -k*u0*u1\nreaction 1 = k*u0*u1\noutput file = out/sol\n";
+    }
+    char cwd[4096];
+    Assert(getcwd(cwd, sizeof(cwd)) != nullptr, "could not get the working directory");
+    Assert(chdir(dir.c_str()) == 0, "could not enter %s", dir.c_str());
+    omp_set_num_threads(threads);
+
+    Timing timing;
+    timing.threads = threads;
+    for (double &ms : timing.ms) { ms = 1e300; }
+    auto elapsed = [](const std::chrono::steady_clock::time_point &start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    for (int r = 0; r < repeats; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Model model;
+        timing.ms[0] = std::min(timing.ms[0], elapsed(start));
+        start = std::chrono::steady_clock::now();
+        model.GlobalAssembly();
+        timing.ms[1] = std::min(timing.ms[1], elapsed(start));
+        start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; step++) { model.Solve(); }
+        timing.ms[2] = std::min(timing.ms[2], elapsed(start));
+        // a run without steps writes the current solution once
+        start = std::chrono::steady_clock::now();
+        model.Run(0);
+        timing.ms[3] = std::min(timing.ms[3], elapsed(start));
+    }
+    timing.n_nodes = (n + 1)*(n + 1);
+    Assert(chdir(cwd) == 0, "could not return to %s", cwd);
+    return timing;
+}
+
+/** @brief print a scaling table.  efficiency is t_1 / (p t_p) for strong scaling and t_1 / t_p for weak scaling */
+void Print(const std::string &title, const std::vector<Timing> &timings, const bool &weak)
+{
+    std::cout << "\n" << title << "\n" << std::setw(8) << "threads" << std::setw(10) << "nodes";
+    for (const char *phase : phases) { std::cout << std::setw(12) << (std::string(phase) + " ms"); }
+    std::cout << std::setw(12) << "speedup" << std::setw(12) << "efficiency" << "\n";
+    const Timing &first = timings.front();
+    auto total = [](const Timing &t) { double sum = 0.0; for (const double &ms : t.ms) { sum += ms; } return sum; };
+    for (const Timing &t : timings)
+    {
+        std::cout << std::setw(8) << t.threads << std::setw(10) << t.n_nodes << std::fixed << std::setprecision(2);
+        for (const double &ms : t.ms) { std::cout << std::setw(12) << ms; }
+        const double ratio = total(first) / total(t);
+        const double p = static_cast<double>(t.threads) / first.threads;
+        std::cout << std::setw(12) << (weak ? ratio*p : ratio) << std::setw(12) << (weak ? ratio : ratio / p) << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> threads;
+    int size = 160;
+    int weak_size = 80;
+    int steps = 5;
+    int repeats = 3;
+    std::string solver = "CG";
+    std::string baseline_file = "scaling_baseline.txt";
+    double tolerance = 0.25;
+    double min_ms = 2.0;
+    bool update = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (arg == "--threads")
+        {
+            std::istringstream iss(value);
+            for (std::string t; std::getline(iss, t, ','); ) { threads.push_back(std::stoi(t)); }
+            i++;
+        }
+        else if (arg == "--size") { size = std::stoi(value); i++; }
+        else if (arg == "--weak-size") { weak_size = std::stoi(value); i++; }
+        else if (arg == "--steps") { steps = std::stoi(value); i++; }
+        else if (arg == "--repeats") { repeats = std::stoi(value); i++; }
+        else if (arg == "--solver") { solver = value; i++; }
+        else if (arg == "--baseline") { baseline_file = value; i++; }
+        else if (arg == "--tolerance") { tolerance = std::stod(value); i++; }
+        else if (arg == "--min-ms") { min_ms = std::stod(value); i++; }
+        else if (arg == "--update") { update = true; }
+        else
+        {
+            FATAL("unknown argument %s", arg.c_str());
+            return 2;
+        }
+    }
+    // 1, 2, 4, ... up to the processors, and the processors themselves
+    if (threads.empty())
+    {
+        const int max_threads = omp_get_num_procs();
+        for (int p = 1; p < max_threads; p *= 2) { threads.push_back(p); }
+        threads.push_back(max_threads);
+    }
+    // checked before the measurements, which take minutes
+    std::ifstream in(baseline_file);
+    if (!update && !in)
+    {
+        std::cout << "no baseline " << baseline_file << " to compare with, write one with --update\n";
+        return skip_code;
+    }
+
+    std::vector<Timing> strong, weak;
+    for (const int &p : threads) { strong.push_back(Measure(size, p, steps, repeats, solver)); }
+    for (const int &p : threads)
+    {
+        // cells grow with the threads, so the work per thread stays the same
+        const int n = static_cast<int>(std::lround(weak_size*std::sqrt(static_cast<double>(p))));
+        weak.push_back(Measure(n, p, steps, repeats, solver));
+    }
+    Print("strong scaling, " + std::to_string(size) + " x " + std::to_string(size) + " cells", strong, false);
+    Print("weak scaling, " + std::to_string(weak_size) + " x " + std::to_string(weak_size) + " cells per thread", weak, true);
+
+    // baseline lines are "<strong|weak> <threads> <phase> <ms>"
+    std::map<std::string, double> current;
+    for (const auto &[kind, timings] : {std::make_pair(std::string("strong"), &strong), std::make_pair(std::string("weak"), &weak)})
+    {
+        for (const Timing &t : *timings)
+        {
+            for (int k = 0; k < n_phases; k++) { current[kind + " " + std::to_string(t.threads) + " " + phases[k]] = t.ms[k]; }
+        }
+    }
+    if (update)
+    {
+        std::ofstream out(baseline_file);
+        for (const auto &[key, ms] : current) { out << key << " " << ms << "\n"; }
+        std::cout << "\nbaseline written to " << baseline_file << "\n";
+        return 0;
+    }
+    int n_regressed = 0;
+    int n_compared = 0;
+    std::cout << "\ncomparison with " << baseline_file << ", tolerance " << tolerance*100.0 << "%\n";
+    for (std::string line; std::getline(in, line); )
+    {
+        std::istringstream iss(line);
+        std::string kind, phase;
+        int p;
+        double base;
+        if (!(iss >> kind >> p >> phase >> base)) { continue; }
+        const std::string key = kind + " " + std::to_string(p) + " " + phase;
+        auto it = current.find(key);
+        if (it == current.end()) { continue; }
+        n_compared++;
+        const double ms = it->second;
+        const bool regressed = ms > base*(1.0 + tolerance) && ms - base > min_ms;
+        n_regressed += regressed;
+        std::cout << std::setw(28) << std::left << key << std::right << std::fixed << std::setprecision(2) << std::setw(12) << base
+                  << std::setw(12) << ms << std::setw(10) << (ms / base - 1.0)*100.0 << "%" << (regressed ? "  REGRESSED" : "") << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    std::cout << n_regressed << " of " << n_compared << " phases regressed\n";
+    return n_regressed > 0 ? 1 : 0;
+}
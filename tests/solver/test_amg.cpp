@@ -0,0 +1,58 @@
+#include <fem/fem.h>
+
+#include <chrono>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    Refiner refiner;
+    refiner.Init(mesh);
+
+    // the iterations of the multigrid preconditioned cg should not grow with the mesh, those of jacobi cg do
+    int n_failed = 0;
+    for (int level = 0; level <= 4; level++)
+    {
+        if (level > 0)
+        {
+            // two rounds of bisection halve the mesh size
+            for (int round = 0; round < 2; round++)
+            {
+                std::vector<char> marked(mesh.Block<LinTri>().Size(), 1);
+                refiner.Refine(mesh, marked);
+            }
+        }
+
+        Assembler assembler;
+        assembler.Init(mesh);
+        SparseMatrix K, M, Mb;
+        assembler.Assemble(mesh, K, M, Mb);
+        const int n = mesh.NumNodes();
+        SparseMatrix A = M + 100.0*K;
+        Eigen::VectorXd f(n);
+        for (int i = 0; i < n; i++) { f(i) = std::sin(0.1*mesh.Nodes(i).Coords(0))*std::cos(0.07*mesh.Nodes(i).Coords(1)); }
+        const Eigen::VectorXd b = M*f;
+
+        std::cout << "nodes: " << n;
+        bool passed = true;
+        for (SolverType type : {SolverType::CG, SolverType::AMG})
+        {
+            Solver solver(type);
+            Eigen::VectorXd u = Eigen::VectorXd::Zero(n);
+            auto start = std::chrono::steady_clock::now();
+            solver.Factorize(A);
+            solver.Solve(b, u);
+            auto end = std::chrono::steady_clock::now();
+            const double residual = (A*u - b).norm() / b.norm();
+            passed = passed && residual <= 1e-10 && (type == SolverType::CG || solver.Iterations() <= 40);
+            std::cout << (type == SolverType::CG ? ", jacobi cg: " : ", amg cg: ") << solver.Iterations() << " iterations, residual "
+                      << residual << ", " << std::chrono::duration<double>(end - start).count() << " s";
+        }
+        n_failed += !passed;
+        std::cout << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
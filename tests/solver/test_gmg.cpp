@@ -0,0 +1,60 @@
+#include <fem/fem.h>
+
+#include <chrono>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+
+    Solver solver(SolverType::GMG);
+    Multigrid &multigrid = solver.GetMultigrid();
+    multigrid.AddLevel(mesh, MeshChange());
+    int n_failed = 0;
+    for (int level = 1; level <= 5; level++)
+    {
+        const MeshChange change = mesh.RefineUniform();
+        multigrid.AddLevel(mesh, change);
+
+        Assembler assembler;
+        assembler.Init(mesh);
+        SparseMatrix K, M, Mb;
+        assembler.Assemble(mesh, K, M, Mb);
+        const int n = mesh.NumNodes();
+        const double beta = 100.0;
+        SparseMatrix A = M + beta*K;
+
+        // the matrix-free operator of the finest level matches the assembled one
+        multigrid.SetOperator(1.0, beta);
+        multigrid.SetConstraints({});
+        Eigen::VectorXd x = Eigen::VectorXd::Random(n);
+        Eigen::VectorXd y;
+        multigrid.Multiply(multigrid.NumLevels() - 1, x, y);
+        const double op_err = (y - A*x).norm() / (A*x).norm();
+
+        Eigen::VectorXd f(n);
+        for (int i = 0; i < n; i++) { f(i) = std::sin(0.1*mesh.Nodes(i).Coords(0))*std::cos(0.07*mesh.Nodes(i).Coords(1)); }
+        const Eigen::VectorXd b = M*f;
+        std::cout << "nodes: " << n << ", area: " << M.sum() << ", perimeter: " << Mb.sum() << ", operator error: " << op_err;
+        // both multigrids keep the iterations bounded as the mesh is refined
+        bool passed = op_err <= 1e-12;
+        for (SolverType type : {SolverType::AMG, SolverType::GMG})
+        {
+            solver.SetType(type);
+            Eigen::VectorXd u = Eigen::VectorXd::Zero(n);
+            auto start = std::chrono::steady_clock::now();
+            solver.Factorize(A);
+            solver.Solve(b, u);
+            auto end = std::chrono::steady_clock::now();
+            passed = passed && (A*u - b).norm() <= 1e-10*b.norm() && solver.Iterations() <= 40;
+            std::cout << (type == SolverType::AMG ? ", amg cg: " : ", gmg cg: ") << solver.Iterations() << " iterations, "
+                      << std::chrono::duration<double>(end - start).count() << " s";
+        }
+        n_failed += !passed;
+        std::cout << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#include <fem/fem.h>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+
+    Constraints constraints;
+    constraints.AddCondition(0, 1.0);
+    constraints.AddCondition(3, 0.5);
+    MemoryTracker memory;
+    std::size_t finest_factor = 0;
+    int n_failed = 0;
+    for (int level = 0; level <= 3; level++)
+    {
+        if (level > 0) { mesh.RefineUniform(); }
+        Assembler assembler;
+        assembler.Init(mesh);
+        SparseMatrix K, M, Mb;
+        assembler.Assemble(mesh, K, M, Mb);
+        constraints.Init(mesh, assembler.Pattern());
+        const int n = mesh.NumNodes();
+        const double beta = 10.0;
+
+        // the symbolic analysis predicts the factor of the direct solver exactly
+        Solver direct;
+        SparseMatrix A = M + beta*K;
+        constraints.ApplyMatrix(A);
+        direct.Factorize(A);
+        const std::size_t predicted = CholeskyNonZeros(assembler.Pattern());
+        const std::size_t factor_bytes = direct.MemoryBytes(MemoryUse::Factorization);
+
+        Eigen::VectorXd f(n);
+        for (int i = 0; i < n; i++) { f(i) = std::sin(0.1*mesh.Nodes(i).Coords(0))*std::cos(0.07*mesh.Nodes(i).Coords(1)); }
+        Eigen::VectorXd b = M*f;
+        constraints.ApplyRHS(b);
+        Eigen::VectorXd u_direct;
+        direct.Solve(b, u_direct);
+
+        // the matrix-free solve matches it without a system matrix, with the lift taken from M and K
+        Solver matrix_free(SolverType::MatrixFree);
+        Multigrid &multigrid = matrix_free.GetMultigrid();
+        multigrid.AddLevel(mesh, MeshChange());
+        multigrid.SetConstraints(constraints.Dofs());
+        multigrid.SetOperator(1.0, beta);
+        Constraints lifted = constraints;
+        lifted.SetLift(M, 1.0, K, beta);
+        matrix_free.Factorize();
+        b = M*f;
+        lifted.ApplyRHS(b);
+        Eigen::VectorXd u_free = Eigen::VectorXd::Zero(n);
+        matrix_free.Solve(b, u_free);
+        const double error = (u_free - u_direct).norm() / u_direct.norm();
+
+        memory.Set(MemoryUse::Mesh, mesh.MemoryBytes(MemoryUse::Mesh));
+        memory.Set(MemoryUse::Geometry, mesh.MemoryBytes(MemoryUse::Geometry) + matrix_free.MemoryBytes(MemoryUse::Geometry));
+        memory.Set(MemoryUse::Matrices, assembler.MemoryBytes() + Bytes(K) + Bytes(M) + Bytes(Mb) + Bytes(A));
+        memory.Set(MemoryUse::Factorization, factor_bytes);
+        memory.Set(MemoryUse::Krylov, matrix_free.MemoryBytes(MemoryUse::Krylov));
+
+        // the matrix-free backend holds no matrix, only the bytes of its empty containers
+        const std::size_t free_bytes = matrix_free.MemoryBytes(MemoryUse::Matrices) + matrix_free.MemoryBytes(MemoryUse::Factorization);
+        const std::size_t factor_predicted = predicted*(sizeof(double) + sizeof(int)) + (n + 1)*sizeof(int) + n*(sizeof(double) + 4*sizeof(int));
+        const bool passed = error <= 1e-10 && free_bytes < 1024 && factor_bytes == factor_predicted;
+        n_failed += !passed;
+        finest_factor = factor_bytes;
+        std::cout << "nodes: " << n << ", predicted factor nonzeros: " << predicted << ", factor: " << factor_bytes / 1024
+                  << " kB, matrix-free: " << matrix_free.Iterations() << " iterations, " << free_bytes
+                  << " bytes of matrices, error " << error << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    // the peaks are those of the finest mesh
+    memory.Set(MemoryUse::Factorization, 0);
+    memory.Report();
+    const bool peaks = memory.Peak(MemoryUse::Factorization) == finest_factor && memory.Current(MemoryUse::Factorization) == 0;
+    n_failed += !peaks;
+    std::cout << "peak factorization: " << memory.Peak(MemoryUse::Factorization) / 1024 << " kB, current: "
+              << memory.Current(MemoryUse::Factorization) << ": " << (peaks ? "passed" : "FAILED") << "\n";
+    return n_failed > 0 ? 1 : 0;
+}
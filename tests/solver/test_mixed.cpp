@@ -0,0 +1,56 @@
+#include <fem/fem.h>
+
+#include <chrono>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    for (int level = 0; level < 4; level++) { mesh.RefineUniform(); }
+
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    const int n = mesh.NumNodes();
+    const SparseMatrix A = M + 10.0*K;
+
+    // single precision sell product against eigen
+    SellMatrix sell(A);
+    sell.EnableSingle();
+    const Eigen::VectorXf x = Eigen::VectorXf::Random(n);
+    Eigen::VectorXf y(n);
+    sell.Multiply(x.data(), y.data());
+    const Eigen::VectorXd y_ref = A*x.cast<double>();
+    const double sell_err = (y.cast<double>() - y_ref).norm() / y_ref.norm();
+    int n_failed = !(sell_err <= 1e-6);
+    std::cout << "nodes: " << n << ", single precision sell error: " << sell_err << ": " << (sell_err <= 1e-6 ? "passed" : "FAILED") << "\n";
+
+    // the same solves in double and in mixed precision, the residuals should match
+    Eigen::VectorXd f(n);
+    for (int i = 0; i < n; i++) { f(i) = std::sin(0.1*mesh.Nodes(i).Coords(0))*std::cos(0.07*mesh.Nodes(i).Coords(1)); }
+    const Eigen::VectorXd b = M*f;
+    for (SolverType type : {SolverType::Cholesky, SolverType::CG, SolverType::AMG})
+    {
+        for (bool mixed : {false, true})
+        {
+            Solver solver(type);
+            solver.SetMixedPrecision(mixed);
+            Eigen::VectorXd u = Eigen::VectorXd::Zero(n);
+            auto start = std::chrono::steady_clock::now();
+            solver.Factorize(A);
+            solver.Solve(b, u);
+            auto end = std::chrono::steady_clock::now();
+            const char *name = (type == SolverType::Cholesky) ? "cholesky" : (type == SolverType::CG) ? "jacobi cg" : "amg cg";
+            const double residual = (A*u - b).norm() / b.norm();
+            n_failed += !(residual <= 1e-10);
+            std::cout << name << (mixed ? " mixed" : " double") << ": " << solver.Iterations() << " iterations, residual "
+                      << residual << ", " << std::chrono::duration<double>(end - start).count() << " s: "
+                      << (residual <= 1e-10 ? "passed" : "FAILED") << "\n";
+        }
+    }
+    return n_failed > 0 ? 1 : 0;
+}
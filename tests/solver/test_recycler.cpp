@@ -0,0 +1,61 @@
+#include <fem/fem.h>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    Refiner refiner;
+    refiner.Init(mesh);
+    for (int round = 0; round < 4; round++)
+    {
+        std::vector<char> marked(mesh.Block<LinTri>().Size(), 1);
+        refiner.Refine(mesh, marked);
+    }
+
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    const int n = mesh.NumNodes();
+    const double dt = 0.5;
+    const SparseMatrix A = M + dt*K;
+
+    // implicit euler steps with a slowly moving source, the same sequence of systems with a growing recycled space
+    int n_failed = 0;
+    int plain_iterations = 0;
+    for (int vectors : {0, 2, 4, 8})
+    {
+        Solver solver(SolverType::AMG);
+        solver.Factorize(A);
+        Recycler recycler(vectors);
+        Eigen::VectorXd u = Eigen::VectorXd::Zero(n);
+        Eigen::VectorXd f(n);
+        int iterations = 0;
+        double residual = 0.0;
+        for (int step = 1; step <= 40; step++)
+        {
+            const double x0 = 40.0*std::cos(0.02*step);
+            const double y0 = 40.0*std::sin(0.02*step);
+            for (int i = 0; i < n; i++)
+            {
+                const double dx = mesh.Nodes(i).Coords(0) - x0;
+                const double dy = mesh.Nodes(i).Coords(1) - y0;
+                f(i) = std::exp(-(dx*dx + dy*dy) / 800.0);
+            }
+            const Eigen::VectorXd b = M*(u + dt*f);
+            solver.Solve(b, u, recycler);
+            iterations += solver.Iterations();
+            residual = std::max(residual, (A*u - b).norm() / b.norm());
+        }
+        // recycling saves iterations over the plain solves
+        if (vectors == 0) { plain_iterations = iterations; }
+        const bool passed = residual <= 1e-10 && (vectors == 0 || iterations < plain_iterations);
+        n_failed += !passed;
+        std::cout << "recycled vectors: " << vectors << ", cg iterations: " << iterations << ", largest residual: " << residual
+                  << ": " << (passed ? "passed" : "FAILED") << "\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+#include <fem/fem.h>
+
+#include <chrono>
+
+/** @brief mean time of a call to f over n calls, in microseconds */
+template<typename F>
+double Time(const F &f, const int &n = 1000)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) { f(); }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / n;
+}
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+
+    Assembler assembler;
+    assembler.Init(mesh);
+    SparseMatrix K, M, Mb;
+    assembler.Assemble(mesh, K, M, Mb);
+    const int n = mesh.NumNodes();
+    const int n_species = 3;
+
+    // sell products against eigen, for one vector and for all species at once
+    SellMatrix sell(K);
+    Eigen::VectorXd X = Eigen::VectorXd::Random(n*n_species);
+    Eigen::VectorXd Y(n*n_species);
+    sell.Multiply(X.data(), Y.data());
+    double err = (Y.head(n) - K*X.head(n)).norm() / (K*X.head(n)).norm();
+    sell.Multiply(X.data(), Y.data(), n_species);
+    for (int s = 0; s < n_species; s++)
+    {
+        err = std::max(err, (Y.segment(s*n, n) - K*X.segment(s*n, n)).norm() / (K*X.segment(s*n, n)).norm());
+    }
+    const double round_trip = (sell.ToEigen() - K).norm();
+    int n_failed = !(err <= 1e-14) + !(round_trip == 0.0);
+    std::cout << "sell: fill " << sell.Fill() << ", relative error " << err << ": " << (err <= 1e-14 ? "passed" : "FAILED") << "\n";
+    std::cout << "sell round trip error: " << round_trip << ": " << (round_trip == 0.0 ? "passed" : "FAILED") << "\n";
+
+    // coupled species numbered node-major, with a dense reaction coupling at every node
+    std::vector<std::pair<int, BlockMatrix>> blocks;
+    std::vector<SparseMatrix> coupled;
+    for (int b : {2, 4})
+    {
+        std::vector<Eigen::Triplet<double>> triplets;
+        for (int c = 0; c < K.outerSize(); c++)
+        {
+            for (SparseMatrix::InnerIterator it(K, c); it; ++it)
+            {
+                for (int s = 0; s < b; s++) { triplets.emplace_back(it.row()*b + s, c*b + s, it.value()); }
+            }
+        }
+        for (int i = 0; i < n; i++)
+        {
+            for (int r = 0; r < b; r++)
+            {
+                for (int s = 0; s < b; s++) { triplets.emplace_back(i*b + r, i*b + s, 0.1*(r + 1) - 0.05*s); }
+            }
+        }
+        SparseMatrix A(n*b, n*b);
+        A.setFromTriplets(triplets.begin(), triplets.end());
+        BlockMatrix bcsr(A, b);
+        Eigen::VectorXd x = Eigen::VectorXd::Random(n*b);
+        Eigen::VectorXd y(n*b);
+        bcsr.Multiply(x.data(), y.data());
+        const double block_err = (y - A*x).norm() / (A*x).norm();
+        const double block_round_trip = (bcsr.ToEigen() - A).norm();
+        bool passed = block_err <= 1e-14 && block_round_trip == 0.0;
+        n_failed += !passed;
+        std::cout << "block csr " << b << "x" << b << ": " << bcsr.NumBlocks() << " blocks, relative error "
+                  << block_err << ", round trip error " << block_round_trip << ": " << (passed ? "passed" : "FAILED") << "\n";
+
+        // one more than a sweep of four, so both a full and a partial group of vectors are covered
+        const int k = 5;
+        Eigen::MatrixXd XB = Eigen::MatrixXd::Random(n*b, k);
+        Eigen::MatrixXd YB(n*b, k);
+        bcsr.Multiply(XB.data(), YB.data(), k);
+        const Eigen::MatrixXd ref = A*XB;
+        const double multi_err = (YB - ref).norm() / ref.norm();
+        passed = multi_err <= 1e-14;
+        n_failed += !passed;
+        std::cout << "block csr " << b << "x" << b << " with " << k << " vectors: relative error " << multi_err << ": "
+                  << (passed ? "passed" : "FAILED") << "\n";
+        blocks.emplace_back(b, bcsr);
+        coupled.push_back(A);
+    }
+
+    // cg on the sell matrix against cholesky
+    SparseMatrix A = M + 0.1*K;
+    Eigen::VectorXd rhs = M*Eigen::VectorXd::Ones(n);
+    Eigen::VectorXd u_chol, u_cg = Eigen::VectorXd::Zero(n);
+    Solver solver(SolverType::Cholesky);
+    solver.Factorize(A);
+    solver.Solve(rhs, u_chol);
+    solver.SetType(SolverType::CG);
+    solver.Factorize(A);
+    solver.Solve(rhs, u_cg);
+    const double cg_diff = (u_cg - u_chol).norm() / u_chol.norm();
+    n_failed += !(cg_diff <= 1e-10);
+    std::cout << "cg vs cholesky relative difference: " << cg_diff << ": " << (cg_diff <= 1e-10 ? "passed" : "FAILED") << "\n";
+
+    // one vector against one vector, then all species in one product against a product per species
+    Eigen::VectorXd x = X.head(n), y(n);
+    std::cout << "spmv time: sell " << Time([&] { sell.Multiply(x.data(), y.data()); }) << " us, eigen "
+              << Time([&] { y.noalias() = K*x; }) << " us\n";
+    std::cout << "spmm time of " << n_species << " vectors: sell " << Time([&] { sell.Multiply(X.data(), Y.data(), n_species); })
+              << " us, eigen " << Time([&]
+              {
+                  for (int s = 0; s < n_species; s++) { Y.segment(s*n, n).noalias() = K*X.segment(s*n, n); }
+              }) << " us\n";
+    for (std::size_t m = 0; m < blocks.size(); m++)
+    {
+        const int b = blocks[m].first;
+        const BlockMatrix &bcsr = blocks[m].second;
+        const SparseMatrix &A = coupled[m];
+        Eigen::VectorXd xb = Eigen::VectorXd::Random(n*b), yb(n*b);
+        std::cout << "spmv time " << b << "x" << b << " blocks: block csr " << Time([&] { bcsr.Multiply(xb.data(), yb.data()); })
+                  << " us, eigen " << Time([&] { yb.noalias() = A*xb; }) << " us\n";
+        Eigen::MatrixXd XB = Eigen::MatrixXd::Random(n*b, n_species), YB(n*b, n_species);
+        std::cout << "spmm time " << b << "x" << b << " blocks of " << n_species << " vectors: block csr "
+                  << Time([&] { bcsr.Multiply(XB.data(), YB.data(), n_species); }) << " us, eigen " << Time([&]
+                  {
+                      for (int s = 0; s < n_species; s++) { YB.col(s).noalias() = A*XB.col(s); }
+                  }) << " us\n";
+    }
+    return n_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+#include <fem/fem.h>
+
+#include <chrono>
+
+int main()
+{
+    Mesh mesh;
+    std::string elem_type("LinTri");
+    mesh.InitElements(elem_type);
+    std::string mesh_file("../../../meshes/circle.mphtxt");
+    mesh.ReadMesh(mesh_file);
+    Refiner refiner;
+    refiner.Init(mesh);
+    for (int round = 0; round < 4; round++)
+    {
+        std::vector<char> marked(mesh.Block<LinTri>().Size(), 1);
+        refiner.Refine(mesh, marked);
+    }
+
+    // the same mesh assembled in full and as the upper triangle.  the scatter maps are kept on the element
+    // blocks, so the full matrices are assembled before the second Init
+    Assembler full, upper;
+    upper.SetSymmetric(true);
+    SparseMatrix K, M, Mb, Ku, Mu, Mbu;
+    full.Init(mesh);
+    full.Assemble(mesh, K, M, Mb);
+    upper.Init(mesh);
+    upper.Assemble(mesh, Ku, Mu, Mbu);
+    const int n = mesh.NumNodes();
+    std::cout << "nodes: " << n << ", stored entries full " << K.nonZeros() << ", upper " << Ku.nonZeros() << "\n";
+    const double upper_err = (SparseMatrix(Ku.selfadjointView<Eigen::Upper>()) - K).norm() / K.norm();
+    int n_failed = !(upper_err <= 1e-14);
+    std::cout << "upper assembly error: " << upper_err << ": " << (upper_err <= 1e-14 ? "passed" : "FAILED") << "\n";
+
+    // symmetric products against eigen, for one vector and for all species at once
+    const int n_species = 3;
+    SymmetricMatrix sym(Ku);
+    SellMatrix sell(K);
+    Eigen::VectorXd X = Eigen::VectorXd::Random(n*n_species);
+    Eigen::VectorXd Y(n*n_species);
+    sym.Multiply(X.data(), Y.data());
+    double err = (Y.head(n) - K*X.head(n)).norm() / (K*X.head(n)).norm();
+    sym.Multiply(X.data(), Y.data(), n_species);
+    for (int s = 0; s < n_species; s++)
+    {
+        err = std::max(err, (Y.segment(s*n, n) - K*X.segment(s*n, n)).norm() / (K*X.segment(s*n, n)).norm());
+    }
+    const double full_err = (SymmetricMatrix(K).ToEigen() - K).norm() / K.norm();
+    const bool products = err <= 1e-14 && full_err <= 1e-14;
+    n_failed += !products;
+    std::cout << "symmetric: " << sym.NumColors() << " colors, relative error " << err
+              << ", from full matrix error " << full_err << ": " << (products ? "passed" : "FAILED") << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; i++) { sym.Multiply(X.data(), Y.data()); }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "symmetric spmv time: " << std::chrono::duration<double, std::micro>(end - start).count() / 200 << " us\n";
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; i++) { sell.Multiply(X.data(), Y.data()); }
+    end = std::chrono::steady_clock::now();
+    std::cout << "sell spmv time: " << std::chrono::duration<double, std::micro>(end - start).count() / 200 << " us\n";
+
+    // every backend on the upper triangle against the full matrix
+    const SparseMatrix A = M + 0.5*K;
+    const SparseMatrix Au = Mu + 0.5*Ku;
+    const Eigen::VectorXd b = M*Eigen::VectorXd::Ones(n);
+    for (SolverType type : {SolverType::Cholesky, SolverType::CG, SolverType::AMG})
+    {
+        for (bool mixed : {false, true})
+        {
+            Solver solver(type), solver_upper(type);
+            solver.SetMixedPrecision(mixed);
+            solver_upper.SetMixedPrecision(mixed);
+            solver_upper.SetSymmetricStorage(true);
+            solver.Factorize(A);
+            solver_upper.Factorize(Au);
+            Eigen::VectorXd u = Eigen::VectorXd::Zero(n), u_upper = Eigen::VectorXd::Zero(n);
+            solver.Solve(b, u);
+            solver_upper.Solve(b, u_upper);
+            const double residual = (A*u_upper - b).norm() / b.norm();
+            const double diff = (u_upper - u).norm() / u.norm();
+            const bool passed = residual <= 1e-10 && diff <= 1e-10;
+            n_failed += !passed;
+            std::cout << "solver " << static_cast<int>(type) << (mixed ? " mixed" : "") << ": residual "
+                      << residual << ", difference to full " << diff << ": " << (passed ? "passed" : "FAILED") << "\n";
+        }
+    }
+    return n_failed > 0 ? 1 : 0;
+}